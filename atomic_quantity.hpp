@@ -0,0 +1,216 @@
+//
+// atomic_quantity.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef ATOMIC_QUANTITY_HPP
+#define ATOMIC_QUANTITY_HPP
+
+#include <atomic>
+#include <type_traits>
+#include "units.hpp"
+
+// Shared totals updated from several threads, such as energy, bytes or
+// volume. The atomic holds the raw number, and every operation takes and
+// returns the quantity type, so only quantities of the same dimension can be
+// added. Integers add with the native fetch_add; floating-point numbers use
+// std::atomic<T>::fetch_add where the standard library has it (C++20) and a
+// compare-and-swap loop otherwise.
+
+namespace detail
+{
+namespace atomics
+{
+	template<typename T>
+	T fetch_add(std::atomic<T>& value, T delta, std::memory_order order, std::true_type)
+	{
+		return value.fetch_add(delta, order);
+	}
+
+	template<typename T>
+	T fetch_add(std::atomic<T>& value, T delta, std::memory_order order, std::false_type)
+	{
+#ifdef __cpp_lib_atomic_float
+		return value.fetch_add(delta, order);
+#else
+		T expected = value.load(std::memory_order_relaxed);
+		while (!value.compare_exchange_weak(expected, expected + delta, order,
+			std::memory_order_relaxed))
+		{
+		}
+		return expected;
+#endif
+	}
+
+	template<typename T>
+	T fetch_add(std::atomic<T>& value, T delta, std::memory_order order)
+	{
+		return fetch_add(value, delta, order, std::is_integral<T>{});
+	}
+
+	template<typename T>
+	T fetch_sub(std::atomic<T>& value, T delta, std::memory_order order, std::true_type)
+	{
+		return value.fetch_sub(delta, order);
+	}
+
+	template<typename T>
+	T fetch_sub(std::atomic<T>& value, T delta, std::memory_order order, std::false_type)
+	{
+		return fetch_add(value, static_cast<T>(-delta), order, std::false_type{});
+	}
+
+	template<typename T>
+	T fetch_sub(std::atomic<T>& value, T delta, std::memory_order order)
+	{
+		return fetch_sub(value, delta, order, std::is_integral<T>{});
+	}
+}
+}
+
+namespace unitscxx
+{
+	template<typename Quantity>
+	class atomic_quantity
+	{
+	public:
+		using value_type = std::remove_cv_t<Quantity>;
+		using numeric_type = typename value_type::numeric_type;
+		using dimension = typename value_type::dimension;
+		using scale = typename value_type::scale;
+
+	private:
+		std::atomic<numeric_type> value;
+
+	public:
+		// Zero, like a default-constructed quantity.
+		atomic_quantity() noexcept : value(numeric_type())
+		{
+		}
+
+		constexpr atomic_quantity(value_type q) noexcept : value(q.raw_value())
+		{
+		}
+
+		atomic_quantity(const atomic_quantity&) = delete;
+		atomic_quantity& operator=(const atomic_quantity&) = delete;
+
+		UNITS_ATTR_NODISCARD bool is_lock_free() const noexcept
+		{
+			return value.is_lock_free();
+		}
+
+		UNITS_ATTR_NODISCARD value_type load(
+			std::memory_order order = std::memory_order_seq_cst) const noexcept
+		{
+			return value_type(value.load(order));
+		}
+
+		void store(value_type q, std::memory_order order = std::memory_order_seq_cst) noexcept
+		{
+			value.store(q.raw_value(), order);
+		}
+
+		value_type exchange(value_type q,
+			std::memory_order order = std::memory_order_seq_cst) noexcept
+		{
+			return value_type(value.exchange(q.raw_value(), order));
+		}
+
+		// On failure, expected receives the current value.
+		bool compare_exchange_weak(value_type& expected, value_type desired,
+			std::memory_order success, std::memory_order failure) noexcept
+		{
+			numeric_type raw = expected.raw_value();
+			bool exchanged = value.compare_exchange_weak(raw, desired.raw_value(),
+				success, failure);
+			expected = value_type(raw);
+			return exchanged;
+		}
+
+		bool compare_exchange_weak(value_type& expected, value_type desired,
+			std::memory_order order = std::memory_order_seq_cst) noexcept
+		{
+			numeric_type raw = expected.raw_value();
+			bool exchanged = value.compare_exchange_weak(raw, desired.raw_value(), order);
+			expected = value_type(raw);
+			return exchanged;
+		}
+
+		bool compare_exchange_strong(value_type& expected, value_type desired,
+			std::memory_order success, std::memory_order failure) noexcept
+		{
+			numeric_type raw = expected.raw_value();
+			bool exchanged = value.compare_exchange_strong(raw, desired.raw_value(),
+				success, failure);
+			expected = value_type(raw);
+			return exchanged;
+		}
+
+		bool compare_exchange_strong(value_type& expected, value_type desired,
+			std::memory_order order = std::memory_order_seq_cst) noexcept
+		{
+			numeric_type raw = expected.raw_value();
+			bool exchanged = value.compare_exchange_strong(raw, desired.raw_value(), order);
+			expected = value_type(raw);
+			return exchanged;
+		}
+
+		value_type fetch_add(value_type delta,
+			std::memory_order order = std::memory_order_seq_cst) noexcept
+		{
+			return value_type(detail::atomics::fetch_add(value, delta.raw_value(), order));
+		}
+
+		value_type fetch_sub(value_type delta,
+			std::memory_order order = std::memory_order_seq_cst) noexcept
+		{
+			return value_type(detail::atomics::fetch_sub(value, delta.raw_value(), order));
+		}
+
+		operator value_type() const noexcept
+		{
+			return load();
+		}
+
+		value_type operator=(value_type q) noexcept
+		{
+			store(q);
+			return q;
+		}
+
+		// Like std::atomic, these return the new value.
+		value_type operator+=(value_type delta) noexcept
+		{
+			return fetch_add(delta) + delta;
+		}
+
+		value_type operator-=(value_type delta) noexcept
+		{
+			return fetch_sub(delta) - delta;
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,174 @@
+//
+// atomic_contention.cpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Measures atomic_quantity and sharded_quantity under contention: every
+// thread adds to one shared total, as workers reporting energy or bytes
+// would. Energy is a double, added with a compare-and-swap loop before C++20;
+// bytes are an int64_t, added with the native fetch_add. Each is next to the
+// same loop on a plain std::atomic, and to a sharded_quantity (compensated,
+// for energy, in the "kahan" column). Lines report millions of additions per
+// second, all threads together, for 1, 2, 4... threads up to the hardware
+// concurrency or the given count.
+//
+//   c++ -std=c++14 -O2 -pthread -I. benchmarks/atomic_contention.cpp -o atomic_contention
+//   ./atomic_contention [max threads] [additions per thread]
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "siunits.hpp"
+#include "atomic_quantity.hpp"
+#include "sharded_quantity.hpp"
+
+using namespace unitscxx;
+
+namespace
+{
+	enum class storage { byte };
+	using joules = std::remove_const_t<decltype(si::J)>;
+	using bytes = unit_base<std::int64_t, storage, storage::byte>;
+
+	// Seconds for threads workers to each run work(additions), started
+	// together.
+	template<typename Work>
+	double run(unsigned threads, size_t additions, Work work)
+	{
+		std::atomic<unsigned> ready(0);
+		std::atomic<bool> go(false);
+		std::vector<std::thread> workers;
+		for (unsigned i = 0; i < threads; ++i)
+		{
+			workers.emplace_back([&] {
+				++ready;
+				while (!go.load(std::memory_order_acquire))
+				{
+				}
+				work(additions);
+			});
+		}
+		while (ready.load() != threads)
+		{
+		}
+		auto start = std::chrono::steady_clock::now();
+		go.store(true, std::memory_order_release);
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+
+	template<typename Work>
+	double best_seconds(unsigned threads, size_t additions, Work work)
+	{
+		double best = 1e300;
+		for (int i = 0; i < 5; ++i)
+		{
+			double seconds = run(threads, additions, work);
+			best = seconds < best ? seconds : best;
+		}
+		return best;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	unsigned hardware = std::thread::hardware_concurrency();
+	unsigned maxThreads = argc > 1 ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10))
+		: (hardware ? hardware : 4);
+	size_t additions = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000;
+
+	atomic_quantity<joules> energy;
+	std::atomic<double> rawEnergy(0);
+	atomic_quantity<bytes> traffic;
+	std::atomic<std::int64_t> rawTraffic(0);
+	sharded_quantity<joules> shardedEnergy;
+	sharded_quantity<joules, true> compensatedEnergy;
+	sharded_quantity<bytes> shardedTraffic;
+	const auto joule = 1.0 * si::J;
+	const bytes packet(1500);
+
+	std::printf("%-10s %8s %8s %8s %8s %8s %8s %8s\n", "Madd/s", "energy", "double",
+		"sharded", "kahan", "bytes", "int64", "sharded");
+	for (unsigned threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		double energySeconds = best_seconds(threads, additions, [&](size_t count) {
+			for (size_t i = 0; i < count; ++i)
+			{
+				energy.fetch_add(joule, std::memory_order_relaxed);
+			}
+		});
+		double doubleSeconds = best_seconds(threads, additions, [&](size_t count) {
+			for (size_t i = 0; i < count; ++i)
+			{
+				double expected = rawEnergy.load(std::memory_order_relaxed);
+				while (!rawEnergy.compare_exchange_weak(expected, expected + 1.0,
+					std::memory_order_relaxed))
+				{
+				}
+			}
+		});
+		double shardedEnergySeconds = best_seconds(threads, additions, [&](size_t count) {
+			for (size_t i = 0; i < count; ++i)
+			{
+				shardedEnergy += joule;
+			}
+		});
+		double compensatedSeconds = best_seconds(threads, additions, [&](size_t count) {
+			for (size_t i = 0; i < count; ++i)
+			{
+				compensatedEnergy += joule;
+			}
+		});
+		double trafficSeconds = best_seconds(threads, additions, [&](size_t count) {
+			for (size_t i = 0; i < count; ++i)
+			{
+				traffic.fetch_add(packet, std::memory_order_relaxed);
+			}
+		});
+		double int64Seconds = best_seconds(threads, additions, [&](size_t count) {
+			for (size_t i = 0; i < count; ++i)
+			{
+				rawTraffic.fetch_add(1500, std::memory_order_relaxed);
+			}
+		});
+		double shardedTrafficSeconds = best_seconds(threads, additions, [&](size_t count) {
+			for (size_t i = 0; i < count; ++i)
+			{
+				shardedTraffic += packet;
+			}
+		});
+		double total = static_cast<double>(threads) * additions / 1e6;
+		std::printf("%2u threads %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f\n", threads,
+			total / energySeconds, total / doubleSeconds, total / shardedEnergySeconds,
+			total / compensatedSeconds, total / trafficSeconds, total / int64Seconds,
+			total / shardedTrafficSeconds);
+	}
+}
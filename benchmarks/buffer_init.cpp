@@ -0,0 +1,162 @@
+//
+// buffer_init.cpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Measures what zero-filling costs for a large buffer that is about to be
+// overwritten: each variant sizes a buffer, copies a source buffer into it
+// the way a read() would, and reads it back. Value-initializing containers
+// write every byte twice; quantity_buffer, quantity_array with for_overwrite
+// and a plain new double[] write it once. The first group allocates fresh
+// memory every time, where page faults hide part of the difference; the
+// second reuses the capacity of a cleared buffer, as a loop reading batches
+// would. Each line reports milliseconds per fill and the fill bandwidth.
+//
+//   c++ -std=c++14 -O2 -I. benchmarks/buffer_init.cpp -o buffer_init
+//   ./buffer_init [elements]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "siunits.hpp"
+#include "quantity_array.hpp"
+#include "quantity_buffer.hpp"
+
+using namespace unitscxx;
+
+namespace
+{
+	using meters = std::remove_const_t<decltype(si::m)>;
+
+	template<typename Function>
+	double best_seconds(Function&& function)
+	{
+		double best = 1e300;
+		for (int run = 0; run < 7; ++run)
+		{
+			auto start = std::chrono::steady_clock::now();
+			function();
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			best = elapsed.count() < best ? elapsed.count() : best;
+		}
+		return best;
+	}
+
+	void report(const char* name, double seconds, size_t count)
+	{
+		std::printf("%-38s %9.2f ms %8.2f GB/s\n", name, seconds * 1e3,
+			count * sizeof(double) / seconds / 1e9);
+	}
+
+	volatile double sink;
+
+	// Reads one element per page so that the copy can't be optimized away.
+	void consume(const double* values, size_t count)
+	{
+		double sum = 0;
+		for (size_t i = 0; i < count; i += 4096 / sizeof(double))
+		{
+			sum += values[i];
+		}
+		sink = sum;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1 << 25;
+	size_t bytes = count * sizeof(double);
+	std::vector<double> source(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		source[i] = static_cast<double>(i);
+	}
+
+	std::printf("fresh allocation\n");
+	report("new double[]", best_seconds([&] {
+		std::unique_ptr<double[]> buffer(new double[count]);
+		std::memcpy(buffer.get(), source.data(), bytes);
+		consume(buffer.get(), count);
+	}), count);
+
+	report("std::vector<double>", best_seconds([&] {
+		std::vector<double> buffer(count);
+		std::memcpy(static_cast<void*>(buffer.data()), source.data(), bytes);
+		consume(buffer.data(), count);
+	}), count);
+
+	report("std::vector<meters>", best_seconds([&] {
+		std::vector<meters> buffer(count);
+		std::memcpy(static_cast<void*>(buffer.data()), source.data(), bytes);
+		consume(reinterpret_cast<const double*>(buffer.data()), count);
+	}), count);
+
+	report("quantity_buffer<meters>", best_seconds([&] {
+		quantity_buffer<meters> buffer(count);
+		std::memcpy(static_cast<void*>(buffer.data()), source.data(), bytes);
+		consume(reinterpret_cast<const double*>(buffer.data()), count);
+	}), count);
+
+	report("quantity_array<meters>", best_seconds([&] {
+		quantity_array<meters> buffer(count);
+		std::memcpy(static_cast<void*>(buffer.data()), source.data(), bytes);
+		consume(buffer.data(), count);
+	}), count);
+
+	report("quantity_array<meters> for_overwrite", best_seconds([&] {
+		quantity_array<meters> buffer(count, for_overwrite);
+		std::memcpy(static_cast<void*>(buffer.data()), source.data(), bytes);
+		consume(buffer.data(), count);
+	}), count);
+
+	std::printf("\nreused capacity\n");
+	std::vector<double> doubles;
+	doubles.reserve(count);
+	report("std::vector<double>", best_seconds([&] {
+		doubles.clear();
+		doubles.resize(count);
+		std::memcpy(doubles.data(), source.data(), bytes);
+		consume(doubles.data(), count);
+	}), count);
+
+	std::vector<meters> quantities;
+	quantities.reserve(count);
+	report("std::vector<meters>", best_seconds([&] {
+		quantities.clear();
+		quantities.resize(count);
+		std::memcpy(static_cast<void*>(quantities.data()), source.data(), bytes);
+		consume(reinterpret_cast<const double*>(quantities.data()), count);
+	}), count);
+
+	quantity_buffer<meters> buffer;
+	buffer.reserve(count);
+	report("quantity_buffer<meters>", best_seconds([&] {
+		buffer.clear();
+		buffer.resize(count);
+		std::memcpy(static_cast<void*>(buffer.data()), source.data(), bytes);
+		consume(reinterpret_cast<const double*>(buffer.data()), count);
+	}), count);
+}
@@ -0,0 +1,175 @@
+//
+// column_load.cpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Time to get a column of quantities from disk into a program: parsing the
+// same numbers from a text file with strtod, next to opening a column file
+// and summing the mapped column where it lies, and reading a column stored
+// in feet as meters (converted in bulk) or one value at a time. The files
+// are written to the current directory and are in the page cache by the
+// time they are read, so this measures the cost of decoding, not the disk.
+//
+//   c++ -std=c++14 -O2 -I. benchmarks/column_load.cpp -o column_load
+//   ./column_load [values]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "siunits.hpp"
+#include "usunits.hpp"
+#include "quantity_column.hpp"
+
+using namespace unitscxx;
+
+namespace
+{
+	using meters = std::remove_const_t<decltype(si::m)>;
+
+	template<typename Function>
+	double seconds(Function&& function)
+	{
+		auto start = std::chrono::steady_clock::now();
+		function();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+
+	void report(const char* name, double time, size_t values, double check)
+	{
+		std::printf("%-36s %8.2f ms %8.1f Mvalues/s   (sum %.6g)\n", name, time * 1e3, values / time / 1e6, check);
+	}
+
+	std::string read_text(const char* path)
+	{
+		std::string text;
+		if (std::FILE* stream = std::fopen(path, "rb"))
+		{
+			char buffer[1 << 16];
+			size_t read;
+			while ((read = std::fread(buffer, 1, sizeof buffer, stream)) != 0)
+			{
+				text.append(buffer, read);
+			}
+			std::fclose(stream);
+		}
+		return text;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 24;
+
+	std::mt19937_64 random(42);
+	std::uniform_real_distribution<double> altitude(0, 12000);
+	std::vector<meters> heights;
+	std::vector<double> feet;
+	std::FILE* text = std::fopen("column_load.txt", "w");
+	for (size_t i = 0; i < count; ++i)
+	{
+		heights.push_back(altitude(random) * si::m);
+		feet.push_back(heights.back().raw_value() / 0.30480061);
+		std::fprintf(text, "%.17g\n", heights.back().raw_value());
+	}
+	std::fclose(text);
+
+	column_file_writer writer;
+	writer.add("height", quantity_span<const meters>(heights));
+	writer.add("height_ft", feet.data(), feet.size(), us::ft);
+	if (writer.write("column_load.ucol") != column_errc::ok)
+	{
+		std::fprintf(stderr, "can't write column_load.ucol\n");
+		return 1;
+	}
+
+	double sum = 0;
+	double time = seconds([&] {
+		std::string contents = read_text("column_load.txt");
+		std::vector<meters> parsed;
+		parsed.reserve(count);
+		const char* cursor = contents.c_str();
+		char* end;
+		for (double value = std::strtod(cursor, &end); end != cursor; value = std::strtod(cursor, &end))
+		{
+			parsed.push_back(value * si::m);
+			cursor = end;
+		}
+		sum = 0;
+		for (meters value : parsed)
+		{
+			sum += value.raw_value();
+		}
+	});
+	report("text, strtod", time, count, sum);
+
+	time = seconds([&] {
+		column_file file;
+		quantity_column<const meters> column;
+		if (file.open("column_load.ucol") == column_errc::ok && file.column("height", column) == column_errc::ok)
+		{
+			sum = 0;
+			for (meters value : column.span())
+			{
+				sum += value.raw_value();
+			}
+		}
+	});
+	report("column file, mapped span", time, count, sum);
+
+	time = seconds([&] {
+		column_file file;
+		quantity_column<const meters> column;
+		if (file.open("column_load.ucol") == column_errc::ok && file.column("height_ft", column) == column_errc::ok)
+		{
+			std::vector<meters> converted(column.size());
+			column.read(0, quantity_span<meters>(converted));
+			sum = 0;
+			for (meters value : converted)
+			{
+				sum += value.raw_value();
+			}
+		}
+	});
+	report("column file, feet, read()", time, count, sum);
+
+	time = seconds([&] {
+		column_file file;
+		quantity_column<const meters> column;
+		if (file.open("column_load.ucol") == column_errc::ok && file.column("height_ft", column) == column_errc::ok)
+		{
+			sum = 0;
+			for (size_t i = 0; i < column.size(); ++i)
+			{
+				sum += column[i].raw_value();
+			}
+		}
+	});
+	report("column file, feet, operator[]", time, count, sum);
+
+	std::remove("column_load.txt");
+	std::remove("column_load.ucol");
+}
@@ -0,0 +1,233 @@
+#!/usr/bin/env python3
+#
+# compile_time.py
+# units-cxx14
+#
+# Copyright (c) 2016 Félix Cloutier
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+
+# Measures what the unit metaprogramming costs the compiler. Each case is
+# generated twice: once with quantities, and once with plain doubles doing the
+# same arithmetic. The script reports compile time, peak compiler memory,
+# template instantiation depth and object size for both.
+#
+#   CXX=clang++ python3 benchmarks/compile_time.py
+#   python3 benchmarks/compile_time.py --json > baseline.json
+#   python3 benchmarks/compile_time.py --baseline baseline.json
+
+import argparse
+import json
+import os
+import shlex
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+HEADER = """\
+#include "units.hpp"
+#include "siunits.hpp"
+#include "usunits.hpp"
+
+using namespace unitscxx;
+"""
+
+# (expression, type) pairs that the generated chains cycle through
+FACTORS = [
+	("si::m", "decltype(si::m)"),
+	("si::s", "decltype(si::s)"),
+	("si::kg", "decltype(si::kg)"),
+	("us::ft", "decltype(us::ft)"),
+	("si::A", "decltype(si::A)"),
+	("us::lb", "decltype(us::lb)"),
+	("si::K", "decltype(si::K)"),
+	("si::mol", "decltype(si::mol)"),
+]
+
+BASES = ["si::m", "si::s", "si::kg", "si::A"]
+
+def chain_source(length, count, plain):
+	# `count` functions, each multiplying or dividing `length` parameters
+	lines = [HEADER]
+	for fn in range(count):
+		params = []
+		expr = ""
+		for i in range(length):
+			unit, unit_type = FACTORS[(fn + i) % len(FACTORS)]
+			params.append("%s a%d" % ("double" if plain else unit_type, i))
+			op = "" if i == 0 else (" * " if (i + fn) % 3 else " / ")
+			expr += "%sa%d" % (op, i)
+		lines.append("auto chain_%d(%s)\n{\n\treturn %s;\n}\n" %
+			(fn, ", ".join(params), expr))
+	return "\n".join(lines)
+
+def distinct_source(count, plain):
+	# `count` functions that each produce a different derived dimension
+	lines = [HEADER]
+	radix = 7 # exponents -3...3
+	for fn in range(count):
+		factors = []
+		n = fn
+		for base in BASES:
+			exponent = n % radix - 3
+			n //= radix
+			op = " * " if exponent >= 0 else " / "
+			for _ in range(abs(exponent)):
+				factors.append((op, "1.0" if plain else base))
+		expr = "x"
+		for op, factor in factors:
+			expr = "(%s%s%s)" % (expr, op, factor)
+		lines.append("auto distinct_%d(double x)\n{\n\treturn %s;\n}\n" %
+			(fn, expr))
+	return "\n".join(lines)
+
+CASES = [
+	("chain10", lambda plain: chain_source(10, 20, plain)),
+	("chain50", lambda plain: chain_source(50, 20, plain)),
+	("chain200", lambda plain: chain_source(200, 5, plain)),
+	("distinct1000", lambda plain: distinct_source(1000, plain)),
+	("distinct2400", lambda plain: distinct_source(2400, plain)),
+]
+
+def compile_once(cxx, flags, source, workdir, extra=()):
+	src = os.path.join(workdir, "tu.cpp")
+	with open(src, "w") as f:
+		f.write(source)
+	cmd = cxx + flags + list(extra) + ["-I", ROOT, "-c", src, "-o", os.devnull]
+	return subprocess.call(cmd, stdout=subprocess.DEVNULL,
+		stderr=subprocess.DEVNULL) == 0
+
+def measure(cxx, flags, source, workdir, depth):
+	# use a dedicated child so that its rusage isn't mixed with earlier runs
+	runner = [sys.executable, "-c",
+		"import resource, subprocess, sys, time\n"
+		"start = time.perf_counter()\n"
+		"code = subprocess.call(sys.argv[1:], stdout=subprocess.DEVNULL,\n"
+		"	stderr=subprocess.DEVNULL)\n"
+		"elapsed = time.perf_counter() - start\n"
+		"rss = resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss\n"
+		"print(code, elapsed, rss)\n"]
+	src = os.path.join(workdir, "tu.cpp")
+	obj = os.path.join(workdir, "tu.o")
+	with open(src, "w") as f:
+		f.write(source)
+	cmd = cxx + flags + ["-I", ROOT, "-c", src, "-o", obj]
+	out = subprocess.check_output(runner + cmd).decode().split()
+	if out[0] != "0":
+		subprocess.call(cmd)
+		raise SystemExit("compilation failed")
+	result = {
+		"seconds": float(out[1]),
+		"peak_kb": int(out[2]) // (1024 if sys.platform == "darwin" else 1),
+		"object_bytes": os.path.getsize(obj),
+	}
+	if depth:
+		result["template_depth"] = min_template_depth(cxx, flags, source,
+			workdir)
+	return result
+
+def min_template_depth(cxx, flags, source, workdir):
+	# smallest -ftemplate-depth that still compiles, found by bisection
+	low, high = 1, 1024
+	while low < high:
+		mid = (low + high) // 2
+		ok = compile_once(cxx, flags + ["-fsyntax-only"], source, workdir,
+			["-ftemplate-depth=%d" % mid])
+		if ok:
+			high = mid
+		else:
+			low = mid + 1
+	return low
+
+def main():
+	parser = argparse.ArgumentParser(
+		description="Compile-time cost of units-cxx14 expressions")
+	parser.add_argument("--cases", default=",".join(c[0] for c in CASES),
+		help="comma-separated list of cases to run")
+	parser.add_argument("--flags", default="-std=c++14 -O2",
+		help="compiler flags (default: %(default)s)")
+	parser.add_argument("--depth", action="store_true",
+		help="also bisect the minimum -ftemplate-depth (slow)")
+	parser.add_argument("--json", action="store_true",
+		help="print results as JSON instead of a table")
+	parser.add_argument("--baseline", metavar="FILE",
+		help="JSON output of an earlier run; fail on regressions")
+	parser.add_argument("--tolerance", type=float, default=0.25,
+		help="allowed relative regression against --baseline")
+	parser.add_argument("--keep", metavar="DIR",
+		help="write the generated translation units to DIR")
+	args = parser.parse_args()
+
+	cxx = shlex.split(os.environ.get("CXX", "c++"))
+	flags = shlex.split(args.flags) + ["-Wno-unknown-pragmas"]
+	wanted = args.cases.split(",")
+	results = {}
+	with tempfile.TemporaryDirectory() as workdir:
+		for name, generate in CASES:
+			if name not in wanted:
+				continue
+			results[name] = {}
+			for variant, plain in (("quantity", False), ("double", True)):
+				source = generate(plain)
+				if args.keep:
+					os.makedirs(args.keep, exist_ok=True)
+					path = os.path.join(args.keep, "%s_%s.cpp" % (name, variant))
+					with open(path, "w") as f:
+						f.write(source)
+				results[name][variant] = measure(cxx, flags, source, workdir,
+					args.depth)
+
+	if args.json:
+		json.dump(results, sys.stdout, indent=2, sort_keys=True)
+		print()
+	else:
+		print("%-14s %-9s %9s %10s %10s %6s" %
+			("case", "variant", "seconds", "peak KB", "object B", "depth"))
+		for name, variants in results.items():
+			for variant, r in variants.items():
+				print("%-14s %-9s %9.3f %10d %10d %6s" % (name, variant,
+					r["seconds"], r["peak_kb"], r["object_bytes"],
+					r.get("template_depth", "-")))
+
+	if args.baseline:
+		with open(args.baseline) as f:
+			baseline = json.load(f)
+		failed = False
+		for name, variants in results.items():
+			old = baseline.get(name, {}).get("quantity")
+			if old is None:
+				continue
+			new = variants["quantity"]
+			# compare against the plain double run to factor out machine noise
+			for key in ("seconds", "peak_kb"):
+				old_ratio = old[key] / baseline[name]["double"][key]
+				new_ratio = new[key] / variants["double"][key]
+				if new_ratio > old_ratio * (1 + args.tolerance):
+					print("regression: %s %s went from %.2fx to %.2fx of plain "
+						"double" % (name, key, old_ratio, new_ratio),
+						file=sys.stderr)
+					failed = True
+		return 1 if failed else 0
+	return 0
+
+if __name__ == "__main__":
+	sys.exit(main())
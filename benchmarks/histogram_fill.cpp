@@ -0,0 +1,194 @@
+//
+// histogram_fill.cpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Fill rate of quantity_histogram, in millions of samples per second, for
+// each kind of binning, next to a plain loop over raw doubles that computes
+// the bin with a division and branches. Pressure readings are normally
+// distributed and a few percent fall outside the range. The last lines fill
+// one histogram with std::atomic counters from several threads.
+//
+//   c++ -std=c++14 -O2 -pthread -I. benchmarks/histogram_fill.cpp -o histogram_fill
+//   ./histogram_fill [samples] [threads]
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+#include "siunits.hpp"
+#include "quantity_histogram.hpp"
+
+using namespace unitscxx;
+
+namespace
+{
+	using pascals = std::remove_const_t<decltype(si::Pa)>;
+	constexpr size_t buffer_size = 1 << 16;
+
+	template<typename Function>
+	double seconds(Function&& function)
+	{
+		auto start = std::chrono::steady_clock::now();
+		function();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+
+	void report(const char* name, double time, size_t samples, std::uint64_t check)
+	{
+		std::printf("%-36s %8.1f Msamples/s   (%llu counted)\n", name, samples / time / 1e6,
+			static_cast<unsigned long long>(check));
+	}
+
+	// What binning code on raw numbers usually looks like.
+	std::vector<std::uint64_t> naive(const std::vector<double>& values, size_t repeats,
+		double low, double high, size_t bins)
+	{
+		std::vector<std::uint64_t> counts(bins + 2);
+		double width = (high - low) / bins;
+		for (size_t r = 0; r < repeats; ++r)
+		{
+			for (double value : values)
+			{
+				if (value < low)
+				{
+					++counts[0];
+				}
+				else if (value >= high || std::isnan(value))
+				{
+					++counts[bins + 1];
+				}
+				else
+				{
+					++counts[std::min(size_t((value - low) / width), bins - 1) + 1];
+				}
+			}
+		}
+		return counts;
+	}
+
+	template<typename Histogram>
+	void bulk(const char* name, Histogram histogram, const std::vector<pascals>& values, size_t repeats)
+	{
+		double time = seconds([&] {
+			for (size_t r = 0; r < repeats; ++r)
+			{
+				histogram.fill(values);
+			}
+		});
+		report(name, time, values.size() * repeats, histogram.total());
+	}
+
+	template<typename Histogram>
+	void each(const char* name, Histogram histogram, const std::vector<pascals>& values, size_t repeats)
+	{
+		double time = seconds([&] {
+			for (size_t r = 0; r < repeats; ++r)
+			{
+				for (pascals value : values)
+				{
+					histogram.fill(value);
+				}
+			}
+		});
+		report(name, time, values.size() * repeats, histogram.total());
+	}
+
+	void shared(unsigned threads, const std::vector<pascals>& edges, const std::vector<pascals>& values,
+		size_t repeats)
+	{
+		quantity_histogram<pascals, std::atomic<std::uint64_t>> histogram(edges);
+		double time = seconds([&] {
+			std::vector<std::thread> workers;
+			for (unsigned t = 0; t < threads; ++t)
+			{
+				workers.emplace_back([&] {
+					for (size_t r = 0; r < repeats; ++r)
+					{
+						histogram.fill(values);
+					}
+				});
+			}
+			for (auto& worker : workers)
+			{
+				worker.join();
+			}
+		});
+		char name[64];
+		std::snprintf(name, sizeof name, "atomic counters, %u thread%s", threads, threads == 1 ? "" : "s");
+		report(name, time, values.size() * repeats * threads, histogram.total());
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t samples = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 27;
+	unsigned threads = argc > 2 ? unsigned(std::atoi(argv[2])) : std::max(1u, std::thread::hardware_concurrency());
+	size_t repeats = (samples + buffer_size - 1) / buffer_size;
+
+	std::mt19937_64 random(42);
+	std::normal_distribution<double> pressure(101325, 1000);
+	std::vector<double> raw;
+	std::vector<pascals> values;
+	for (size_t i = 0; i < buffer_size; ++i)
+	{
+		raw.push_back(pressure(random));
+		values.push_back(raw.back() * si::Pa);
+	}
+
+	const double low = 99000;
+	const double high = 103000;
+	const size_t bins = 100;
+	std::vector<pascals> edges;
+	for (size_t i = 0; i <= bins; ++i)
+	{
+		edges.push_back((low + (high - low) * i * i / (bins * bins)) * si::Pa);
+	}
+
+	std::vector<std::uint64_t> counts;
+	double time = seconds([&] { counts = naive(raw, repeats, low, high, bins); });
+	std::uint64_t total = 0;
+	for (auto count : counts)
+	{
+		total += count;
+	}
+	report("raw doubles, branches", time, buffer_size * repeats, total);
+
+	auto linear = quantity_histogram<pascals>::linear(low * si::Pa, high * si::Pa, bins);
+	each("linear, one at a time", linear, values, repeats);
+	bulk("linear, fill(span)", linear, values, repeats);
+	bulk("logarithmic, fill(span)", quantity_histogram<pascals>::logarithmic(low * si::Pa, high * si::Pa, bins),
+		values, repeats);
+	bulk("101 edges, fill(span)", quantity_histogram<pascals>(edges), values, repeats);
+
+	for (unsigned t = 1; t <= threads; t *= 2)
+	{
+		shared(t, edges, values, repeats / t);
+	}
+}
@@ -0,0 +1,121 @@
+//
+// parallel_scaling.cpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Measures how the algorithms of quantity_parallel.hpp scale with threads,
+// on quantity_arrays of lengths: a transform (a * 2), a reduce, a dot product
+// with transform_reduce (in square meters), the same dot product with
+// par_deterministic, and an inclusive_scan. Each line reports milliseconds
+// for one thread count and the speedup over one thread in parentheses.
+// Thread counts go up to the size of the pool, which is the number of cores
+// unless UNITSCXX_PARALLEL_THREADS is defined.
+//
+//   c++ -std=c++14 -O2 -pthread -I. benchmarks/parallel_scaling.cpp -o parallel_scaling
+//   ./parallel_scaling [elements]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "siunits.hpp"
+#include "quantity_array.hpp"
+#include "quantity_parallel.hpp"
+
+using namespace unitscxx;
+
+namespace
+{
+	using meters = std::remove_const_t<decltype(si::m)>;
+
+	volatile double sink;
+
+	template<typename Function>
+	double best_seconds(Function&& function)
+	{
+		double best = 1e300;
+		for (int run = 0; run < 7; ++run)
+		{
+			auto start = std::chrono::steady_clock::now();
+			function();
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			best = elapsed.count() < best ? elapsed.count() : best;
+		}
+		return best;
+	}
+
+	void print(double seconds, double single)
+	{
+		std::printf(" %8.2f (%4.1fx)", seconds * 1e3, single / seconds);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1 << 23;
+	std::mt19937_64 random(42);
+	std::uniform_real_distribution<double> values(0, 1);
+	quantity_array<meters> a(count, for_overwrite), b(count, for_overwrite);
+	quantity_array<meters> out(count, for_overwrite);
+	for (size_t i = 0; i < count; ++i)
+	{
+		a[i] = values(random) * si::m;
+		b[i] = values(random) * si::m;
+	}
+
+	unsigned pool = static_cast<unsigned>(detail::threading::thread_pool::instance().size());
+	std::printf("%-8s %16s %16s %16s %16s %16s\n", "threads", "transform", "reduce",
+		"dot", "dot determ.", "scan");
+	std::vector<unsigned> threadCounts;
+	for (unsigned threads = 1; threads < pool; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(pool);
+
+	double single[5] = {};
+	for (unsigned threads : threadCounts)
+	{
+		parallel::execution how{threads, false};
+		parallel::execution deterministic{threads, true};
+		double seconds[5] = {
+			best_seconds([&] {
+				parallel::transform(how, a, out, [](meters x) { return 2 * x; });
+			}),
+			best_seconds([&] { sink = parallel::reduce(how, a).raw_value(); }),
+			best_seconds([&] { sink = parallel::transform_reduce(how, a, b).raw_value(); }),
+			best_seconds([&] {
+				sink = parallel::transform_reduce(deterministic, a, b).raw_value();
+			}),
+			best_seconds([&] { parallel::inclusive_scan(how, a, out); }),
+		};
+		std::printf("%-8u", threads);
+		for (int i = 0; i < 5; ++i)
+		{
+			single[i] = threads == 1 ? seconds[i] : single[i];
+			print(seconds[i], single[i]);
+		}
+		std::printf("\n");
+	}
+}
@@ -0,0 +1,138 @@
+//
+// parse_throughput.cpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Measures how fast parse_lines turns "value unit" text into quantities.
+// Each data set is parsed into a quantity_array, and the same text is also
+// parsed with strtod alone (skipping the units), which is the cost of the
+// numbers without any unit handling.
+//
+//   c++ -std=c++14 -O2 -I. benchmarks/parse_throughput.cpp -o parse_throughput
+//   ./parse_throughput [lines]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include "quantity_parse.hpp"
+
+using namespace unitscxx;
+
+namespace
+{
+	struct data_set
+	{
+		const char* name;
+		const char* units[3];
+	};
+
+	std::string generate(const data_set& set, size_t lines, bool mixed)
+	{
+		std::mt19937_64 random(42);
+		std::uniform_real_distribution<double> values(-1e4, 1e4);
+		std::string text;
+		char line[64];
+		for (size_t i = 0; i < lines; ++i)
+		{
+			const char* unit = set.units[mixed ? random() % 3 : 0];
+			int length = std::snprintf(line, sizeof line, "%.6g %s\n", values(random), unit);
+			text.append(line, static_cast<size_t>(length));
+		}
+		return text;
+	}
+
+	template<typename Function>
+	double best_seconds(Function&& function)
+	{
+		double best = 1e300;
+		for (int run = 0; run < 5; ++run)
+		{
+			auto start = std::chrono::steady_clock::now();
+			function();
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			best = elapsed.count() < best ? elapsed.count() : best;
+		}
+		return best;
+	}
+
+	double strtod_lines(const std::string& text)
+	{
+		double sum = 0;
+		const char* p = text.c_str();
+		while (*p != 0)
+		{
+			char* end;
+			sum += std::strtod(p, &end);
+			p = end;
+			while (*p != 0 && *p++ != '\n')
+			{
+			}
+		}
+		return sum;
+	}
+
+	template<typename Quantity>
+	void run(const data_set& set, size_t lines, bool mixed)
+	{
+		std::string text = generate(set, lines, mixed);
+		quantity_array<Quantity> out(lines, for_overwrite);
+		parse_lines_result result{};
+		double parse = best_seconds([&] {
+			result = parse_lines(text.data(), text.data() + text.size(), out);
+		});
+		if (result.ec != parse_errc::ok || result.count != lines)
+		{
+			std::fprintf(stderr, "%s: parse error %d after %zu lines\n",
+				set.name, static_cast<int>(result.ec), result.count);
+			std::exit(1);
+		}
+
+		volatile double sink = 0;
+		double baseline = best_seconds([&] { sink = strtod_lines(text); });
+		(void)sink;
+
+		double megabytes = text.size() / 1e6;
+		std::printf("%-8s %-6s %9.1f MB/s %8.1f Mlines/s   strtod %8.1f MB/s   ratio %.2f\n",
+			set.name, mixed ? "mixed" : "single",
+			megabytes / parse, lines / parse / 1e6,
+			megabytes / baseline, parse / baseline);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t lines = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000000;
+
+	data_set speeds = {"speed", {"m/s", "ft/s", "km/s"}};
+	data_set forces = {"force", {"kg*m/s^2", "kN", "lb*ft/s²"}};
+	data_set lengths = {"length", {"ft", "m", "mi"}};
+
+	for (bool mixed : {false, true})
+	{
+		run<decltype(si::m / si::s)>(speeds, lines, mixed);
+		run<decltype(si::N)::var>(forces, lines, mixed);
+		run<decltype(si::m)::var>(lengths, lines, mixed);
+	}
+}
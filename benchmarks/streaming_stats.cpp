@@ -0,0 +1,167 @@
+//
+// streaming_stats.cpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Throughput of quantity_stats and quantity_digest over a stream of
+// log-normal latencies, adding one value at a time and whole buffers with
+// add(span), and the accuracy of the digest's quantiles, also after merging
+// eight shards. The stream is a buffer of 64Ki values added over and over, so
+// the exact quantiles are those of the buffer. Quantile errors are in rank:
+// 1e-4 at the p99 means that the estimate is somewhere between the p98.99 and
+// the p99.01.
+//
+//   c++ -std=c++14 -O2 -I. benchmarks/streaming_stats.cpp -o streaming_stats
+//   ./streaming_stats [elements]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "siunits.hpp"
+#include "quantity_stats.hpp"
+
+using namespace unitscxx;
+
+namespace
+{
+	using seconds_type = std::remove_const_t<decltype(si::s)>;
+	constexpr size_t buffer_size = 1 << 16;
+	constexpr size_t shards = 8;
+	const double quantiles[] = {0.5, 0.9, 0.99, 0.999, 0.9999};
+
+	struct stream
+	{
+		std::vector<seconds_type> values;
+		std::vector<double> sorted;
+		size_t repeats;
+	};
+
+	template<typename Function>
+	double seconds(Function&& function)
+	{
+		auto start = std::chrono::steady_clock::now();
+		function();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+
+	void report(const char* name, double time, const stream& s)
+	{
+		std::printf("%-34s %8.3f ns/element\n", name, time / (s.values.size() * s.repeats) * 1e9);
+	}
+
+	void report_quantiles(const char* name, const quantity_digest<seconds_type>& digest, const stream& s)
+	{
+		std::printf("%-34s", name);
+		for (double q : quantiles)
+		{
+			double estimate = digest.quantile(q).raw_value();
+			auto rank = std::lower_bound(s.sorted.begin(), s.sorted.end(), estimate) - s.sorted.begin();
+			std::printf("  p%-6g %8.1e", q * 100, double(rank) / s.sorted.size() - q);
+		}
+		std::printf("\n");
+	}
+
+	template<typename Accumulator>
+	Accumulator each(const char* name, const stream& s)
+	{
+		Accumulator accumulator;
+		double time = seconds([&] {
+			for (size_t r = 0; r < s.repeats; ++r)
+			{
+				for (seconds_type value : s.values)
+				{
+					accumulator += value;
+				}
+			}
+		});
+		report(name, time, s);
+		return accumulator;
+	}
+
+	template<typename Accumulator>
+	Accumulator bulk(const char* name, const stream& s)
+	{
+		Accumulator accumulator;
+		double time = seconds([&] {
+			for (size_t r = 0; r < s.repeats; ++r)
+			{
+				accumulator.add(s.values);
+			}
+		});
+		report(name, time, s);
+		return accumulator;
+	}
+
+	// Each shard sees a slice of every buffer, as if requests were spread
+	// over several threads, and the shards are merged at the end.
+	quantity_digest<seconds_type> sharded(const stream& s)
+	{
+		std::vector<quantity_digest<seconds_type>> digests(shards);
+		size_t slice = s.values.size() / shards;
+		for (size_t r = 0; r < s.repeats; ++r)
+		{
+			for (size_t shard = 0; shard < shards; ++shard)
+			{
+				digests[shard].add(quantity_span<const seconds_type>(s.values.data() + shard * slice, slice));
+			}
+		}
+		quantity_digest<seconds_type> merged;
+		for (const auto& digest : digests)
+		{
+			merged += digest;
+		}
+		return merged;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 26;
+	std::mt19937_64 random(42);
+	std::lognormal_distribution<double> latency(-7, 1);
+	stream s;
+	s.repeats = (count + buffer_size - 1) / buffer_size;
+	for (size_t i = 0; i < buffer_size; ++i)
+	{
+		s.values.push_back(latency(random) * si::s);
+		s.sorted.push_back(s.values.back().raw_value());
+	}
+	std::sort(s.sorted.begin(), s.sorted.end());
+
+	auto stats = each<quantity_stats<seconds_type>>("quantity_stats, one at a time", s);
+	auto bulkStats = bulk<quantity_stats<seconds_type>>("quantity_stats, add(span)", s);
+	std::printf("  mean %.6g s, stddev %.6g s / %.6g s, min %.6g s, max %.6g s\n",
+		bulkStats.mean().raw_value(), stats.stddev().raw_value(), bulkStats.stddev().raw_value(),
+		bulkStats.min().raw_value(), bulkStats.max().raw_value());
+
+	auto digest = each<quantity_digest<seconds_type>>("quantity_digest, one at a time", s);
+	bulk<quantity_digest<seconds_type>>("quantity_digest, add(span)", s);
+	std::printf("\nquantile error in rank\n");
+	report_quantiles("quantity_digest", digest, s);
+	report_quantiles("8 merged shards", sharded(s), s);
+}
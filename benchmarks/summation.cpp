@@ -0,0 +1,142 @@
+//
+// summation.cpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Compares the accuracy and speed of the quantity_sum methods with operator+=
+// on a plain quantity, over a long stream of small energy increments. The
+// stream is a buffer of 64Ki values that stays in cache, added over and over;
+// every value is a multiple of 2^-52, so the exact total is known from an
+// integer sum. Each line reports nanoseconds per element and the error
+// relative to that total.
+//
+//   c++ -std=c++14 -O2 -I. benchmarks/summation.cpp -o summation
+//   ./summation [elements]
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "siunits.hpp"
+#include "quantity_sum.hpp"
+
+using namespace unitscxx;
+
+namespace
+{
+	using joules = std::remove_const_t<decltype(si::J)>;
+	constexpr size_t buffer_size = 1 << 16;
+
+	struct stream
+	{
+		std::vector<joules> values;
+		size_t repeats;
+		double exact;
+	};
+
+	template<typename Function>
+	double seconds(Function&& function)
+	{
+		auto start = std::chrono::steady_clock::now();
+		function();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+
+	void report(const char* name, double time, joules total, const stream& s)
+	{
+		std::printf("%-30s %8.3f ns/element   error %9.2e\n", name,
+			time / (s.values.size() * s.repeats) * 1e9,
+			std::abs(total.raw_value() - s.exact) / s.exact);
+	}
+
+	joules total(joules sum)
+	{
+		return sum;
+	}
+
+	template<typename Method>
+	joules total(const quantity_sum<joules, Method>& sum)
+	{
+		return sum.value();
+	}
+
+	// One value at a time, as a loop over a stream of readings would.
+	template<typename Sum>
+	void each(const char* name, const stream& s)
+	{
+		Sum sum{};
+		double time = seconds([&] {
+			for (size_t r = 0; r < s.repeats; ++r)
+			{
+				for (joules value : s.values)
+				{
+					sum += value;
+				}
+			}
+		});
+		report(name, time, total(sum), s);
+	}
+
+	template<typename Sum>
+	void bulk(const char* name, const stream& s)
+	{
+		Sum sum{};
+		double time = seconds([&] {
+			for (size_t r = 0; r < s.repeats; ++r)
+			{
+				sum.add(s.values);
+			}
+		});
+		report(name, time, sum.value(), s);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 28;
+	std::mt19937_64 random(42);
+	stream s;
+	s.values.resize(buffer_size);
+	s.repeats = (count + buffer_size - 1) / buffer_size;
+	__int128 exact = 0;
+	for (joules& value : s.values)
+	{
+		std::int64_t mantissa = static_cast<std::int64_t>(random() >> 12) | 1;
+		exact += mantissa;
+		value = std::ldexp(static_cast<double>(mantissa), -52) * si::J;
+	}
+	exact *= s.repeats;
+	s.exact = static_cast<double>(std::ldexp(static_cast<long double>(exact), -52));
+
+	each<joules>("operator+= on a quantity", s);
+	each<quantity_sum<joules, summation::neumaier>>("neumaier, one at a time", s);
+	each<quantity_sum<joules, summation::pairwise>>("pairwise, one at a time", s);
+	each<quantity_sum<joules, summation::kahan_lanes<>>>("kahan_lanes, one at a time", s);
+	bulk<quantity_sum<joules, summation::neumaier>>("neumaier, add(span)", s);
+	bulk<quantity_sum<joules, summation::pairwise>>("pairwise, add(span)", s);
+	bulk<quantity_sum<joules, summation::kahan_lanes<>>>("kahan_lanes, add(span)", s);
+}
@@ -0,0 +1,301 @@
+//
+// wire_loopback.cpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Quantities sent over a local socket pair, between two threads, with the
+// wire encoding next to bare doubles. The first lines time round trips of a
+// single quantity. The rest send batches one way and sum them on arrival:
+// bare doubles, batches decoded as the same type (a view of the receive
+// buffer), batches in the other byte order or converted to kPa, and values
+// that each carry their own fingerprint and are checked one at a time.
+//
+//   c++ -std=c++14 -O2 -pthread -I. benchmarks/wire_loopback.cpp -o wire_loopback
+//   ./wire_loopback [values] [batch]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "siunits.hpp"
+#include "quantity_wire.hpp"
+
+using namespace unitscxx;
+
+namespace
+{
+	using pascals = std::remove_const_t<decltype(si::Pa)>;
+	using kilopascals = std::remove_const_t<decltype(std::kilo() * si::Pa)>;
+
+	struct tagged
+	{
+		std::uint64_t dimension;
+		double value;
+	};
+
+	template<typename Function>
+	double seconds(Function&& function)
+	{
+		auto start = std::chrono::steady_clock::now();
+		function();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+
+	bool send_all(int fd, const void* data, size_t size)
+	{
+		auto bytes = static_cast<const char*>(data);
+		while (size != 0)
+		{
+			ssize_t sent = ::write(fd, bytes, size);
+			if (sent <= 0)
+			{
+				return false;
+			}
+			bytes += sent;
+			size -= size_t(sent);
+		}
+		return true;
+	}
+
+	bool receive_all(int fd, void* data, size_t size)
+	{
+		auto bytes = static_cast<char*>(data);
+		while (size != 0)
+		{
+			ssize_t received = ::read(fd, bytes, size);
+			if (received <= 0)
+			{
+				return false;
+			}
+			bytes += received;
+			size -= size_t(received);
+		}
+		return true;
+	}
+
+	// Runs sender on one end of a socket pair in a thread and receiver on
+	// the other, and reports the values per second that arrived.
+	void one_way(const char* name, size_t values, const std::function<void(int)>& sender,
+		const std::function<double(int)>& receiver)
+	{
+		int ends[2];
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, ends) != 0)
+		{
+			std::perror("socketpair");
+			std::exit(1);
+		}
+		double sum = 0;
+		double time = seconds([&] {
+			std::thread writer([&] { sender(ends[0]); });
+			sum = receiver(ends[1]);
+			writer.join();
+		});
+		::close(ends[0]);
+		::close(ends[1]);
+		std::printf("%-36s %8.1f Mvalues/s   (sum %.6g)\n", name, values / time / 1e6, sum);
+	}
+
+	void round_trips(const char* name, size_t trips, size_t message, const std::function<void(int)>& echo,
+		const std::function<void(int)>& ask)
+	{
+		int ends[2];
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, ends) != 0)
+		{
+			std::perror("socketpair");
+			std::exit(1);
+		}
+		double time = seconds([&] {
+			std::thread peer([&] { echo(ends[0]); });
+			ask(ends[1]);
+			peer.join();
+		});
+		::close(ends[0]);
+		::close(ends[1]);
+		std::printf("%-36s %8.2f us per round trip (%zu bytes)\n", name, time / trips * 1e6, message);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 26;
+	size_t batch = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4096;
+	size_t batches = (count + batch - 1) / batch;
+	size_t trips = 100000;
+
+	std::vector<pascals> readings;
+	std::vector<double> raw;
+	for (size_t i = 0; i < batch; ++i)
+	{
+		raw.push_back(101325 + double(i % 1000));
+		readings.push_back(raw.back() * si::Pa);
+	}
+
+	round_trips("bare double", trips, sizeof(double),
+		[&](int fd) {
+			double value;
+			for (size_t i = 0; i < trips && receive_all(fd, &value, sizeof value); ++i)
+			{
+				send_all(fd, &value, sizeof value);
+			}
+		},
+		[&](int fd) {
+			double value = 101325;
+			for (size_t i = 0; i < trips; ++i)
+			{
+				send_all(fd, &value, sizeof value);
+				receive_all(fd, &value, sizeof value);
+			}
+		});
+	round_trips("encoded quantity", trips, wire_size<pascals>(1),
+		[&](int fd) {
+			alignas(8) unsigned char message[wire_size<pascals>(1)];
+			pascals value;
+			for (size_t i = 0; i < trips && receive_all(fd, message, sizeof message); ++i)
+			{
+				if (decode(message, sizeof message, value).ec != wire_errc::ok)
+				{
+					std::abort();
+				}
+				encode(value, message, sizeof message);
+				send_all(fd, message, sizeof message);
+			}
+		},
+		[&](int fd) {
+			alignas(8) unsigned char message[wire_size<pascals>(1)];
+			pascals value = 101325 * si::Pa;
+			for (size_t i = 0; i < trips; ++i)
+			{
+				encode(value, message, sizeof message);
+				send_all(fd, message, sizeof message);
+				receive_all(fd, message, sizeof message);
+				if (decode(message, sizeof message, value).ec != wire_errc::ok)
+				{
+					std::abort();
+				}
+			}
+		});
+
+	one_way("bare doubles", batches * batch,
+		[&](int fd) {
+			for (size_t b = 0; b < batches; ++b)
+			{
+				send_all(fd, raw.data(), batch * sizeof(double));
+			}
+		},
+		[&](int fd) {
+			std::vector<double> buffer(batch);
+			double sum = 0;
+			for (size_t b = 0; b < batches && receive_all(fd, buffer.data(), batch * sizeof(double)); ++b)
+			{
+				for (double value : buffer)
+				{
+					sum += value;
+				}
+			}
+			return sum;
+		});
+
+	auto send_batches = [&](wire_order order) {
+		return [&, order](int fd) {
+			std::vector<unsigned char> message;
+			encode(quantity_span<const pascals>(readings), message, order);
+			for (size_t b = 0; b < batches; ++b)
+			{
+				send_all(fd, message.data(), message.size());
+			}
+		};
+	};
+	auto receive_batches = [&](auto unit, bool view) {
+		return [&, unit, view](int fd) {
+			using quantity_type = decltype(unit);
+			std::vector<std::uint64_t> buffer((wire_size<pascals>(batch) + 7) / 8);
+			std::vector<quantity_type> converted(batch);
+			double sum = 0;
+			for (size_t b = 0; b < batches && receive_all(fd, buffer.data(), wire_size<pascals>(batch)); ++b)
+			{
+				quantity_column<const quantity_type> column;
+				if (decode(buffer.data(), wire_size<pascals>(batch), column).ec != wire_errc::ok)
+				{
+					std::abort();
+				}
+				if (view)
+				{
+					for (quantity_type value : column.span())
+					{
+						sum += value.raw_value();
+					}
+				}
+				else
+				{
+					column.read(0, quantity_span<quantity_type>(converted));
+					for (quantity_type value : converted)
+					{
+						sum += value.raw_value();
+					}
+				}
+			}
+			return sum;
+		};
+	};
+	one_way("batches, same type (view)", batches * batch, send_batches(native_order()),
+		receive_batches(pascals(), true));
+	wire_order other = native_order() == wire_order::little ? wire_order::big : wire_order::little;
+	one_way("batches, other byte order", batches * batch, send_batches(other),
+		receive_batches(pascals(), false));
+	one_way("batches, read as kPa", batches * batch, send_batches(native_order()),
+		receive_batches(kilopascals(), false));
+
+	one_way("tagged values, checked one by one", batches * batch,
+		[&](int fd) {
+			std::vector<tagged> message;
+			for (double value : raw)
+			{
+				message.push_back({fingerprint<pascals>, value});
+			}
+			for (size_t b = 0; b < batches; ++b)
+			{
+				send_all(fd, message.data(), message.size() * sizeof(tagged));
+			}
+		},
+		[&](int fd) {
+			std::vector<tagged> buffer(batch);
+			double sum = 0;
+			for (size_t b = 0; b < batches && receive_all(fd, buffer.data(), batch * sizeof(tagged)); ++b)
+			{
+				for (const tagged& value : buffer)
+				{
+					if (value.dimension != fingerprint<pascals>)
+					{
+						std::abort();
+					}
+					sum += value.value;
+				}
+			}
+			return sum;
+		});
+}
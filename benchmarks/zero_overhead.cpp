@@ -0,0 +1,475 @@
+//
+// zero_overhead.cpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Runs the same kernels on quantities and on the plain numbers they wrap, to
+// check the claim that arithmetic with units is exactly as fast as without:
+// dot products, a three-point diffusion stencil, Newton's-law integration
+// with += and unit conversions, on double, float and int64_t. Each kernel is
+// written once as a template and instantiated twice, in noinline functions
+// named raw_* and units_* so that zero_overhead.py can compare their machine
+// code. Each line reports nanoseconds and, where Linux perf counters are
+// readable, instructions per element for both versions, and whether both
+// produced the same bits.
+//
+//   c++ -std=c++14 -O2 -I. benchmarks/zero_overhead.cpp -o zero_overhead
+//   ./zero_overhead [elements]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "siunits.hpp"
+#include "usunits.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace unitscxx;
+
+namespace
+{
+	template<typename Q, typename NT>
+	using as = quantity<NT, typename Q::dimension, typename Q::scale>;
+
+	using meters = std::remove_const_t<decltype(si::m)>;
+	using seconds = std::remove_const_t<decltype(si::s)>;
+	using kilograms = std::remove_const_t<decltype(si::kg)>;
+	using newtons = std::remove_const_t<decltype(si::N)>;
+	using joules = std::remove_const_t<decltype(si::J)>;
+	using kelvins = std::remove_const_t<decltype(si::K)>;
+	using meters_per_second = decltype(si::m / si::s);
+	using feet = quantity<double, meters::dimension, std::ratio<3048, 10000>>;
+	using millimeters = quantity<std::int64_t, meters::dimension, std::milli>;
+	using square_millimeters = decltype(millimeters() * millimeters());
+
+	template<typename Sum, typename A, typename B>
+	Sum dot(const A* a, const B* b, size_t count)
+	{
+		Sum sum{};
+		for (size_t i = 0; i < count; ++i)
+		{
+			sum += a[i] * b[i];
+		}
+		return sum;
+	}
+
+	template<typename T, typename K>
+	void diffuse(const T* in, T* out, size_t count, K k)
+	{
+		for (size_t i = 1; i + 1 < count; ++i)
+		{
+			out[i] = in[i] + k * (in[i - 1] - 2 * in[i] + in[i + 1]);
+		}
+	}
+
+	template<typename Mass, typename Force, typename Speed, typename Length, typename Time>
+	void integrate(const Mass* mass, const Force* force, Speed* speed, Length* position,
+		size_t count, Time dt)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			speed[i] += force[i] / mass[i] * dt;
+			position[i] += speed[i] * dt;
+		}
+	}
+
+	// The quantity versions pass a factor of 1 and let the scales of their
+	// types do the conversion.
+	template<typename To, typename From, typename Factor>
+	void rescale(const From* in, To* out, size_t count, Factor factor)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			out[i] = To(in[i] * factor);
+		}
+	}
+}
+
+#define KERNEL extern "C" __attribute__((noinline))
+
+KERNEL void raw_dot_double(const double* a, const double* b, size_t count, double* sum)
+{
+	*sum = dot<double>(a, b, count);
+}
+
+KERNEL void units_dot_double(const newtons* a, const meters* b, size_t count, joules* sum)
+{
+	*sum = dot<joules>(a, b, count);
+}
+
+KERNEL void raw_dot_float(const float* a, const float* b, size_t count, float* sum)
+{
+	*sum = dot<float>(a, b, count);
+}
+
+KERNEL void units_dot_float(const as<newtons, float>* a, const as<meters, float>* b,
+	size_t count, as<joules, float>* sum)
+{
+	*sum = dot<as<joules, float>>(a, b, count);
+}
+
+KERNEL void raw_dot_int64(const std::int64_t* a, const std::int64_t* b, size_t count,
+	std::int64_t* sum)
+{
+	*sum = dot<std::int64_t>(a, b, count);
+}
+
+KERNEL void units_dot_int64(const millimeters* a, const millimeters* b, size_t count,
+	square_millimeters* sum)
+{
+	*sum = dot<square_millimeters>(a, b, count);
+}
+
+KERNEL void raw_diffuse_double(const double* in, double* out, size_t count, double k)
+{
+	diffuse(in, out, count, k);
+}
+
+KERNEL void units_diffuse_double(const kelvins* in, kelvins* out, size_t count, double k)
+{
+	diffuse(in, out, count, k);
+}
+
+KERNEL void raw_diffuse_float(const float* in, float* out, size_t count, float k)
+{
+	diffuse(in, out, count, k);
+}
+
+KERNEL void units_diffuse_float(const as<kelvins, float>* in, as<kelvins, float>* out,
+	size_t count, float k)
+{
+	diffuse(in, out, count, k);
+}
+
+KERNEL void raw_newton_double(const double* mass, const double* force, double* speed,
+	double* position, size_t count, double dt)
+{
+	integrate(mass, force, speed, position, count, dt);
+}
+
+KERNEL void units_newton_double(const kilograms* mass, const newtons* force,
+	meters_per_second* speed, meters* position, size_t count, seconds dt)
+{
+	integrate(mass, force, speed, position, count, dt);
+}
+
+KERNEL void raw_newton_float(const float* mass, const float* force, float* speed,
+	float* position, size_t count, float dt)
+{
+	integrate(mass, force, speed, position, count, dt);
+}
+
+KERNEL void units_newton_float(const as<kilograms, float>* mass, const as<newtons, float>* force,
+	as<meters_per_second, float>* speed, as<meters, float>* position, size_t count, as<seconds, float> dt)
+{
+	integrate(mass, force, speed, position, count, dt);
+}
+
+KERNEL void raw_convert_double(const double* in, double* out, size_t count)
+{
+	rescale(in, out, count, 0.3048);
+}
+
+KERNEL void units_convert_double(const feet* in, meters* out, size_t count)
+{
+	rescale(in, out, count, 1);
+}
+
+KERNEL void raw_convert_int64(const std::int64_t* in, std::int64_t* out, size_t count)
+{
+	rescale(in, out, count, std::int64_t(1000));
+}
+
+KERNEL void units_convert_int64(const as<meters, std::int64_t>* in, millimeters* out,
+	size_t count)
+{
+	rescale(in, out, count, 1);
+}
+
+#undef KERNEL
+
+namespace
+{
+#ifdef __linux__
+	// Counts user-space instructions retired by this thread; reports -1 when
+	// the kernel doesn't let us, as in most containers.
+	class instruction_counter
+	{
+		int fd;
+
+	public:
+		instruction_counter()
+		{
+			perf_event_attr attributes;
+			std::memset(&attributes, 0, sizeof attributes);
+			attributes.type = PERF_TYPE_HARDWARE;
+			attributes.size = sizeof attributes;
+			attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+			attributes.disabled = 1;
+			attributes.exclude_kernel = 1;
+			attributes.exclude_hv = 1;
+			fd = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+		}
+
+		~instruction_counter()
+		{
+			if (fd >= 0) close(fd);
+		}
+
+		template<typename Function>
+		long long count(Function&& function)
+		{
+			if (fd < 0) return -1;
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+			function();
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+			long long instructions;
+			return read(fd, &instructions, sizeof instructions) == sizeof instructions ? instructions : -1;
+		}
+	};
+#else
+	class instruction_counter
+	{
+	public:
+		template<typename Function>
+		long long count(Function&&)
+		{
+			return -1;
+		}
+	};
+#endif
+
+	struct measurement
+	{
+		double seconds = 1e300;
+		long long instructions = -1;
+	};
+
+	// Alternates the two versions, so that frequency changes and other noise
+	// hit both alike, and keeps the best time of each.
+	template<typename Raw, typename Units>
+	void measure(instruction_counter& counter, Raw&& raw, Units&& units,
+		measurement& rawResult, measurement& unitsResult)
+	{
+		auto time = [](auto& function, measurement& result) {
+			auto start = std::chrono::steady_clock::now();
+			function();
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			result.seconds = elapsed.count() < result.seconds ? elapsed.count() : result.seconds;
+		};
+		for (int run = 0; run < 15; ++run)
+		{
+			time(raw, rawResult);
+			time(units, unitsResult);
+		}
+		rawResult.instructions = counter.count(raw);
+		unitsResult.instructions = counter.count(units);
+	}
+
+	void print_instructions(long long instructions, size_t count)
+	{
+		if (instructions < 0)
+		{
+			std::printf(" %9s", "-");
+		}
+		else
+		{
+			std::printf(" %9.2f", double(instructions) / count);
+		}
+	}
+
+	void report(const char* name, measurement raw, measurement units, size_t count, bool same)
+	{
+		std::printf("%-16s %9.3f %9.3f %6.2fx", name, raw.seconds / count * 1e9,
+			units.seconds / count * 1e9, units.seconds / raw.seconds);
+		print_instructions(raw.instructions, count);
+		print_instructions(units.instructions, count);
+		std::printf("   %s\n", same ? "same" : "DIFFERENT");
+	}
+
+	// The quantity buffers are the raw buffers reinterpreted, which is what
+	// quantity_span does too; the two runs start from identical copies.
+	template<typename Q, typename T>
+	Q* as_quantities(std::vector<T>& numbers)
+	{
+		static_assert(sizeof(Q) == sizeof(T), "quantity must wrap its number");
+		return reinterpret_cast<Q*>(numbers.data());
+	}
+
+	template<typename T>
+	std::vector<T> numbers(size_t count, std::mt19937_64& random)
+	{
+		std::uniform_real_distribution<double> values(0.5, 1000);
+		std::vector<T> result(count);
+		for (auto& number : result)
+		{
+			number = static_cast<T>(values(random));
+		}
+		return result;
+	}
+
+	template<typename T>
+	bool same(const std::vector<T>& a, const std::vector<T>& b)
+	{
+		return std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1 << 16;
+	std::mt19937_64 random(42);
+	instruction_counter counter;
+	std::printf("%-16s %9s %9s %7s %9s %9s   %s\n", "ns/element", "raw", "units", "",
+		"raw ins", "units ins", "results");
+
+	{
+		auto a = numbers<double>(count, random), b = numbers<double>(count, random);
+		std::vector<double> rawSum(1), unitsSum(1);
+		measurement raw, units;
+		measure(counter, [&] {
+			raw_dot_double(a.data(), b.data(), count, rawSum.data());
+		}, [&] {
+			units_dot_double(as_quantities<newtons>(a), as_quantities<meters>(b), count,
+				as_quantities<joules>(unitsSum));
+		}, raw, units);
+		report("dot double", raw, units, count, same(rawSum, unitsSum));
+	}
+	{
+		auto a = numbers<float>(count, random), b = numbers<float>(count, random);
+		std::vector<float> rawSum(1), unitsSum(1);
+		measurement raw, units;
+		measure(counter, [&] {
+			raw_dot_float(a.data(), b.data(), count, rawSum.data());
+		}, [&] {
+			units_dot_float(as_quantities<as<newtons, float>>(a),
+				as_quantities<as<meters, float>>(b), count,
+				as_quantities<as<joules, float>>(unitsSum));
+		}, raw, units);
+		report("dot float", raw, units, count, same(rawSum, unitsSum));
+	}
+	{
+		auto a = numbers<std::int64_t>(count, random), b = numbers<std::int64_t>(count, random);
+		std::vector<std::int64_t> rawSum(1), unitsSum(1);
+		measurement raw, units;
+		measure(counter, [&] {
+			raw_dot_int64(a.data(), b.data(), count, rawSum.data());
+		}, [&] {
+			units_dot_int64(as_quantities<millimeters>(a), as_quantities<millimeters>(b), count,
+				as_quantities<square_millimeters>(unitsSum));
+		}, raw, units);
+		report("dot int64", raw, units, count, same(rawSum, unitsSum));
+	}
+	{
+		auto in = numbers<double>(count, random);
+		std::vector<double> rawOut(count), unitsOut(count);
+		measurement raw, units;
+		measure(counter, [&] {
+			raw_diffuse_double(in.data(), rawOut.data(), count, 0.25);
+		}, [&] {
+			units_diffuse_double(as_quantities<kelvins>(in), as_quantities<kelvins>(unitsOut),
+				count, 0.25);
+		}, raw, units);
+		report("diffuse double", raw, units, count, same(rawOut, unitsOut));
+	}
+	{
+		auto in = numbers<float>(count, random);
+		std::vector<float> rawOut(count), unitsOut(count);
+		measurement raw, units;
+		measure(counter, [&] {
+			raw_diffuse_float(in.data(), rawOut.data(), count, 0.25f);
+		}, [&] {
+			units_diffuse_float(as_quantities<as<kelvins, float>>(in),
+				as_quantities<as<kelvins, float>>(unitsOut), count, 0.25f);
+		}, raw, units);
+		report("diffuse float", raw, units, count, same(rawOut, unitsOut));
+	}
+	{
+		// both versions integrate the same number of steps from the same state
+		auto mass = numbers<double>(count, random), force = numbers<double>(count, random);
+		auto rawSpeed = numbers<double>(count, random), rawPosition = numbers<double>(count, random);
+		auto unitsSpeed = rawSpeed, unitsPosition = rawPosition;
+		measurement raw, units;
+		measure(counter, [&] {
+			raw_newton_double(mass.data(), force.data(), rawSpeed.data(), rawPosition.data(),
+				count, 0.001);
+		}, [&] {
+			units_newton_double(as_quantities<kilograms>(mass), as_quantities<newtons>(force),
+				as_quantities<meters_per_second>(unitsSpeed), as_quantities<meters>(unitsPosition),
+				count, 0.001 * si::s);
+		}, raw, units);
+		report("newton double", raw, units, count,
+			same(rawSpeed, unitsSpeed) && same(rawPosition, unitsPosition));
+	}
+	{
+		auto mass = numbers<float>(count, random), force = numbers<float>(count, random);
+		auto rawSpeed = numbers<float>(count, random), rawPosition = numbers<float>(count, random);
+		auto unitsSpeed = rawSpeed, unitsPosition = rawPosition;
+		measurement raw, units;
+		measure(counter, [&] {
+			raw_newton_float(mass.data(), force.data(), rawSpeed.data(), rawPosition.data(),
+				count, 0.001f);
+		}, [&] {
+			units_newton_float(as_quantities<as<kilograms, float>>(mass),
+				as_quantities<as<newtons, float>>(force),
+				as_quantities<as<meters_per_second, float>>(unitsSpeed),
+				as_quantities<as<meters, float>>(unitsPosition), count,
+				as<seconds, float>(0.001f * si::s));
+		}, raw, units);
+		report("newton float", raw, units, count,
+			same(rawSpeed, unitsSpeed) && same(rawPosition, unitsPosition));
+	}
+	{
+		auto in = numbers<double>(count, random);
+		std::vector<double> rawOut(count), unitsOut(count);
+		measurement raw, units;
+		measure(counter, [&] {
+			raw_convert_double(in.data(), rawOut.data(), count);
+		}, [&] {
+			units_convert_double(as_quantities<feet>(in), as_quantities<meters>(unitsOut), count);
+		}, raw, units);
+		report("ft to m double", raw, units, count, same(rawOut, unitsOut));
+	}
+	{
+		auto in = numbers<std::int64_t>(count, random);
+		std::vector<std::int64_t> rawOut(count), unitsOut(count);
+		measurement raw, units;
+		measure(counter, [&] {
+			raw_convert_int64(in.data(), rawOut.data(), count);
+		}, [&] {
+			units_convert_int64(as_quantities<as<meters, std::int64_t>>(in),
+				as_quantities<millimeters>(unitsOut), count);
+		}, raw, units);
+		report("m to mm int64", raw, units, count, same(rawOut, unitsOut));
+	}
+}
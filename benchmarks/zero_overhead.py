@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+#
+# zero_overhead.py
+# units-cxx14
+#
+# Copyright (c) 2016 Félix Cloutier
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+
+# Compares the machine code of the raw_* and units_* kernels of
+# zero_overhead.cpp, which instantiate the same templates with plain numbers
+# and with quantities. A kernel is "identical" when the instructions match
+# after addresses are masked, and "same opcodes" when only registers or
+# operand order differ. The benchmark itself runs afterwards unless --no-run
+# is given.
+#
+#   python3 benchmarks/zero_overhead.py
+#   CXX=clang++ python3 benchmarks/zero_overhead.py --flags "-std=c++14 -O3 -march=native"
+#   python3 benchmarks/zero_overhead.py --diff --strict
+
+import argparse
+import difflib
+import os
+import re
+import shlex
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCE = os.path.join(ROOT, "benchmarks", "zero_overhead.cpp")
+
+def disassemble(binary):
+	# returns {function name: [instruction, ...]} for the kernels
+	output = subprocess.check_output(["objdump", "-d", "--no-show-raw-insn",
+		binary]).decode()
+	functions = {}
+	current = None
+	for line in output.splitlines():
+		header = re.match(r"^[0-9a-f]+ <_?((?:raw|units)_\w+)>:$", line)
+		if header:
+			current = functions.setdefault(header.group(1), [])
+			continue
+		if not line.strip():
+			current = None
+			continue
+		if current is None:
+			continue
+		parts = line.split("\t")
+		if len(parts) < 2 or not parts[-1].strip():
+			continue
+		instruction = normalize(parts[-1])
+		# alignment padding depends on where the function landed
+		if not re.match(r"(nop|int3|xchg %ax,%ax|data16|cs nop)", instruction):
+			current.append(instruction)
+	return functions
+
+def normalize(instruction):
+	instruction = instruction.split("#")[0].strip()
+	instruction = re.sub(r"\s+", " ", instruction)
+	# jump targets become offsets into the function, constants lose their address
+	instruction = re.sub(r"[0-9a-f]+ <_?\w+(\+0x[0-9a-f]+)?>", r"<\1>", instruction)
+	instruction = re.sub(r"-?0x[0-9a-f]+\(%rip\)", "(%rip)", instruction)
+	return instruction
+
+def opcodes(instructions):
+	return [i.split(" ")[0] for i in instructions]
+
+def main():
+	parser = argparse.ArgumentParser(
+		description="Compare the code generated for quantities and raw numbers")
+	parser.add_argument("--flags", default="-std=c++14 -O2",
+		help="compiler flags (default: %(default)s)")
+	parser.add_argument("--diff", action="store_true",
+		help="print the instructions of kernels that aren't identical")
+	parser.add_argument("--strict", action="store_true",
+		help="fail unless every kernel is identical or has the same opcodes")
+	parser.add_argument("--no-run", action="store_true",
+		help="only compare the code, don't run the benchmark")
+	parser.add_argument("elements", nargs="?",
+		help="element count passed to the benchmark")
+	args = parser.parse_args()
+
+	cxx = shlex.split(os.environ.get("CXX", "c++"))
+	flags = shlex.split(args.flags) + ["-Wno-unknown-pragmas"]
+	failed = False
+	with tempfile.TemporaryDirectory() as workdir:
+		binary = os.path.join(workdir, "zero_overhead")
+		subprocess.check_call(cxx + flags + ["-I", ROOT, SOURCE, "-o", binary])
+		functions = disassemble(binary)
+		kernels = sorted(name[len("raw_"):] for name in functions
+			if name.startswith("raw_"))
+		print("%-16s %9s %9s   %s" % ("kernel", "raw ins", "units ins", "code"))
+		for kernel in kernels:
+			raw = functions["raw_" + kernel]
+			units = functions.get("units_" + kernel, [])
+			if raw == units:
+				verdict = "identical"
+			elif opcodes(raw) == opcodes(units):
+				verdict = "same opcodes"
+			else:
+				verdict = "DIFFERENT"
+				failed = True
+			print("%-16s %9d %9d   %s" % (kernel, len(raw), len(units), verdict))
+			if args.diff and raw != units:
+				for line in difflib.unified_diff(raw, units, "raw_" + kernel,
+					"units_" + kernel, lineterm=""):
+					print("    " + line)
+
+		if not args.no_run:
+			print()
+			sys.stdout.flush()
+			subprocess.check_call([binary] + ([args.elements] if args.elements else []))
+	return 1 if failed and args.strict else 0
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,495 @@
+//
+// dyn_quantity.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef DYN_QUANTITY_HPP
+#define DYN_QUANTITY_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "units.hpp"
+
+// Quantities whose units are only known at runtime, for code that reads them
+// from schemas or configuration. The dimension is packed into one 64-bit
+// word, one signed byte per base unit of the same enum that unit_base uses,
+// so checking that two dimensions match is a single integer comparison and
+// multiplying them is a handful of integer operations.
+//
+// Mismatched operations don't throw: like NaN for numbers, they mark the
+// result as invalid, and the mark survives further arithmetic. Check valid()
+// or convert back to a static quantity with convert_to().
+
+namespace detail
+{
+	template<typename UnitType, int Den, int... Es>
+	constexpr bool exponents_fit_bytes(rational_dimension<UnitType, Den, Es...>)
+	{
+		int exponents[] = {Es..., 0};
+		for (int exponent : exponents)
+		{
+			if (exponent < -128 || exponent > 127)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+namespace unitscxx
+{
+#pragma mark - Dimension fingerprints
+	// A dimension as one 64-bit word, for checks across type erasure (files,
+	// messages, plugins). Byte i holds the numerator of the exponent of base
+	// unit i and byte 7 the denominator less one, so whole dimensions have
+	// the same word as dyn_dimension::packed(). The word only depends on the
+	// exponents: not on the order units were multiplied in, the compiler or
+	// the build. Two dimensions of one unit system have the same fingerprint
+	// if and only if they are the same dimension.
+	template<typename Dimension>
+	constexpr uint64_t dimension_fingerprint()
+	{
+		static_assert(Dimension::size <= 7, "fingerprints hold up to 7 base units");
+		static_assert(Dimension::denominator <= 128, "fingerprints hold denominators up to 128");
+		static_assert(detail::exponents_fit_bytes(Dimension{}), "fingerprints hold exponents from -128 to 127");
+		uint64_t result = uint64_t(Dimension::denominator - 1) << 56;
+		for (size_t i = 0; i < Dimension::size; ++i)
+		{
+			result |= uint64_t(static_cast<uint8_t>(detail::exponent_at(Dimension{}, i))) << (8 * i);
+		}
+		return result;
+	}
+
+	template<typename Quantity>
+	constexpr uint64_t fingerprint = dimension_fingerprint<typename std::remove_cv_t<Quantity>::dimension>();
+
+	// The exponents in a fingerprint, for diagnostics: exponent i is
+	// numerators[i] / denominator. Words that no dimension produces (bit 63
+	// set, or a fraction not in lowest terms) decode as invalid.
+	struct fingerprint_exponents
+	{
+		int numerators[7];
+		int denominator;
+		bool valid;
+	};
+
+	constexpr fingerprint_exponents decode_fingerprint(uint64_t print)
+	{
+		fingerprint_exponents result = {};
+		result.denominator = int(print >> 56) + 1;
+		intmax_t divisor = result.denominator;
+		for (size_t i = 0; i < 7; ++i)
+		{
+			result.numerators[i] = static_cast<int8_t>(static_cast<uint8_t>(print >> (8 * i)));
+			divisor = detail::gcd(divisor, result.numerators[i]);
+		}
+		result.valid = (print >> 63) == 0 && divisor == 1;
+		return result;
+	}
+
+#pragma mark - Packed dimension
+	template<typename UnitType>
+	class dyn_dimension
+	{
+		// lanes 0 to 6 hold the exponents, bit 63 is the invalid mark
+		static constexpr uint64_t high_bits = 0x0080808080808080ull;
+		static constexpr uint64_t low_bits = 0x007f7f7f7f7f7f7full;
+		static constexpr uint64_t invalid_bit = 1ull << 63;
+
+		uint64_t bits;
+
+		constexpr explicit dyn_dimension(uint64_t bits) : bits(bits)
+		{
+		}
+
+	public:
+		static constexpr size_t max_base_units = 7;
+
+		// dimensionless
+		constexpr dyn_dimension() : bits(0)
+		{
+		}
+
+		template<typename Dimension>
+		static constexpr dyn_dimension of()
+		{
+			static_assert(std::is_same<typename Dimension::value_type, UnitType>::value,
+				"dimension of another unit system");
+			static_assert(Dimension::size <= max_base_units,
+				"dyn_dimension holds up to 7 base units");
+			static_assert(Dimension::denominator == 1,
+				"dyn_dimension holds whole exponents only");
+			int exponents[max_base_units] = {};
+			for (size_t i = 0; i < Dimension::size; ++i)
+			{
+				exponents[i] = detail::exponent_at(Dimension{}, i);
+			}
+			return from_exponents(exponents);
+		}
+
+		// From exponents indexed by the unit enum, for dimensions read at
+		// runtime.
+		template<size_t N>
+		static constexpr dyn_dimension from_exponents(const int (&exponents)[N])
+		{
+			uint64_t result = N > max_base_units ? invalid_bit : 0;
+			for (size_t i = 0; i < N && i < max_base_units; ++i)
+			{
+				bool fits = exponents[i] >= -128 && exponents[i] <= 127;
+				result |= fits
+					? uint64_t(static_cast<uint8_t>(exponents[i])) << (8 * i)
+					: invalid_bit;
+			}
+			return dyn_dimension(result);
+		}
+
+		static constexpr dyn_dimension invalid()
+		{
+			return dyn_dimension(invalid_bit);
+		}
+
+		// The exponent of each base unit, from the bytes of the word.
+		UNITS_ATTR_NODISCARD constexpr int exponent(UnitType unit) const
+		{
+			return static_cast<int8_t>(static_cast<uint8_t>(
+				bits >> (8 * static_cast<size_t>(unit))));
+		}
+
+		UNITS_ATTR_NODISCARD constexpr bool valid() const
+		{
+			return (bits & invalid_bit) == 0;
+		}
+
+		UNITS_ATTR_NODISCARD constexpr uint64_t packed() const
+		{
+			return bits;
+		}
+
+		// Bytewise addition without carries between lanes. An exponent that
+		// overflows its byte makes the result invalid.
+		UNITS_ATTR_NODISCARD constexpr dyn_dimension operator*(dyn_dimension that) const
+		{
+			uint64_t sum = ((bits & low_bits) + (that.bits & low_bits))
+				^ ((bits ^ that.bits) & high_bits);
+			uint64_t overflow = ~(bits ^ that.bits) & (bits ^ sum) & high_bits;
+			return dyn_dimension(sum | ((bits | that.bits) & invalid_bit)
+				| (overflow != 0 ? invalid_bit : 0));
+		}
+
+		UNITS_ATTR_NODISCARD constexpr dyn_dimension operator/(dyn_dimension that) const
+		{
+			uint64_t difference = ((bits | high_bits) - (that.bits & low_bits))
+				^ ((bits ^ ~that.bits) & high_bits);
+			uint64_t overflow = (bits ^ that.bits) & (bits ^ difference) & high_bits;
+			return dyn_dimension((difference & ~invalid_bit) | ((bits | that.bits) & invalid_bit)
+				| (overflow != 0 ? invalid_bit : 0));
+		}
+
+		UNITS_ATTR_NODISCARD constexpr bool operator==(dyn_dimension that) const
+		{
+			return bits == that.bits;
+		}
+
+		UNITS_ATTR_NODISCARD constexpr bool operator!=(dyn_dimension that) const
+		{
+			return bits != that.bits;
+		}
+
+		// The dimension of a + b: the common one, or invalid.
+		UNITS_ATTR_NODISCARD constexpr dyn_dimension common(dyn_dimension that) const
+		{
+			return bits == that.bits ? *this : invalid();
+		}
+	};
+
+#pragma mark - Dynamic quantity
+	// A number of base units of scale 1 (so seconds, meters, and grams rather
+	// than kilograms for the SI), with a dimension known at runtime.
+	template<typename NumericType, typename UnitType>
+	class dyn_quantity
+	{
+		NumericType value;
+		dyn_dimension<UnitType> dim;
+
+	public:
+		using numeric_type = NumericType;
+		using unit_system = UnitType;
+		using dimension_type = dyn_dimension<UnitType>;
+
+		constexpr dyn_quantity() : value{}, dim()
+		{
+		}
+
+		constexpr dyn_quantity(NumericType value, dimension_type dimension)
+			: value(value), dim(dimension)
+		{
+		}
+
+		// Static quantities convert implicitly: nothing can go wrong.
+		template<typename NT, typename D, typename S>
+		constexpr dyn_quantity(quantity<NT, D, S> that)
+			: value(detail::rescale<NumericType, S, std::ratio<1>>(that.raw_value())),
+			dim(dimension_type::template of<D>())
+		{
+		}
+
+		// The number of base units.
+		UNITS_ATTR_NODISCARD constexpr NumericType raw_value() const
+		{
+			return value;
+		}
+
+		UNITS_ATTR_NODISCARD constexpr dimension_type dimension() const
+		{
+			return dim;
+		}
+
+		UNITS_ATTR_NODISCARD constexpr bool valid() const
+		{
+			return dim.valid();
+		}
+
+		// True if this holds a quantity of the same dimension as Quantity.
+		template<typename Quantity>
+		UNITS_ATTR_NODISCARD constexpr bool is() const
+		{
+			return dim == dimension_type::template of<typename Quantity::dimension>();
+		}
+
+		// Converts to a static quantity if the dimensions match, and leaves
+		// out alone otherwise.
+		template<typename NT, typename D, typename S>
+		bool convert_to(quantity<NT, D, S>& out) const
+		{
+			if (dim != dimension_type::template of<D>())
+			{
+				return false;
+			}
+			out = quantity<NT, D, S>(detail::rescale<NT, std::ratio<1>, S>(value));
+			return true;
+		}
+
+		// Same, for callers that already know that the dimensions match.
+		template<typename Quantity>
+		UNITS_ATTR_NODISCARD Quantity as() const
+		{
+			std::remove_cv_t<Quantity> result;
+			bool converted = convert_to(result);
+			assert(converted && "dyn_quantity has another dimension");
+			(void)converted;
+			return result;
+		}
+
+		template<typename NT>
+		UNITS_ATTR_NODISCARD constexpr auto operator+(dyn_quantity<NT, UnitType> that) const
+		{
+			using result_type = dyn_quantity<std::common_type_t<NumericType, NT>, UnitType>;
+			return result_type(value + that.raw_value(), dim.common(that.dimension()));
+		}
+
+		template<typename NT>
+		UNITS_ATTR_NODISCARD constexpr auto operator-(dyn_quantity<NT, UnitType> that) const
+		{
+			using result_type = dyn_quantity<std::common_type_t<NumericType, NT>, UnitType>;
+			return result_type(value - that.raw_value(), dim.common(that.dimension()));
+		}
+
+		template<typename NT>
+		UNITS_ATTR_NODISCARD constexpr auto operator*(dyn_quantity<NT, UnitType> that) const
+		{
+			using result_type = dyn_quantity<std::common_type_t<NumericType, NT>, UnitType>;
+			return result_type(value * that.raw_value(), dim * that.dimension());
+		}
+
+		template<typename NT>
+		UNITS_ATTR_NODISCARD constexpr auto operator/(dyn_quantity<NT, UnitType> that) const
+		{
+			using result_type = dyn_quantity<std::common_type_t<NumericType, NT>, UnitType>;
+			return result_type(value / that.raw_value(), dim / that.dimension());
+		}
+
+		template<typename NT, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
+		UNITS_ATTR_NODISCARD constexpr auto operator*(NT that) const
+		{
+			using result_type = dyn_quantity<std::common_type_t<NumericType, NT>, UnitType>;
+			return result_type(value * that, dim);
+		}
+
+		template<typename NT, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
+		UNITS_ATTR_NODISCARD constexpr auto operator/(NT that) const
+		{
+			using result_type = dyn_quantity<std::common_type_t<NumericType, NT>, UnitType>;
+			return result_type(value / that, dim);
+		}
+
+		UNITS_ATTR_NODISCARD constexpr dyn_quantity operator-() const
+		{
+			return dyn_quantity(-value, dim);
+		}
+
+		template<typename NT>
+		dyn_quantity& operator+=(dyn_quantity<NT, UnitType> that)
+		{
+			value += that.raw_value();
+			dim = dim.common(that.dimension());
+			return *this;
+		}
+
+		template<typename NT>
+		dyn_quantity& operator-=(dyn_quantity<NT, UnitType> that)
+		{
+			value -= that.raw_value();
+			dim = dim.common(that.dimension());
+			return *this;
+		}
+
+		template<typename NT>
+		dyn_quantity& operator*=(dyn_quantity<NT, UnitType> that)
+		{
+			value *= that.raw_value();
+			dim = dim * that.dimension();
+			return *this;
+		}
+
+		template<typename NT>
+		dyn_quantity& operator/=(dyn_quantity<NT, UnitType> that)
+		{
+			value /= that.raw_value();
+			dim = dim / that.dimension();
+			return *this;
+		}
+
+		// Quantities of different dimensions are never equal, and never
+		// ordered.
+		template<typename NT>
+		UNITS_ATTR_NODISCARD constexpr bool operator==(dyn_quantity<NT, UnitType> that) const
+		{
+			return dim == that.dimension() && value == that.raw_value();
+		}
+
+		template<typename NT>
+		UNITS_ATTR_NODISCARD constexpr bool operator!=(dyn_quantity<NT, UnitType> that) const
+		{
+			return !(*this == that);
+		}
+
+		template<typename NT>
+		UNITS_ATTR_NODISCARD constexpr bool operator<(dyn_quantity<NT, UnitType> that) const
+		{
+			return dim == that.dimension() && value < that.raw_value();
+		}
+
+		template<typename NT>
+		UNITS_ATTR_NODISCARD constexpr bool operator>(dyn_quantity<NT, UnitType> that) const
+		{
+			return dim == that.dimension() && value > that.raw_value();
+		}
+
+		template<typename NT>
+		UNITS_ATTR_NODISCARD constexpr bool operator<=(dyn_quantity<NT, UnitType> that) const
+		{
+			return dim == that.dimension() && value <= that.raw_value();
+		}
+
+		template<typename NT>
+		UNITS_ATTR_NODISCARD constexpr bool operator>=(dyn_quantity<NT, UnitType> that) const
+		{
+			return dim == that.dimension() && value >= that.raw_value();
+		}
+	};
+
+	template<typename MulType, typename NT, typename U, typename =
+		std::enable_if_t<std::is_arithmetic<MulType>::value>>
+	UNITS_ATTR_NODISCARD constexpr auto operator*(MulType left, dyn_quantity<NT, U> right)
+	{
+		return right * left;
+	}
+
+	template<typename DivType, typename NT, typename U, typename =
+		std::enable_if_t<std::is_arithmetic<DivType>::value>>
+	UNITS_ATTR_NODISCARD constexpr auto operator/(DivType left, dyn_quantity<NT, U> right)
+	{
+		using result_type = dyn_quantity<std::common_type_t<DivType, NT>, U>;
+		return result_type(left / right.raw_value(), dyn_dimension<U>() / right.dimension());
+	}
+
+	// Mixed with static quantities, the static side is made dynamic first.
+	template<typename DNT, typename U, typename NT, typename D, typename S>
+	UNITS_ATTR_NODISCARD constexpr auto operator+(dyn_quantity<DNT, U> left, quantity<NT, D, S> right)
+	{
+		return left + dyn_quantity<NT, U>(right);
+	}
+
+	template<typename DNT, typename U, typename NT, typename D, typename S>
+	UNITS_ATTR_NODISCARD constexpr auto operator-(dyn_quantity<DNT, U> left, quantity<NT, D, S> right)
+	{
+		return left - dyn_quantity<NT, U>(right);
+	}
+
+	template<typename DNT, typename U, typename NT, typename D, typename S>
+	UNITS_ATTR_NODISCARD constexpr auto operator*(dyn_quantity<DNT, U> left, quantity<NT, D, S> right)
+	{
+		return left * dyn_quantity<NT, U>(right);
+	}
+
+	template<typename DNT, typename U, typename NT, typename D, typename S>
+	UNITS_ATTR_NODISCARD constexpr auto operator/(dyn_quantity<DNT, U> left, quantity<NT, D, S> right)
+	{
+		return left / dyn_quantity<NT, U>(right);
+	}
+
+	template<typename NT, typename D, typename S, typename DNT, typename U>
+	UNITS_ATTR_NODISCARD constexpr auto operator+(quantity<NT, D, S> left, dyn_quantity<DNT, U> right)
+	{
+		return dyn_quantity<NT, U>(left) + right;
+	}
+
+	template<typename NT, typename D, typename S, typename DNT, typename U>
+	UNITS_ATTR_NODISCARD constexpr auto operator-(quantity<NT, D, S> left, dyn_quantity<DNT, U> right)
+	{
+		return dyn_quantity<NT, U>(left) - right;
+	}
+
+	template<typename NT, typename D, typename S, typename DNT, typename U>
+	UNITS_ATTR_NODISCARD constexpr auto operator*(quantity<NT, D, S> left, dyn_quantity<DNT, U> right)
+	{
+		return dyn_quantity<NT, U>(left) * right;
+	}
+
+	template<typename NT, typename D, typename S, typename DNT, typename U>
+	UNITS_ATTR_NODISCARD constexpr auto operator/(quantity<NT, D, S> left, dyn_quantity<DNT, U> right)
+	{
+		return dyn_quantity<NT, U>(left) / right;
+	}
+
+	// The dynamic counterpart of a static quantity type.
+	template<typename Quantity>
+	using dyn_quantity_of = dyn_quantity<typename std::remove_cv_t<Quantity>::numeric_type,
+		typename std::remove_cv_t<Quantity>::unit_system>;
+}
+
+#endif
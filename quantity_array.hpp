@@ -0,0 +1,218 @@
+//
+// quantity_array.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef QUANTITY_ARRAY_HPP
+#define QUANTITY_ARRAY_HPP
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <ratio>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "units.hpp"
+#include "quantity_buffer.hpp"
+#include "quantity_expr.hpp"
+
+namespace unitscxx
+{
+	// A contiguous array of quantities that all have the same units. The
+	// elements are stored as raw numbers, so whole-array arithmetic runs on
+	// the numeric storage directly; units are only checked and computed at
+	// compile time (see quantity_expr.hpp). Use an Extent for a fixed-size
+	// array, or leave it out for one that is sized at runtime. Construct it
+	// with for_overwrite to skip zeroing elements that will be overwritten.
+	template<typename Quantity, size_t Extent = dynamic_extent>
+	class quantity_array
+	{
+	public:
+		using value_type = std::remove_cv_t<Quantity>;
+		using numeric_type = typename value_type::numeric_type;
+		using size_type = size_t;
+		using reference = value_type&;
+		using const_reference = const value_type&;
+		using pointer = value_type*;
+		using const_pointer = const value_type*;
+		using iterator = pointer;
+		using const_iterator = const_pointer;
+
+		static constexpr size_t extent = Extent;
+
+		static_assert(has_numeric_layout<value_type>::value,
+			"quantity must have the same layout as its numeric type");
+
+	private:
+		using storage_type = std::conditional_t<Extent == dynamic_extent,
+			std::vector<numeric_type, default_init_allocator<numeric_type>>,
+			std::array<numeric_type, Extent>>;
+
+		storage_type values;
+
+		void resize_storage(size_t count, std::true_type)
+		{
+			values.resize(count);
+		}
+
+		void resize_storage(size_t count, std::false_type)
+		{
+			assert(count == Extent && "wrong size for a fixed-size quantity_array");
+			(void)count;
+		}
+
+	public:
+		quantity_array() : values{}
+		{
+		}
+
+		explicit quantity_array(size_t count) : quantity_array(count, value_type())
+		{
+		}
+
+		quantity_array(size_t count, value_type value) : quantity_array(count, for_overwrite)
+		{
+			fill(value);
+		}
+
+		// The elements are indeterminate until they are assigned.
+		quantity_array(size_t count, for_overwrite_t)
+		{
+			resize_storage(count, std::integral_constant<bool, Extent == dynamic_extent>{});
+		}
+
+		quantity_array(std::initializer_list<value_type> list)
+			: quantity_array(list.size(), for_overwrite)
+		{
+			size_t i = 0;
+			for (value_type q : list)
+			{
+				values[i++] = q.raw_value();
+			}
+		}
+
+		template<typename D = storage_type, typename =
+			decltype(std::declval<D&>().resize(0))>
+		void resize(size_t count)
+		{
+			values.resize(count, numeric_type());
+		}
+
+		void fill(value_type value)
+		{
+			for (numeric_type& raw : values)
+			{
+				raw = value.raw_value();
+			}
+		}
+
+		UNITS_ATTR_NODISCARD size_t size() const { return values.size(); }
+		UNITS_ATTR_NODISCARD bool empty() const { return values.size() == 0; }
+
+		// The raw numeric storage, for routines that don't know about units.
+		UNITS_ATTR_NODISCARD numeric_type* data() { return values.data(); }
+		UNITS_ATTR_NODISCARD const numeric_type* data() const { return values.data(); }
+
+		UNITS_ATTR_NODISCARD reference operator[](size_t index)
+		{
+			return reinterpret_cast<reference>(values[index]);
+		}
+
+		UNITS_ATTR_NODISCARD const_reference operator[](size_t index) const
+		{
+			return reinterpret_cast<const_reference>(values[index]);
+		}
+
+		UNITS_ATTR_NODISCARD iterator begin() { return reinterpret_cast<pointer>(values.data()); }
+		UNITS_ATTR_NODISCARD iterator end() { return begin() + size(); }
+		UNITS_ATTR_NODISCARD const_iterator begin() const { return reinterpret_cast<const_pointer>(values.data()); }
+		UNITS_ATTR_NODISCARD const_iterator end() const { return begin() + size(); }
+
+		// Expressions over quantity containers are evaluated here, in a single
+		// pass. The units of the expression must match the array's.
+		template<typename Expr, typename = std::enable_if_t<
+			detail::expr::is_node<std::decay_t<Expr>>::value>>
+		quantity_array(const Expr& expr) : quantity_array(expr.size(), for_overwrite)
+		{
+			assign(expr);
+		}
+
+		template<typename Expr, typename = std::enable_if_t<
+			detail::expr::is_node<std::decay_t<Expr>>::value>>
+		quantity_array& operator=(const Expr& expr)
+		{
+			assign(expr);
+			return *this;
+		}
+
+		template<typename T>
+		quantity_array& operator+=(T&& that)
+		{
+			return *this = *this + std::forward<T>(that);
+		}
+
+		template<typename T>
+		quantity_array& operator-=(T&& that)
+		{
+			return *this = *this - std::forward<T>(that);
+		}
+
+		template<typename T>
+		quantity_array& operator*=(T&& that)
+		{
+			return *this = *this * std::forward<T>(that);
+		}
+
+		template<typename T>
+		quantity_array& operator/=(T&& that)
+		{
+			return *this = *this / std::forward<T>(that);
+		}
+
+	private:
+		template<typename Expr>
+		void assign(const Expr& expr)
+		{
+			detail::expr::assign<value_type>(expr, data(), size());
+		}
+	};
+
+	template<typename Quantity, size_t Extent>
+	constexpr size_t quantity_array<Quantity, Extent>::extent;
+}
+
+namespace detail
+{
+namespace expr
+{
+	template<typename Quantity, size_t Extent>
+	struct is_range<unitscxx::quantity_array<Quantity, Extent>> : std::true_type
+	{
+	};
+}
+}
+
+#endif
@@ -0,0 +1,149 @@
+//
+// quantity_blas.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef QUANTITY_BLAS_HPP
+#define QUANTITY_BLAS_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <ratio>
+#include <type_traits>
+#include <cblas.h>
+#include "units.hpp"
+#include "quantity_span.hpp"
+
+// Opt-in CBLAS bindings (link with -lopenblas, -lblas or similar). They hand
+// the raw storage of quantity spans to BLAS without copying, check the units
+// at compile time and fold scale differences into alpha, so that the result
+// lands in the units of the output span. Eigen matrices and quantity_arrays
+// convert to spans directly.
+
+namespace detail
+{
+	namespace blas
+	{
+		inline void gemm(CBLAS_ORDER order, int m, int n, int k, float alpha,
+			const float* a, int lda, const float* b, int ldb, float* c, int ldc)
+		{
+			cblas_sgemm(order, CblasNoTrans, CblasNoTrans, m, n, k, alpha, a, lda, b, ldb, 0, c, ldc);
+		}
+
+		inline void gemm(CBLAS_ORDER order, int m, int n, int k, double alpha,
+			const double* a, int lda, const double* b, int ldb, double* c, int ldc)
+		{
+			cblas_dgemm(order, CblasNoTrans, CblasNoTrans, m, n, k, alpha, a, lda, b, ldb, 0, c, ldc);
+		}
+
+		inline void axpy(int n, float alpha, const float* x, float* y)
+		{
+			cblas_saxpy(n, alpha, x, 1, y, 1);
+		}
+
+		inline void axpy(int n, double alpha, const double* x, double* y)
+		{
+			cblas_daxpy(n, alpha, x, 1, y, 1);
+		}
+
+		inline float dot(int n, const float* x, const float* y)
+		{
+			return cblas_sdot(n, x, 1, y, 1);
+		}
+
+		inline double dot(int n, const double* x, const double* y)
+		{
+			return cblas_ddot(n, x, 1, y, 1);
+		}
+
+		template<typename From, typename To, typename NT>
+		constexpr NT factor()
+		{
+			using ratio = std::ratio_divide<From, To>;
+			return static_cast<NT>(ratio::num) / static_cast<NT>(ratio::den);
+		}
+	}
+}
+
+namespace unitscxx
+{
+	// c = a * b, where a is m×k, b is k×n and c is m×n, all dense in the given
+	// order. c must have the units of a * b, at any scale.
+	template<typename QA, size_t EA, typename QB, size_t EB, typename QC, size_t EC>
+	void gemm(quantity_span<QA, EA> a, quantity_span<QB, EB> b, quantity_span<QC, EC> c,
+		size_t m, size_t n, size_t k, CBLAS_ORDER order = CblasRowMajor)
+	{
+		using product = decltype(std::remove_cv_t<QA>() * std::remove_cv_t<QB>());
+		using NT = typename quantity_span<QC, EC>::value_type::numeric_type;
+		static_assert(std::is_same<typename product::dimension, typename QC::dimension>::value,
+			"output units don't match the product");
+		static_assert(std::is_same<typename product::numeric_type, NT>::value
+			&& (std::is_same<NT, float>::value || std::is_same<NT, double>::value),
+			"BLAS takes float or double of a single type");
+		assert(a.size() == m * k && b.size() == k * n && c.size() == m * n);
+
+		bool rowMajor = order == CblasRowMajor;
+		using folded = detail::scale_product<typename QA::scale, typename QB::scale>;
+		detail::blas::gemm(order, static_cast<int>(m), static_cast<int>(n), static_cast<int>(k),
+			folded::fold(NT(1)) * detail::blas::factor<typename product::scale, typename QC::scale, NT>(),
+			a.data(), static_cast<int>(rowMajor ? k : m),
+			b.data(), static_cast<int>(rowMajor ? n : k),
+			c.data(), static_cast<int>(rowMajor ? n : m));
+	}
+
+	// y += alpha * x, where alpha is a number or a quantity.
+	template<typename Alpha, typename QX, size_t EX, typename QY, size_t EY>
+	void axpy(Alpha alpha, quantity_span<QX, EX> x, quantity_span<QY, EY> y)
+	{
+		using x_quantity = std::remove_cv_t<QX>;
+		using term = decltype(alpha * x_quantity(1));
+		using NT = typename QY::numeric_type;
+		static_assert(std::is_same<typename term::dimension, typename QY::dimension>::value,
+			"alpha * x doesn't have the units of y");
+		static_assert(std::is_same<typename x_quantity::numeric_type, NT>::value
+			&& (std::is_same<NT, float>::value || std::is_same<NT, double>::value),
+			"BLAS takes float or double of a single type");
+		assert(x.size() == y.size());
+
+		NT scaled = static_cast<NT>((alpha * x_quantity(1)).raw_value())
+			* detail::blas::factor<typename term::scale, typename QY::scale, NT>();
+		detail::blas::axpy(static_cast<int>(x.size()), scaled, x.data(), y.data());
+	}
+
+	// The dot product of x and y, in the units of x * y.
+	template<typename QX, size_t EX, typename QY, size_t EY>
+	UNITS_ATTR_NODISCARD auto dot(quantity_span<QX, EX> x, quantity_span<QY, EY> y)
+	{
+		using product = decltype(std::remove_cv_t<QX>() * std::remove_cv_t<QY>());
+		using NT = typename product::numeric_type;
+		static_assert(std::is_same<typename QX::numeric_type, typename QY::numeric_type>::value
+			&& (std::is_same<NT, float>::value || std::is_same<NT, double>::value),
+			"BLAS takes float or double of a single type");
+		assert(x.size() == y.size());
+		using folded = detail::scale_product<typename QX::scale, typename QY::scale>;
+		return product(folded::fold(detail::blas::dot(static_cast<int>(x.size()), x.data(), y.data())));
+	}
+}
+
+#endif
@@ -0,0 +1,92 @@
+//
+// quantity_buffer.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef QUANTITY_BUFFER_HPP
+#define QUANTITY_BUFFER_HPP
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "units.hpp"
+
+namespace unitscxx
+{
+	// An allocator that default-initializes instead of value-initializing:
+	// growing a container with it leaves numbers uninitialized and builds
+	// quantities with their for_overwrite constructor, so that no memory is
+	// written until the program stores its own values. Construction with
+	// arguments is forwarded to Allocator.
+	template<typename T, typename Allocator = std::allocator<T>>
+	class default_init_allocator : public Allocator
+	{
+		using traits = std::allocator_traits<Allocator>;
+
+		template<typename U>
+		static void construct_default(U* p, std::true_type)
+		{
+			::new (static_cast<void*>(p)) U(for_overwrite);
+		}
+
+		template<typename U>
+		static void construct_default(U* p, std::false_type)
+		{
+			::new (static_cast<void*>(p)) U;
+		}
+
+	public:
+		template<typename U>
+		struct rebind
+		{
+			using other = default_init_allocator<U,
+				typename traits::template rebind_alloc<U>>;
+		};
+
+		using Allocator::Allocator;
+
+		template<typename U>
+		void construct(U* p) noexcept(std::is_nothrow_default_constructible<U>::value)
+		{
+			construct_default(p, std::is_constructible<U, for_overwrite_t>{});
+		}
+
+		template<typename U, typename... Args>
+		void construct(U* p, Args&&... args)
+		{
+			traits::construct(static_cast<Allocator&>(*this), p, std::forward<Args>(args)...);
+		}
+	};
+
+	// A vector of quantities whose size constructor and resize leave the new
+	// elements uninitialized, for buffers filled from I/O or by convert.
+	// Pass a value explicitly to get initialized elements.
+	template<typename Quantity, typename Allocator = std::allocator<Quantity>>
+	using quantity_buffer = std::vector<Quantity,
+		default_init_allocator<Quantity, Allocator>>;
+}
+
+#endif
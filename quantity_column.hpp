@@ -0,0 +1,721 @@
+//
+// quantity_column.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef QUANTITY_COLUMN_HPP
+#define QUANTITY_COLUMN_HPP
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <ratio>
+#include <type_traits>
+#include <vector>
+#include "units.hpp"
+#include "dyn_quantity.hpp"
+#include "quantity_span.hpp"
+#include "simd.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define UNITSCXX_COLUMN_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// A columnar file format for archives of quantities. Each column header
+// records the numeric type, the dimension (as its fingerprint) and the
+// scale of the numbers that follow, so reading a column as a quantity type
+// is one header check:
+//
+//   unitscxx::column_file_writer out;
+//   out.add("pressure", quantity_span<const decltype(Pa)::var>(pressures));
+//   out.add("altitude", feet.data(), feet.size(), us::ft); // numbers in feet
+//   out.write("readings.ucol");
+//
+//   unitscxx::column_file in;
+//   in.open("readings.ucol");
+//   unitscxx::quantity_column<const decltype(Pa)::var> pressure;
+//   in.column("pressure", pressure);   // column_errc::ok
+//   pressure.span();                   // the mapped numbers, not a copy
+//   unitscxx::quantity_column<const decltype(m)::var> altitude;
+//   in.column("altitude", altitude);   // stored in feet: converted on access
+//
+// Files are memory-mapped where mmap exists and read into memory otherwise.
+// Numbers are stored in the writer's byte order, and files from a machine
+// with the other byte order are rejected. Errors are returned, not thrown.
+
+namespace unitscxx
+{
+	enum class column_errc
+	{
+		ok,
+		cannot_open,        // the file can't be opened, mapped or written
+		not_a_column_file,  // the magic number doesn't match
+		unsupported,        // another version, or another byte order
+		corrupt,            // invalid headers, or data past the end of the file
+		no_such_column,     // no column has that name
+		dimension_mismatch, // the column doesn't measure what the type measures
+		lossy_scale,        // integer quantities would truncate the column's values
+	};
+
+	enum class column_type : std::uint8_t
+	{
+		float32 = 1,
+		float64,
+		int8,
+		int16,
+		int32,
+		int64,
+		uint8,
+		uint16,
+		uint32,
+		uint64,
+	};
+}
+
+namespace detail
+{
+namespace columns
+{
+	using unitscxx::column_type;
+
+	constexpr char magic[8] = {'U', 'C', 'X', 'X', 'C', 'O', 'L', '\0'};
+	constexpr std::uint32_t byte_order_mark = 0x01020304;
+	constexpr std::uint32_t version = 1;
+	constexpr size_t alignment = 64;
+	constexpr size_t name_size = 40;
+
+	struct file_header
+	{
+		char magic[8];
+		std::uint32_t byte_order;
+		std::uint32_t version;
+		std::uint64_t column_count;
+		std::uint64_t reserved;
+	};
+
+	// A stored number times factor * num / den is a number of base units.
+	struct column_header
+	{
+		char name[name_size];
+		std::uint64_t dimension;
+		std::int64_t num;
+		std::int64_t den;
+		double factor;
+		std::uint64_t offset;
+		std::uint64_t count;
+		column_type type;
+		std::uint8_t reserved[7];
+	};
+
+	static_assert(sizeof(file_header) == 32 && sizeof(column_header) == 96,
+		"column file headers are packed");
+
+	// Picked by size and kind rather than by exact type, so that long long
+	// finds the same code as the <cstdint> alias of its size.
+	template<size_t Size, bool Signed, bool Floating>
+	struct code_of;
+
+	template<> struct code_of<4, true, true> : std::integral_constant<column_type, column_type::float32> {};
+	template<> struct code_of<8, true, true> : std::integral_constant<column_type, column_type::float64> {};
+	template<> struct code_of<1, true, false> : std::integral_constant<column_type, column_type::int8> {};
+	template<> struct code_of<2, true, false> : std::integral_constant<column_type, column_type::int16> {};
+	template<> struct code_of<4, true, false> : std::integral_constant<column_type, column_type::int32> {};
+	template<> struct code_of<8, true, false> : std::integral_constant<column_type, column_type::int64> {};
+	template<> struct code_of<1, false, false> : std::integral_constant<column_type, column_type::uint8> {};
+	template<> struct code_of<2, false, false> : std::integral_constant<column_type, column_type::uint16> {};
+	template<> struct code_of<4, false, false> : std::integral_constant<column_type, column_type::uint32> {};
+	template<> struct code_of<8, false, false> : std::integral_constant<column_type, column_type::uint64> {};
+
+	template<typename T>
+	struct type_code
+		: code_of<sizeof(T), std::is_signed<T>::value, std::is_floating_point<T>::value>
+	{
+		static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value,
+			"columns hold numbers");
+	};
+
+	inline size_t size_of(column_type type)
+	{
+		switch (type)
+		{
+			case column_type::int8: case column_type::uint8: return 1;
+			case column_type::int16: case column_type::uint16: return 2;
+			case column_type::float32: case column_type::int32: case column_type::uint32: return 4;
+			case column_type::float64: case column_type::int64: case column_type::uint64: return 8;
+		}
+		return 0;
+	}
+
+	// Byte reversal written with shifts, which compilers turn into bswap.
+	inline std::uint8_t reverse_bytes(std::uint8_t value)
+	{
+		return value;
+	}
+
+	inline std::uint16_t reverse_bytes(std::uint16_t value)
+	{
+		return std::uint16_t(value << 8 | value >> 8);
+	}
+
+	inline std::uint32_t reverse_bytes(std::uint32_t value)
+	{
+		value = (value & 0x00ff00ffu) << 8 | (value >> 8 & 0x00ff00ffu);
+		return value << 16 | value >> 16;
+	}
+
+	inline std::uint64_t reverse_bytes(std::uint64_t value)
+	{
+		value = (value & 0x00ff00ff00ff00ffull) << 8 | (value >> 8 & 0x00ff00ff00ff00ffull);
+		value = (value & 0x0000ffff0000ffffull) << 16 | (value >> 16 & 0x0000ffff0000ffffull);
+		return value << 32 | value >> 32;
+	}
+
+	template<size_t Size> struct bits_of;
+	template<> struct bits_of<1> { using type = std::uint8_t; };
+	template<> struct bits_of<2> { using type = std::uint16_t; };
+	template<> struct bits_of<4> { using type = std::uint32_t; };
+	template<> struct bits_of<8> { using type = std::uint64_t; };
+
+	template<typename T>
+	T swap_bytes(T value)
+	{
+		typename bits_of<sizeof(T)>::type bits;
+		std::memcpy(&bits, &value, sizeof(T));
+		bits = reverse_bytes(bits);
+		std::memcpy(&value, &bits, sizeof(T));
+		return value;
+	}
+
+	template<typename T>
+	T swap_bytes_if(T value, bool swap)
+	{
+		return swap ? swap_bytes(value) : value;
+	}
+
+	template<typename T>
+	T load(const void* data, size_t index, bool swapped)
+	{
+		T value;
+		std::memcpy(&value, static_cast<const char*>(data) + index * sizeof(T), sizeof(T));
+		return swap_bytes_if(value, swapped);
+	}
+
+	// Element index of a column as a double, whatever its stored type.
+	inline double number_at(column_type type, const void* data, size_t index, bool swapped)
+	{
+		switch (type)
+		{
+			case column_type::float32: return load<float>(data, index, swapped);
+			case column_type::float64: return load<double>(data, index, swapped);
+			case column_type::int8: return load<std::int8_t>(data, index, swapped);
+			case column_type::int16: return load<std::int16_t>(data, index, swapped);
+			case column_type::int32: return load<std::int32_t>(data, index, swapped);
+			case column_type::int64: return double(load<std::int64_t>(data, index, swapped));
+			case column_type::uint8: return load<std::uint8_t>(data, index, swapped);
+			case column_type::uint16: return load<std::uint16_t>(data, index, swapped);
+			case column_type::uint32: return load<std::uint32_t>(data, index, swapped);
+			case column_type::uint64: return double(load<std::uint64_t>(data, index, swapped));
+		}
+		return 0;
+	}
+
+	// Points columns at numbers, for column_file and the wire decoder.
+	struct access;
+}
+}
+
+namespace unitscxx
+{
+	// A column read as Quantity. When the column holds exactly Quantity's
+	// numbers (same numeric type and scale, in this machine's byte order),
+	// span() views them where they are; otherwise values are converted as
+	// they are read, which is the case for columns written at another scale
+	// or through a unit like us::ft.
+	template<typename Quantity>
+	class quantity_column
+	{
+	public:
+		using value_type = std::remove_cv_t<Quantity>;
+		using numeric_type = typename value_type::numeric_type;
+
+	private:
+		friend struct detail::columns::access;
+
+		const void* values = nullptr;
+		size_t count = 0;
+		column_type type = detail::columns::type_code<numeric_type>::value;
+		// stored number * factor = raw value at value_type's scale
+		double factor = 1;
+		bool swapped = false;
+
+		template<typename T>
+		bool aligned() const
+		{
+			return reinterpret_cast<std::uintptr_t>(values) % alignof(T) == 0;
+		}
+
+	public:
+		UNITS_ATTR_NODISCARD size_t size() const
+		{
+			return count;
+		}
+
+		// True if span() can view the column without conversion. Columns in
+		// a buffer that isn't aligned for numeric_type are never exact.
+		UNITS_ATTR_NODISCARD bool exact() const
+		{
+			return type == detail::columns::type_code<numeric_type>::value && factor == 1 && !swapped
+				&& aligned<numeric_type>();
+		}
+
+		UNITS_ATTR_NODISCARD quantity_span<const value_type> span() const
+		{
+			assert(exact() && "this column needs a conversion: use read() or operator[]");
+			return quantity_span<const value_type>(static_cast<const numeric_type*>(values), count);
+		}
+
+		UNITS_ATTR_NODISCARD value_type operator[](size_t index) const
+		{
+			assert(index < count && "column index out of range");
+			if (exact())
+			{
+				return value_type(static_cast<const numeric_type*>(values)[index]);
+			}
+			if (std::is_integral<numeric_type>::value)
+			{
+				numeric_type number;
+				read(index, quantity_span<value_type>(&number, 1));
+				return value_type(number);
+			}
+			return value_type(static_cast<numeric_type>(
+				detail::columns::number_at(type, values, index, swapped) * factor));
+		}
+
+		// Converts out.size() values starting at first into out.
+		void read(size_t first, quantity_span<value_type> out) const
+		{
+			assert(first <= count && out.size() <= count - first && "column range out of range");
+			if (exact())
+			{
+				std::memcpy(out.data(), static_cast<const numeric_type*>(values) + first,
+					out.size() * sizeof(numeric_type));
+				return;
+			}
+			switch (type)
+			{
+				case column_type::float32: return read_as<float>(first, out);
+				case column_type::float64: return read_as<double>(first, out);
+				case column_type::int8: return read_as<std::int8_t>(first, out);
+				case column_type::int16: return read_as<std::int16_t>(first, out);
+				case column_type::int32: return read_as<std::int32_t>(first, out);
+				case column_type::int64: return read_as<std::int64_t>(first, out);
+				case column_type::uint8: return read_as<std::uint8_t>(first, out);
+				case column_type::uint16: return read_as<std::uint16_t>(first, out);
+				case column_type::uint32: return read_as<std::uint32_t>(first, out);
+				case column_type::uint64: return read_as<std::uint64_t>(first, out);
+			}
+		}
+
+	private:
+		template<typename Stored>
+		void read_as(size_t first, quantity_span<value_type> out) const
+		{
+			read_as<Stored>(first, out, std::integral_constant<bool,
+				std::is_floating_point<Stored>::value && std::is_floating_point<numeric_type>::value>{});
+		}
+
+		template<typename Stored>
+		void read_as(size_t first, quantity_span<value_type> out, std::true_type) const
+		{
+			if (swapped || !aligned<Stored>())
+			{
+				return read_as<Stored>(first, out, std::false_type{});
+			}
+			using T = std::common_type_t<Stored, numeric_type>;
+			detail::simd::affine<false>(static_cast<const Stored*>(values) + first, out.data(),
+				T(factor), T(0), out.size());
+		}
+
+		template<typename Stored>
+		void read_as(size_t first, quantity_span<value_type> out, std::false_type) const
+		{
+			using detail::columns::load;
+			using integers = std::integral_constant<bool,
+				std::is_integral<Stored>::value && std::is_integral<numeric_type>::value>;
+			numeric_type* numbers = out.data();
+			if (swapped)
+			{
+				for (size_t i = 0; i < out.size(); ++i)
+				{
+					numbers[i] = scaled(load<Stored>(values, first + i, true), integers{});
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i < out.size(); ++i)
+				{
+					numbers[i] = scaled(load<Stored>(values, first + i, false), integers{});
+				}
+			}
+		}
+
+		// Integers scale in integer arithmetic: column() only accepts whole
+		// factors for them.
+		template<typename Stored>
+		numeric_type scaled(Stored number, std::true_type) const
+		{
+			return static_cast<numeric_type>(static_cast<numeric_type>(number) * static_cast<numeric_type>(factor));
+		}
+
+		template<typename Stored>
+		numeric_type scaled(Stored number, std::false_type) const
+		{
+			return static_cast<numeric_type>(double(number) * factor);
+		}
+	};
+}
+
+namespace detail
+{
+namespace columns
+{
+	struct access
+	{
+		// factor converts stored numbers to base units at scale num / den.
+		template<typename Quantity>
+		static void assign(unitscxx::quantity_column<Quantity>& column, const void* values, size_t count,
+			column_type type, double factor, std::int64_t num, std::int64_t den, bool swapped)
+		{
+			using scale = typename std::remove_cv_t<Quantity>::scale;
+			column.values = values;
+			column.count = count;
+			column.type = type;
+			column.factor = num == scale::num && den == scale::den
+				? factor
+				: factor * (double(num) * double(scale::den)) / (double(den) * double(scale::num));
+			column.swapped = swapped;
+		}
+
+		// Whether reading the column loses nothing, by the rule that
+		// quantity conversions follow: anything converts to floating point,
+		// and integers convert to integers by whole factors.
+		template<typename Quantity>
+		static bool lossless(const unitscxx::quantity_column<Quantity>& column)
+		{
+			using numeric_type = typename std::remove_cv_t<Quantity>::numeric_type;
+			return std::is_floating_point<numeric_type>::value
+				|| (column.type != column_type::float32 && column.type != column_type::float64
+					&& column.factor >= 1 && column.factor == std::trunc(column.factor)
+					&& column.factor <= double(std::numeric_limits<numeric_type>::max()));
+		}
+	};
+}
+}
+
+namespace unitscxx
+{
+	// A column file opened for reading. Columns point into it, so it must
+	// outlive them.
+	class column_file
+	{
+		struct mapping
+		{
+			const char* bytes = nullptr;
+			size_t size = 0;
+#ifndef UNITSCXX_COLUMN_MMAP
+			std::unique_ptr<std::uint64_t[]> buffer;
+#endif
+
+			mapping() = default;
+			mapping(const mapping&) = delete;
+			mapping& operator=(const mapping&) = delete;
+
+			~mapping()
+			{
+#ifdef UNITSCXX_COLUMN_MMAP
+				if (bytes != nullptr)
+				{
+					munmap(const_cast<char*>(bytes), size);
+				}
+#endif
+			}
+		};
+
+		std::unique_ptr<mapping> file;
+		const detail::columns::column_header* headers = nullptr;
+		size_t columnCount = 0;
+
+		static column_errc map(const char* path, mapping& out)
+		{
+#ifdef UNITSCXX_COLUMN_MMAP
+			int fd = ::open(path, O_RDONLY);
+			if (fd < 0)
+			{
+				return column_errc::cannot_open;
+			}
+			struct stat info;
+			if (fstat(fd, &info) != 0)
+			{
+				::close(fd);
+				return column_errc::cannot_open;
+			}
+			if (info.st_size == 0)
+			{
+				::close(fd);
+				return column_errc::not_a_column_file;
+			}
+			void* bytes = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			::close(fd);
+			if (bytes == MAP_FAILED)
+			{
+				return column_errc::cannot_open;
+			}
+			out.bytes = static_cast<const char*>(bytes);
+			out.size = size_t(info.st_size);
+#else
+			std::FILE* stream = std::fopen(path, "rb");
+			if (stream == nullptr)
+			{
+				return column_errc::cannot_open;
+			}
+			std::fseek(stream, 0, SEEK_END);
+			long size = std::ftell(stream);
+			std::fseek(stream, 0, SEEK_SET);
+			out.size = size > 0 ? size_t(size) : 0;
+			out.buffer.reset(new std::uint64_t[(out.size + 7) / 8]);
+			bool complete = std::fread(out.buffer.get(), 1, out.size, stream) == out.size;
+			std::fclose(stream);
+			if (!complete)
+			{
+				return column_errc::cannot_open;
+			}
+			out.bytes = reinterpret_cast<const char*>(out.buffer.get());
+#endif
+			return column_errc::ok;
+		}
+
+		column_errc check() const
+		{
+			using namespace detail::columns;
+			if (file->size < sizeof(file_header))
+			{
+				return column_errc::not_a_column_file;
+			}
+			file_header header;
+			std::memcpy(&header, file->bytes, sizeof header);
+			if (std::memcmp(header.magic, magic, sizeof magic) != 0)
+			{
+				return column_errc::not_a_column_file;
+			}
+			if (header.byte_order != byte_order_mark || header.version != version)
+			{
+				return column_errc::unsupported;
+			}
+			if (header.column_count > (file->size - sizeof(file_header)) / sizeof(column_header))
+			{
+				return column_errc::corrupt;
+			}
+			
+			auto columns = reinterpret_cast<const column_header*>(file->bytes + sizeof(file_header));
+			for (size_t i = 0; i < header.column_count; ++i)
+			{
+				size_t element = size_of(columns[i].type);
+				if (element == 0 || columns[i].offset % element != 0 || columns[i].offset > file->size
+					|| columns[i].count > (file->size - columns[i].offset) / element
+					|| columns[i].num <= 0 || columns[i].den <= 0)
+				{
+					return column_errc::corrupt;
+				}
+			}
+			return column_errc::ok;
+		}
+
+	public:
+		// Replaces whatever was open before, also when opening fails.
+		column_errc open(const char* path)
+		{
+			file.reset(new mapping);
+			headers = nullptr;
+			columnCount = 0;
+			column_errc ec = map(path, *file);
+			if (ec == column_errc::ok)
+			{
+				ec = check();
+			}
+			if (ec != column_errc::ok)
+			{
+				file.reset();
+				return ec;
+			}
+			
+			detail::columns::file_header header;
+			std::memcpy(&header, file->bytes, sizeof header);
+			headers = reinterpret_cast<const detail::columns::column_header*>(
+				file->bytes + sizeof(detail::columns::file_header));
+			columnCount = size_t(header.column_count);
+			return column_errc::ok;
+		}
+
+		UNITS_ATTR_NODISCARD size_t size() const
+		{
+			return columnCount;
+		}
+
+		UNITS_ATTR_NODISCARD const char* name(size_t index) const
+		{
+			return headers[index].name;
+		}
+
+		// Checks the column's dimension against Quantity's once; the
+		// conversion factor from its scale (and unit) is computed here too.
+		// Integer quantities only read columns they can hold exactly.
+		template<typename Quantity>
+		column_errc column(const char* name, quantity_column<Quantity>& out) const
+		{
+			using value_type = std::remove_cv_t<Quantity>;
+			for (size_t i = 0; i < columnCount; ++i)
+			{
+				const auto& header = headers[i];
+				if (std::strncmp(header.name, name, detail::columns::name_size) != 0)
+				{
+					continue;
+				}
+				if (header.dimension != unitscxx::fingerprint<value_type>)
+				{
+					return column_errc::dimension_mismatch;
+				}
+				
+				quantity_column<Quantity> column;
+				detail::columns::access::assign(column, file->bytes + header.offset, size_t(header.count),
+					header.type, header.factor, header.num, header.den, false);
+				if (!detail::columns::access::lossless(column))
+				{
+					return column_errc::lossy_scale;
+				}
+				out = column;
+				return column_errc::ok;
+			}
+			return column_errc::no_such_column;
+		}
+	};
+
+	// Collects columns, then writes them to a file. The values aren't copied
+	// until write(), so they must stay alive until then.
+	class column_file_writer
+	{
+		struct pending
+		{
+			detail::columns::column_header header;
+			const void* values;
+		};
+
+		std::vector<pending> columns;
+
+		template<typename NT, typename Dimension, typename Scale>
+		void add_column(const char* name, const NT* numbers, size_t count, double factor)
+		{
+			assert(std::strlen(name) < detail::columns::name_size && "column names are up to 39 bytes");
+			pending column = {};
+			std::strncpy(column.header.name, name, detail::columns::name_size - 1);
+			column.header.dimension = dimension_fingerprint<Dimension>();
+			column.header.num = Scale::num;
+			column.header.den = Scale::den;
+			column.header.factor = factor;
+			column.header.count = count;
+			column.header.type = detail::columns::type_code<std::remove_cv_t<NT>>::value;
+			column.values = numbers;
+			columns.push_back(column);
+		}
+
+	public:
+		// Quantities, stored as their raw numbers: a reader with the same
+		// type gets them back without conversion.
+		template<typename Quantity, size_t E>
+		void add(const char* name, quantity_span<Quantity, E> values)
+		{
+			using value_type = std::remove_cv_t<Quantity>;
+			add_column<typename value_type::numeric_type, typename value_type::dimension,
+				typename value_type::scale>(name, values.data(), values.size(), 1);
+		}
+
+		// Numbers counted in unit (us::ft, si::kPa...), stored as they are.
+		// Readers convert them.
+		template<typename NT, typename UNT, typename D, typename S>
+		void add(const char* name, const NT* numbers, size_t count, quantity<UNT, D, S> unit)
+		{
+			add_column<NT, D, S>(name, numbers, count, double(unit.raw_value()));
+		}
+
+		column_errc write(const char* path) const
+		{
+			using namespace detail::columns;
+			std::FILE* stream = std::fopen(path, "wb");
+			if (stream == nullptr)
+			{
+				return column_errc::cannot_open;
+			}
+			
+			file_header header = {};
+			std::memcpy(header.magic, magic, sizeof magic);
+			header.byte_order = byte_order_mark;
+			header.version = version;
+			header.column_count = columns.size();
+			
+			std::vector<column_header> headers;
+			size_t offset = sizeof(file_header) + columns.size() * sizeof(column_header);
+			for (const auto& column : columns)
+			{
+				offset = (offset + alignment - 1) / alignment * alignment;
+				headers.push_back(column.header);
+				headers.back().offset = offset;
+				offset += size_t(column.header.count) * size_of(column.header.type);
+			}
+			
+			bool ok = std::fwrite(&header, sizeof header, 1, stream) == 1
+				&& (headers.empty() || std::fwrite(headers.data(), sizeof(column_header), headers.size(), stream) == headers.size());
+			size_t position = sizeof(file_header) + headers.size() * sizeof(column_header);
+			const char padding[alignment] = {};
+			for (size_t i = 0; ok && i < columns.size(); ++i)
+			{
+				size_t bytes = size_t(headers[i].count) * size_of(headers[i].type);
+				ok = std::fwrite(padding, 1, size_t(headers[i].offset) - position, stream) == size_t(headers[i].offset) - position
+					&& std::fwrite(columns[i].values, 1, bytes, stream) == bytes;
+				position = size_t(headers[i].offset) + bytes;
+			}
+			ok = std::fclose(stream) == 0 && ok;
+			return ok ? column_errc::ok : column_errc::cannot_open;
+		}
+	};
+}
+
+#endif
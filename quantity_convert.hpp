@@ -0,0 +1,186 @@
+//
+// quantity_convert.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef QUANTITY_CONVERT_HPP
+#define QUANTITY_CONVERT_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <ratio>
+#include <type_traits>
+#include "units.hpp"
+#include "siunits.hpp"
+#include "usunits.hpp"
+#include "quantity_point.hpp"
+#include "quantity_span.hpp"
+#include "simd.hpp"
+
+// Whole-buffer unit conversions. Each conversion is folded into one factor
+// (and one offset for temperatures) before the loop, and the loop runs
+// through the SIMD kernels of simd.hpp, converting between float and double
+// on the way when the two sides differ. The result is what a hand-written
+// `out[i] = in[i] * factor` loop computes.
+
+namespace unitscxx
+{
+	// A unit whose zero is offset from the zero of its quantity, like the
+	// temperature scales: a number x on this scale is x * step + zero.
+	template<typename Quantity>
+	struct affine_unit
+	{
+		Quantity step;
+		Quantity zero;
+	};
+
+namespace si
+{
+	constexpr affine_unit<std::remove_const_t<decltype(K)>> celsius{K, Czero};
+}
+
+namespace us
+{
+	constexpr affine_unit<std::remove_const_t<decltype(si::K)>> fahrenheit{Fdelta(1), F2K(0)};
+}
+}
+
+namespace detail
+{
+	namespace conversion
+	{
+		template<typename Unit>
+		struct unit_traits;
+
+		template<typename NT, typename D, typename S>
+		struct unit_traits<unitscxx::quantity<NT, D, S>>
+		{
+			using quantity_type = unitscxx::quantity<NT, D, S>;
+			static constexpr bool has_offset = false;
+			static constexpr quantity_type step(quantity_type unit) { return unit; }
+			static constexpr quantity_type zero(quantity_type) { return quantity_type(); }
+		};
+
+		template<typename Quantity>
+		struct unit_traits<unitscxx::affine_unit<Quantity>>
+		{
+			using quantity_type = Quantity;
+			static constexpr bool has_offset = true;
+			static constexpr quantity_type step(unitscxx::affine_unit<Quantity> unit) { return unit.step; }
+			static constexpr quantity_type zero(unitscxx::affine_unit<Quantity> unit) { return unit.zero; }
+		};
+
+		// The raw value of a quantity at scale To, in T.
+		template<typename T, typename To, typename NT, typename D, typename S>
+		constexpr T raw_at(unitscxx::quantity<NT, D, S> q)
+		{
+			return rescale<T, S, To>(q.raw_value());
+		}
+	}
+}
+
+namespace unitscxx
+{
+#pragma mark - Quantities to quantities
+	// Same units at another scale or numeric type, or points (quantity_point)
+	// at another origin. Like implicit conversions, only lossless ones compile.
+	// Floating-point sides take one multiplication, plus one addition between
+	// origins, by constants folded at compile time; integer sides convert
+	// element by element. out may view the same buffer as in.
+	template<typename From, size_t E1, typename To, size_t E2>
+	void convert(quantity_span<From, E1> in, quantity_span<To, E2> out)
+	{
+		using in_quantity = std::remove_cv_t<From>;
+		using out_quantity = std::remove_cv_t<To>;
+		using in_type = typename in_quantity::numeric_type;
+		using out_type = typename out_quantity::numeric_type;
+		using T = std::common_type_t<in_type, out_type>;
+		static_assert(std::is_same<typename in_quantity::dimension,
+			typename out_quantity::dimension>::value, "conversion between different dimensions");
+		static_assert(detail::origin_of_<in_quantity>::is_point == detail::origin_of_<out_quantity>::is_point,
+			"conversion between points and quantities");
+		static_assert(detail::is_lossless_conversion<out_type, typename out_quantity::scale,
+			in_type, typename in_quantity::scale>::value,
+			"this conversion loses precision: use the explicit constructor element by element");
+		assert(in.size() == out.size() && "converting spans of different sizes");
+
+		if (std::is_floating_point<T>::value)
+		{
+			using factor = std::ratio_divide<typename in_quantity::scale, typename out_quantity::scale>;
+			using offset = detail::origin_offset<detail::origin_of<in_quantity>,
+				detail::origin_of<out_quantity>, typename out_quantity::scale>;
+			constexpr T multiplier = static_cast<T>(factor::num) / static_cast<T>(factor::den);
+			constexpr T addend = static_cast<T>(offset::num) / static_cast<T>(offset::den);
+			detail::simd::affine<offset::num != 0>(in.data(), out.data(), multiplier, addend, in.size());
+		}
+		else
+		{
+			for (size_t i = 0; i < in.size(); ++i)
+			{
+				out[i] = out_quantity(in[i]);
+			}
+		}
+	}
+
+#pragma mark - Numbers to and from quantities
+	// Numbers counted in unit (us::ft, us::fl::oz, us::fahrenheit) into
+	// quantities: out[i] = numbers[i] * unit. Reads out.size() numbers.
+	template<typename NT, typename Unit, typename To, size_t E>
+	void convert(const NT* numbers, Unit unit, quantity_span<To, E> out)
+	{
+		using traits = detail::conversion::unit_traits<Unit>;
+		using out_quantity = std::remove_cv_t<To>;
+		using scale = typename out_quantity::scale;
+		using T = std::common_type_t<NT, typename out_quantity::numeric_type>;
+		static_assert(std::is_same<typename traits::quantity_type::dimension,
+			typename out_quantity::dimension>::value, "conversion between different dimensions");
+		static_assert(std::is_floating_point<T>::value,
+			"conversions through a unit value need floating-point numbers");
+
+		T factor = detail::conversion::raw_at<T, scale>(traits::step(unit));
+		T offset = detail::conversion::raw_at<T, scale>(traits::zero(unit));
+		detail::simd::affine<traits::has_offset>(numbers, out.data(), factor, offset, out.size());
+	}
+
+	// Quantities as numbers counted in unit: numbers[i] = in[i] / unit, as a
+	// multiplication by the reciprocal. Writes in.size() numbers.
+	template<typename From, size_t E, typename Unit, typename NT>
+	void convert(quantity_span<From, E> in, Unit unit, NT* numbers)
+	{
+		using traits = detail::conversion::unit_traits<Unit>;
+		using in_quantity = std::remove_cv_t<From>;
+		using scale = typename in_quantity::scale;
+		using T = std::common_type_t<NT, typename in_quantity::numeric_type>;
+		static_assert(std::is_same<typename traits::quantity_type::dimension,
+			typename in_quantity::dimension>::value, "conversion between different dimensions");
+		static_assert(std::is_floating_point<T>::value,
+			"conversions through a unit value need floating-point numbers");
+
+		T step = detail::conversion::raw_at<T, scale>(traits::step(unit));
+		T zero = detail::conversion::raw_at<T, scale>(traits::zero(unit));
+		detail::simd::affine<traits::has_offset>(in.data(), numbers, 1 / step, -zero / step, in.size());
+	}
+}
+
+#endif
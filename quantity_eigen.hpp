@@ -0,0 +1,222 @@
+//
+// quantity_eigen.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef QUANTITY_EIGEN_HPP
+#define QUANTITY_EIGEN_HPP
+
+#include <type_traits>
+#include <Eigen/Core>
+#include "units.hpp"
+
+// Opt-in Eigen support. Including this header registers quantities as Eigen
+// scalars, so that Eigen::Matrix<quantity> stores them and computes sums,
+// scaling, coefficient-wise products, sum(), trace(), minCoeff() and
+// maxCoeff() with units. Eigen's mean(), dot(), squaredNorm(), norm() and
+// prod() return the scalar type, which is wrong for units, and don't
+// compile: use unitscxx::mean, dot, squared_norm and norm instead.
+//
+// Eigen's packet math and matrix product kernels assume that a product of two
+// scalars has the type of its operands, which a quantity times a quantity
+// never does: Eigen::Matrix<quantity> products don't compile, and its
+// coefficient-wise operations run scalar code. For speed, raw_matrix() views
+// the storage as an Eigen matrix of the numeric type, zero-copy, where
+// everything vectorizes; with_units() views it back, and matrix_product()
+// multiplies through the numeric kernel and returns the derived units.
+
+namespace Eigen
+{
+	template<typename NT, typename D, typename S>
+	struct NumTraits<unitscxx::quantity<NT, D, S>> : NumTraits<NT>
+	{
+		using Real = unitscxx::quantity<NT, D, S>;
+		using NonInteger = unitscxx::quantity<typename NumTraits<NT>::NonInteger, D, S>;
+		using Nested = Real;
+		using Literal = NT;
+
+		static inline Real epsilon() { return Real(NumTraits<NT>::epsilon()); }
+		static inline Real dummy_precision() { return Real(NumTraits<NT>::dummy_precision()); }
+		static inline Real highest() { return Real(NumTraits<NT>::highest()); }
+		static inline Real lowest() { return Real(NumTraits<NT>::lowest()); }
+	};
+
+#pragma mark - Mixed scalar types
+	// Coefficient-wise products and quotients between quantities, and scaling
+	// by numbers. The same-type specializations are needed to win over Eigen's
+	// ScalarBinaryOpTraits<T, T, Op>, which would keep the operand units.
+
+	template<typename NT1, typename D1, typename S1, typename NT2, typename D2, typename S2>
+	struct ScalarBinaryOpTraits<unitscxx::quantity<NT1, D1, S1>, unitscxx::quantity<NT2, D2, S2>,
+		internal::scalar_product_op<unitscxx::quantity<NT1, D1, S1>, unitscxx::quantity<NT2, D2, S2>>>
+	{
+		using ReturnType = decltype(unitscxx::quantity<NT1, D1, S1>() * unitscxx::quantity<NT2, D2, S2>());
+	};
+
+	template<typename NT, typename D, typename S>
+	struct ScalarBinaryOpTraits<unitscxx::quantity<NT, D, S>, unitscxx::quantity<NT, D, S>,
+		internal::scalar_product_op<unitscxx::quantity<NT, D, S>, unitscxx::quantity<NT, D, S>>>
+	{
+		using ReturnType = decltype(unitscxx::quantity<NT, D, S>() * unitscxx::quantity<NT, D, S>());
+	};
+
+	template<typename NT1, typename D1, typename S1, typename NT2, typename D2, typename S2>
+	struct ScalarBinaryOpTraits<unitscxx::quantity<NT1, D1, S1>, unitscxx::quantity<NT2, D2, S2>,
+		internal::scalar_quotient_op<unitscxx::quantity<NT1, D1, S1>, unitscxx::quantity<NT2, D2, S2>>>
+	{
+		using ReturnType = decltype(unitscxx::quantity<NT1, D1, S1>() / unitscxx::quantity<NT2, D2, S2>());
+	};
+
+	template<typename NT, typename D, typename S>
+	struct ScalarBinaryOpTraits<unitscxx::quantity<NT, D, S>, unitscxx::quantity<NT, D, S>,
+		internal::scalar_quotient_op<unitscxx::quantity<NT, D, S>, unitscxx::quantity<NT, D, S>>>
+	{
+		using ReturnType = decltype(unitscxx::quantity<NT, D, S>() / unitscxx::quantity<NT, D, S>());
+	};
+
+	template<typename NT, typename D, typename S>
+	struct ScalarBinaryOpTraits<unitscxx::quantity<NT, D, S>, NT,
+		internal::scalar_product_op<unitscxx::quantity<NT, D, S>, NT>>
+	{
+		using ReturnType = unitscxx::quantity<NT, D, S>;
+	};
+
+	template<typename NT, typename D, typename S>
+	struct ScalarBinaryOpTraits<NT, unitscxx::quantity<NT, D, S>,
+		internal::scalar_product_op<NT, unitscxx::quantity<NT, D, S>>>
+	{
+		using ReturnType = unitscxx::quantity<NT, D, S>;
+	};
+
+	template<typename NT, typename D, typename S>
+	struct ScalarBinaryOpTraits<unitscxx::quantity<NT, D, S>, NT,
+		internal::scalar_quotient_op<unitscxx::quantity<NT, D, S>, NT>>
+	{
+		using ReturnType = unitscxx::quantity<NT, D, S>;
+	};
+}
+
+namespace detail
+{
+	template<typename Quantity>
+	struct eigen_layout_check
+	{
+		static_assert(unitscxx::has_numeric_layout<Quantity>::value,
+			"quantity must have the same layout as its numeric type");
+		using type = typename Quantity::numeric_type;
+	};
+
+	template<typename Quantity>
+	using eigen_numeric_type = typename eigen_layout_check<Quantity>::type;
+}
+
+namespace unitscxx
+{
+#pragma mark - Zero-copy views
+	// The storage of a matrix of quantities as a matrix of numbers.
+	template<typename Q, int R, int C, int O, int MR, int MC>
+	auto raw_matrix(Eigen::Matrix<Q, R, C, O, MR, MC>& m)
+	{
+		using raw = Eigen::Matrix<detail::eigen_numeric_type<Q>, R, C, O, MR, MC>;
+		return Eigen::Map<raw>(reinterpret_cast<typename raw::Scalar*>(m.data()), m.rows(), m.cols());
+	}
+
+	template<typename Q, int R, int C, int O, int MR, int MC>
+	auto raw_matrix(const Eigen::Matrix<Q, R, C, O, MR, MC>& m)
+	{
+		using raw = Eigen::Matrix<detail::eigen_numeric_type<Q>, R, C, O, MR, MC>;
+		return Eigen::Map<const raw>(reinterpret_cast<const typename raw::Scalar*>(m.data()), m.rows(), m.cols());
+	}
+
+	// The storage of a matrix of numbers as a matrix of Quantity.
+	template<typename Quantity, typename NT, int R, int C, int O, int MR, int MC>
+	auto with_units(Eigen::Matrix<NT, R, C, O, MR, MC>& m)
+	{
+		static_assert(std::is_same<detail::eigen_numeric_type<Quantity>, NT>::value,
+			"with_units needs a matrix of the quantity's numeric type");
+		using typed = Eigen::Matrix<Quantity, R, C, O, MR, MC>;
+		return Eigen::Map<typed>(reinterpret_cast<Quantity*>(m.data()), m.rows(), m.cols());
+	}
+
+	template<typename Quantity, typename NT, int R, int C, int O, int MR, int MC>
+	auto with_units(const Eigen::Matrix<NT, R, C, O, MR, MC>& m)
+	{
+		static_assert(std::is_same<detail::eigen_numeric_type<Quantity>, NT>::value,
+			"with_units needs a matrix of the quantity's numeric type");
+		using typed = Eigen::Matrix<Quantity, R, C, O, MR, MC>;
+		return Eigen::Map<const typed>(reinterpret_cast<const Quantity*>(m.data()), m.rows(), m.cols());
+	}
+
+#pragma mark - Matrix product
+	// a * b with derived units, computed by Eigen's vectorized product kernel on
+	// the raw values. Scales multiply like for single quantities.
+	template<typename QA, int RA, int CA, int OA, int MRA, int MCA,
+		typename QB, int RB, int CB, int OB, int MRB, int MCB>
+	auto matrix_product(const Eigen::Matrix<QA, RA, CA, OA, MRA, MCA>& a,
+		const Eigen::Matrix<QB, RB, CB, OB, MRB, MCB>& b)
+	{
+		using product = detail::scale_product<typename QA::scale, typename QB::scale>;
+		using result_quantity = decltype(QA() * QB());
+		Eigen::Matrix<result_quantity, RA, CB> result(a.rows(), b.cols());
+		raw_matrix(result).noalias() = raw_matrix(a) * raw_matrix(b);
+		if (!product::fits)
+		{
+			raw_matrix(result) *= product::fold(typename result_quantity::numeric_type(1));
+		}
+		return result;
+	}
+
+#pragma mark - Reductions
+	// Reductions whose units Eigen can't express, computed on the raw values.
+	template<typename Q, int R, int C, int O, int MR, int MC>
+	UNITS_ATTR_NODISCARD Q mean(const Eigen::Matrix<Q, R, C, O, MR, MC>& m)
+	{
+		return Q(raw_matrix(m).mean());
+	}
+
+	template<typename QA, int RA, int CA, int OA, int MRA, int MCA,
+		typename QB, int RB, int CB, int OB, int MRB, int MCB>
+	UNITS_ATTR_NODISCARD auto dot(const Eigen::Matrix<QA, RA, CA, OA, MRA, MCA>& a,
+		const Eigen::Matrix<QB, RB, CB, OB, MRB, MCB>& b)
+	{
+		using product = detail::scale_product<typename QA::scale, typename QB::scale>;
+		using result_quantity = decltype(QA() * QB());
+		return result_quantity(product::fold(raw_matrix(a).dot(raw_matrix(b))));
+	}
+
+	template<typename Q, int R, int C, int O, int MR, int MC>
+	UNITS_ATTR_NODISCARD auto squared_norm(const Eigen::Matrix<Q, R, C, O, MR, MC>& m)
+	{
+		using product = detail::scale_product<typename Q::scale, typename Q::scale>;
+		return decltype(Q() * Q())(product::fold(raw_matrix(m).squaredNorm()));
+	}
+
+	template<typename Q, int R, int C, int O, int MR, int MC>
+	UNITS_ATTR_NODISCARD Q norm(const Eigen::Matrix<Q, R, C, O, MR, MC>& m)
+	{
+		return Q(raw_matrix(m).norm());
+	}
+}
+
+#endif
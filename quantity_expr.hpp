@@ -0,0 +1,528 @@
+//
+// quantity_expr.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef QUANTITY_EXPR_HPP
+#define QUANTITY_EXPR_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <ratio>
+#include <type_traits>
+#include <utility>
+#include "units.hpp"
+#include "simd.hpp"
+
+// Lazy arithmetic over containers of quantities. Operators on quantity_array
+// and quantity_span build an expression tree whose units are computed at
+// compile time with quantity's own operators. Nothing is calculated until the
+// tree is assigned to a container: then it is evaluated in one pass over
+// memory, block by block, with every block of intermediate values kept on the
+// stack and run through the SIMD kernels.
+//
+// Containers used as lvalues are referenced; temporaries are moved into the
+// expression, so an expression can safely outlive the statement that built
+// it as long as its lvalue operands do.
+
+namespace detail
+{
+namespace expr
+{
+	// Elements per block: large enough to amortize the tree walk, small enough
+	// that the intermediate blocks stay in L1.
+	constexpr size_t block_size = 256;
+
+#pragma mark - Operand traits
+	// Specialized by the containers that can appear in expressions.
+	template<typename T>
+	struct is_range : std::false_type
+	{
+	};
+
+	template<typename T>
+	struct is_node : std::false_type
+	{
+	};
+
+	template<typename T>
+	struct is_quantity : std::false_type
+	{
+	};
+
+	template<typename NT, typename D, typename S>
+	struct is_quantity<unitscxx::quantity<NT, D, S>> : std::true_type
+	{
+	};
+
+	template<typename T>
+	using is_operand = std::integral_constant<bool,
+		is_range<std::decay_t<T>>::value || is_node<std::decay_t<T>>::value>;
+
+	template<typename T>
+	using is_scalar = std::integral_constant<bool,
+		std::is_arithmetic<std::decay_t<T>>::value
+		|| is_quantity<std::decay_t<T>>::value>;
+
+	template<typename A, typename B>
+	using is_binary = std::integral_constant<bool,
+		(is_operand<A>::value && (is_operand<B>::value || is_scalar<B>::value))
+		|| (is_scalar<A>::value && is_operand<B>::value)>;
+
+	constexpr size_t common_extent(size_t a, size_t b)
+	{
+		return a == unitscxx::dynamic_extent ? b : a;
+	}
+
+#pragma mark - Leaves
+	// Storage is `const Container&` for lvalues and `Container` for rvalues.
+	template<typename Storage>
+	struct terminal
+	{
+		using container_type = std::decay_t<Storage>;
+		using value_type = typename container_type::value_type;
+		using numeric_type = std::remove_cv_t<typename container_type::numeric_type>;
+		static constexpr size_t extent = container_type::extent;
+		static constexpr bool is_scalar = false;
+
+		Storage container;
+
+		size_t size() const
+		{
+			return container.size();
+		}
+
+		const numeric_type* operand(size_t begin, size_t, numeric_type*) const
+		{
+			return container.data() + begin;
+		}
+
+		bool overlaps(const void* begin, const void* end) const
+		{
+			std::less<const void*> less;
+			const void* data = container.data();
+			const void* data_end = container.data() + container.size();
+			return less(data, end) && less(begin, data_end);
+		}
+	};
+
+	template<typename Value>
+	struct scalar
+	{
+		using value_type = Value;
+		using numeric_type = void; // takes the numeric type of the container
+		static constexpr size_t extent = unitscxx::dynamic_extent;
+		static constexpr bool is_scalar = true;
+
+		Value value;
+
+		scalar(Value value) : value(value)
+		{
+		}
+
+		template<typename V>
+		scalar(const scalar<V>& that) : value(that.value)
+		{
+		}
+
+		size_t size() const
+		{
+			return unitscxx::dynamic_extent;
+		}
+
+		template<typename NT, typename V = Value, typename =
+			std::enable_if_t<std::is_arithmetic<V>::value>>
+		NT operand(size_t, size_t, NT*) const
+		{
+			return static_cast<NT>(value);
+		}
+
+		template<typename NT, typename V = Value, typename =
+			std::enable_if_t<!std::is_arithmetic<V>::value>, typename = void>
+		NT operand(size_t, size_t, NT*) const
+		{
+			return static_cast<NT>(value.raw_value());
+		}
+
+		bool overlaps(const void*, const void*) const
+		{
+			return false;
+		}
+	};
+
+#pragma mark - Operations
+	template<typename Op>
+	using is_additive = std::integral_constant<bool,
+		std::is_same<Op, simd::add_op>::value || std::is_same<Op, simd::sub_op>::value>;
+
+	// Additions and subtractions happen at the common scale of both sides.
+	// Single quantities are converted to it once, when the expression is
+	// built; containers are never rescaled, so they must already be at it.
+	template<typename Op, typename Node, typename Result, typename = void>
+	struct scaled_operand
+	{
+		using type = Node;
+	};
+
+	template<typename Op, typename Value, typename Result>
+	struct scaled_operand<Op, scalar<Value>, Result, std::enable_if_t<
+		is_additive<Op>::value && is_quantity<Value>::value>>
+	{
+		using type = scalar<Result>;
+	};
+
+	template<typename Op, typename Node, typename Result, typename = void>
+	struct check_scale : std::true_type
+	{
+	};
+
+	template<typename Op, typename Node, typename Result>
+	struct check_scale<Op, Node, Result, std::enable_if_t<
+		is_additive<Op>::value && !Node::is_scalar>>
+	: std::is_same<typename Node::value_type::scale, typename Result::scale>
+	{
+	};
+
+	// Products and quotients whose scale overflows std::ratio fold it into
+	// the numbers, like quantity's * and / do.
+	template<typename Op, typename L, typename R, typename = void>
+	struct scale_fold
+	{
+		using type = scale_product<std::ratio<1>, std::ratio<1>>;
+	};
+
+	template<typename L, typename R>
+	struct scale_fold<simd::mul_op, L, R, std::enable_if_t<
+		is_quantity<L>::value && is_quantity<R>::value>>
+	{
+		using type = scale_product<typename L::scale, typename R::scale>;
+	};
+
+	template<typename L, typename R>
+	struct scale_fold<simd::div_op, L, R, std::enable_if_t<
+		is_quantity<L>::value && is_quantity<R>::value>>
+	{
+		using type = scale_quotient<typename L::scale, typename R::scale>;
+	};
+
+	template<typename Op, typename L, typename R>
+	struct binary
+	{
+		static_assert(!L::is_scalar || !R::is_scalar,
+			"expression without a container operand");
+		static_assert(L::is_scalar || R::is_scalar
+			|| std::is_same<typename L::numeric_type, typename R::numeric_type>::value,
+			"quantity containers in an expression must have the same numeric type");
+		static_assert(L::extent == unitscxx::dynamic_extent
+			|| R::extent == unitscxx::dynamic_extent || L::extent == R::extent,
+			"quantity containers in an expression have different extents");
+
+		using value_type = std::remove_cv_t<decltype(Op::apply(
+			std::declval<typename L::value_type>(),
+			std::declval<typename R::value_type>()))>;
+		using numeric_type = typename std::conditional_t<L::is_scalar, R, L>::numeric_type;
+		static constexpr size_t extent = common_extent(L::extent, R::extent);
+		static constexpr bool is_scalar = false;
+		using fold = typename scale_fold<Op, typename L::value_type, typename R::value_type>::type;
+
+		static_assert(fold::fits || std::is_floating_point<numeric_type>::value,
+			"the scales of integer containers overflow std::ratio: use floating point");
+		static_assert(check_scale<Op, L, value_type>::value
+			&& check_scale<Op, R, value_type>::value,
+			"adding containers at different scales: convert one of them first");
+
+		typename scaled_operand<Op, L, value_type>::type left;
+		typename scaled_operand<Op, R, value_type>::type right;
+
+		binary(L left, R right) : left(std::move(left)), right(std::move(right))
+		{
+			assert((L::is_scalar || R::is_scalar || this->left.size() == this->right.size())
+				&& "quantity containers in an expression have different sizes");
+		}
+
+		size_t size() const
+		{
+			return std::min(left.size(), right.size());
+		}
+
+		// Evaluates [begin, begin + count) into out, which the left operand
+		// also gets to use as its scratch space.
+		const numeric_type* operand(size_t begin, size_t count, numeric_type* out) const
+		{
+			numeric_type scratch[block_size];
+			auto a = left.operand(begin, count, out);
+			auto b = right.operand(begin, count, scratch);
+			simd::apply(Op{}, a, b, out, count);
+			if (!fold::fits)
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					out[i] = fold::fold(out[i]);
+				}
+			}
+			return out;
+		}
+
+		bool overlaps(const void* begin, const void* end) const
+		{
+			return left.overlaps(begin, end) || right.overlaps(begin, end);
+		}
+	};
+
+	template<typename Op, typename L, typename R>
+	struct is_node<binary<Op, L, R>> : std::true_type
+	{
+	};
+
+	template<typename T, typename = std::enable_if_t<is_node<std::decay_t<T>>::value>>
+	std::decay_t<T> make_node(T&& node)
+	{
+		return std::forward<T>(node);
+	}
+
+	template<typename T, typename = std::enable_if_t<is_range<std::decay_t<T>>::value>,
+		typename = void>
+	terminal<std::conditional_t<std::is_lvalue_reference<T>::value,
+		const std::decay_t<T>&, std::decay_t<T>>> make_node(T&& range)
+	{
+		return {std::forward<T>(range)};
+	}
+
+	template<typename T, typename = std::enable_if_t<is_scalar<T>::value>,
+		typename = void, typename = void>
+	scalar<std::decay_t<T>> make_node(T&& value)
+	{
+		return {value};
+	}
+
+	template<typename Op, typename A, typename B>
+	auto make_binary(Op, A&& a, B&& b)
+	{
+		using left = decltype(make_node(std::forward<A>(a)));
+		using right = decltype(make_node(std::forward<B>(b)));
+		return binary<Op, left, right>(make_node(std::forward<A>(a)),
+			make_node(std::forward<B>(b)));
+	}
+
+#pragma mark - Scales
+	// The same numbers under other units. std::ratio factors only change the
+	// scale of the value type, like they do on quantity, and cost nothing.
+	template<typename Node, typename Value>
+	struct relabeled
+	{
+		using value_type = Value;
+		using numeric_type = typename Node::numeric_type;
+		static constexpr size_t extent = Node::extent;
+		static constexpr bool is_scalar = false;
+
+		Node node;
+
+		size_t size() const
+		{
+			return node.size();
+		}
+
+		const numeric_type* operand(size_t begin, size_t count, numeric_type* out) const
+		{
+			return node.operand(begin, count, out);
+		}
+
+		bool overlaps(const void* begin, const void* end) const
+		{
+			return node.overlaps(begin, end);
+		}
+	};
+
+	template<typename Node, typename Value>
+	struct is_node<relabeled<Node, Value>> : std::true_type
+	{
+	};
+
+	template<typename A, typename Ratio>
+	auto scale(A&& a, Ratio)
+	{
+		using node = decltype(make_node(std::forward<A>(a)));
+		using value = typename node::value_type;
+		using result = unitscxx::quantity<typename value::numeric_type,
+			typename value::dimension,
+			std::ratio_multiply<typename value::scale, Ratio>>;
+		return relabeled<node, result>{make_node(std::forward<A>(a))};
+	}
+
+	// Converts an expression to another scale of the same units when it is
+	// assigned, with one constant factor per element.
+	template<typename Node, typename Value>
+	struct converted
+	{
+		using value_type = Value;
+		using numeric_type = typename Node::numeric_type;
+		using factor = std::ratio_divide<typename Node::value_type::scale,
+			typename Value::scale>;
+
+		const Node& node;
+
+		size_t size() const
+		{
+			return node.size();
+		}
+
+		const numeric_type* operand(size_t begin, size_t count, numeric_type* out) const
+		{
+			const numeric_type* values = node.operand(begin, count, out);
+			if (std::is_floating_point<numeric_type>::value)
+			{
+				simd::apply(simd::mul_op{}, values,
+					numeric_type(factor::num) / numeric_type(factor::den), out, count);
+				return out;
+			}
+			if (factor::num != 1)
+			{
+				simd::apply(simd::mul_op{}, values, numeric_type(factor::num), out, count);
+				values = out;
+			}
+			if (factor::den != 1)
+			{
+				simd::apply(simd::div_op{}, values, numeric_type(factor::den), out, count);
+				values = out;
+			}
+			return values;
+		}
+
+		bool overlaps(const void* begin, const void* end) const
+		{
+			return node.overlaps(begin, end);
+		}
+	};
+
+#pragma mark - Evaluation
+	// Writes the expression into count numbers at out. When out is also read
+	// by the expression (a = b + a), blocks go through a stack buffer first.
+	template<typename Node, typename NT>
+	void evaluate(const Node& node, NT* out, size_t count)
+	{
+		bool aliased = node.overlaps(out, out + count);
+		NT buffer[block_size];
+		for (size_t begin = 0; begin < count; begin += block_size)
+		{
+			size_t n = std::min(block_size, count - begin);
+			NT* target = aliased ? buffer : out + begin;
+			const NT* result = node.operand(begin, n, target);
+			if (result != out + begin)
+			{
+				std::copy(result, result + n, out + begin);
+			}
+		}
+	}
+
+	// Assigns an expression to count quantities of type Value at out. The
+	// expression is converted when it has the same units at another scale,
+	// under the same rules as quantity's implicit conversions.
+	template<typename Value, typename Node, typename NT>
+	void assign(const Node& node, NT* out, size_t count)
+	{
+		using from = typename Node::value_type;
+		static_assert(std::is_same<typename Node::numeric_type, NT>::value,
+			"assigning an expression with a different numeric type");
+		static_assert(std::is_convertible<from, Value>::value,
+			"assigning an expression with different units");
+		assert(node.size() == count && "quantity container size mismatch");
+		using needs_conversion = std::integral_constant<bool,
+			!std::is_same<typename from::scale, typename Value::scale>::value>;
+		assign(node, out, count, static_cast<Value*>(nullptr), needs_conversion{});
+	}
+
+	template<typename Value, typename Node, typename NT>
+	void assign(const Node& node, NT* out, size_t count, Value*, std::false_type)
+	{
+		evaluate(node, out, count);
+	}
+
+	template<typename Value, typename Node, typename NT>
+	void assign(const Node& node, NT* out, size_t count, Value*, std::true_type)
+	{
+		evaluate(converted<Node, Value>{node}, out, count);
+	}
+}
+}
+
+namespace unitscxx
+{
+#pragma mark - Operators
+	template<typename A, typename B, typename =
+		std::enable_if_t<detail::expr::is_binary<A, B>::value>>
+	UNITS_ATTR_NODISCARD auto operator+(A&& a, B&& b)
+	{
+		return detail::expr::make_binary(detail::simd::add_op{},
+			std::forward<A>(a), std::forward<B>(b));
+	}
+
+	template<typename A, typename B, typename =
+		std::enable_if_t<detail::expr::is_binary<A, B>::value>>
+	UNITS_ATTR_NODISCARD auto operator-(A&& a, B&& b)
+	{
+		return detail::expr::make_binary(detail::simd::sub_op{},
+			std::forward<A>(a), std::forward<B>(b));
+	}
+
+	template<typename A, typename B, typename =
+		std::enable_if_t<detail::expr::is_binary<A, B>::value>>
+	UNITS_ATTR_NODISCARD auto operator*(A&& a, B&& b)
+	{
+		return detail::expr::make_binary(detail::simd::mul_op{},
+			std::forward<A>(a), std::forward<B>(b));
+	}
+
+	template<typename A, typename B, typename =
+		std::enable_if_t<detail::expr::is_binary<A, B>::value>>
+	UNITS_ATTR_NODISCARD auto operator/(A&& a, B&& b)
+	{
+		return detail::expr::make_binary(detail::simd::div_op{},
+			std::forward<A>(a), std::forward<B>(b));
+	}
+
+	template<typename A, intmax_t N, intmax_t D, typename =
+		std::enable_if_t<detail::expr::is_operand<A>::value>>
+	UNITS_ATTR_NODISCARD auto operator*(A&& a, std::ratio<N, D> r)
+	{
+		return detail::expr::scale(std::forward<A>(a), r);
+	}
+
+	template<intmax_t N, intmax_t D, typename A, typename =
+		std::enable_if_t<detail::expr::is_operand<A>::value>>
+	UNITS_ATTR_NODISCARD auto operator*(std::ratio<N, D> r, A&& a)
+	{
+		return detail::expr::scale(std::forward<A>(a), r);
+	}
+
+	template<typename A, intmax_t N, intmax_t D, typename =
+		std::enable_if_t<detail::expr::is_operand<A>::value>>
+	UNITS_ATTR_NODISCARD auto operator/(A&& a, std::ratio<N, D>)
+	{
+		return detail::expr::scale(std::forward<A>(a), std::ratio<D, N>{});
+	}
+}
+
+#endif
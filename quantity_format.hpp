@@ -0,0 +1,526 @@
+//
+// quantity_format.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef QUANTITY_FORMAT_HPP
+#define QUANTITY_FORMAT_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <system_error>
+#include <type_traits>
+#include "units.hpp"
+#include "siunits.hpp"
+#include "unit_registry.hpp"
+#include "quantity_parse.hpp"
+
+#if defined(__has_include)
+#if __has_include(<version>)
+#include <version>
+#endif
+#endif
+#if defined(__cpp_lib_format)
+#include <algorithm>
+#include <format>
+#endif
+
+// Writes quantities as text with their units ("9.81 m/s²"), into a buffer
+// that the caller owns, like std::to_chars. The unit string of each quantity
+// type is built at compile time from the exponents of its dimension. The
+// output reads back with from_chars from quantity_parse.hpp.
+//
+// When <format> is available, quantities work with std::format; when fmt is
+// included before this header, they work with fmt::format. The format spec
+// applies to the number: std::format("{:.2f}", speed) gives "12.50 m/s".
+
+namespace unitscxx
+{
+	enum class unit_style
+	{
+		unicode, // kg·m²/s²
+		ascii,   // kg*m^2/s^2
+	};
+
+	// The symbols that make up unit strings, for each base unit of a unit
+	// system. Specialize this for your own unit enums. decimal() is the power
+	// of ten that the symbol stands for, in base units: the SI base unit of
+	// mass is the kilogram, but the enum counts grams.
+	template<typename UnitType>
+	struct unit_symbols;
+
+	template<>
+	struct unit_symbols<si::units>
+	{
+		static constexpr const char* symbol(size_t unit)
+		{
+			const char* symbols[] = {"m", "kg", "s", "A", "K", "mol", "cd"};
+			return symbols[unit];
+		}
+
+		static constexpr int decimal(size_t unit)
+		{
+			return unit == si::gram ? 3 : 0;
+		}
+	};
+
+	struct to_chars_result
+	{
+		char* ptr;
+		std::errc ec;
+	};
+}
+
+namespace detail
+{
+namespace format
+{
+	using unitscxx::unit_style;
+
+#pragma mark - Unit strings
+	template<size_t N>
+	struct fixed_string
+	{
+		char data[N + 1];
+
+		UNITS_ATTR_NODISCARD constexpr const char* c_str() const { return data; }
+		UNITS_ATTR_NODISCARD static constexpr size_t size() { return N; }
+	};
+
+	// Appends text at out[n], or only counts it when out is null.
+	constexpr void put(char* out, size_t& n, const char* text)
+	{
+		for (; *text != 0; ++text, ++n)
+		{
+			if (out != nullptr)
+			{
+				out[n] = *text;
+			}
+		}
+	}
+
+	constexpr void put_exponent(char* out, size_t& n, int exponent, unit_style style)
+	{
+		if (exponent == 1)
+		{
+			return;
+		}
+		const char* superscripts[] = {"⁰", "¹", "²", "³", "⁴", "⁵", "⁶", "⁷", "⁸", "⁹"};
+		const char* digits[] = {"0", "1", "2", "3", "4", "5", "6", "7", "8", "9"};
+		const char* const* glyphs = style == unit_style::unicode ? superscripts : digits;
+		if (style == unit_style::ascii)
+		{
+			put(out, n, "^");
+		}
+		int magnitude = 1;
+		while (magnitude * 10 <= exponent)
+		{
+			magnitude *= 10;
+		}
+		for (; magnitude != 0; magnitude /= 10)
+		{
+			put(out, n, glyphs[exponent / magnitude % 10]);
+		}
+	}
+
+	// Writes the factors with a positive (Sign = 1) or negative (Sign = -1)
+	// exponent, in the order of the unit enum.
+	template<typename Dim>
+	constexpr bool put_factors(char* out, size_t& n, int sign, unit_style style)
+	{
+		using symbols = unitscxx::unit_symbols<typename Dim::value_type>;
+		bool any = false;
+		for (size_t i = 0; i < Dim::size; ++i)
+		{
+			int exponent = sign * exponent_at(Dim{}, i);
+			if (exponent > 0)
+			{
+				if (any)
+				{
+					put(out, n, style == unit_style::unicode ? "·" : "*");
+				}
+				put(out, n, symbols::symbol(i));
+				put_exponent(out, n, exponent, style);
+				any = true;
+			}
+		}
+		return any;
+	}
+
+	// "m·kg/s²", "1/s", or "" for dimensionless quantities. Counts the
+	// characters when out is null.
+	template<typename Dim>
+	constexpr size_t write_unit(char* out, unit_style style)
+	{
+		static_assert(Dim::denominator == 1,
+			"fractional exponents have no unit string");
+		size_t n = 0;
+		bool numerator = put_factors<Dim>(out, n, 1, style);
+		size_t denominator = 0;
+		if (put_factors<Dim>(nullptr, denominator, -1, style))
+		{
+			put(out, n, numerator ? "/" : "1/");
+			put_factors<Dim>(out, n, -1, style);
+		}
+		return n;
+	}
+
+	template<typename Dim, unit_style Style>
+	constexpr fixed_string<write_unit<Dim>(nullptr, Style)> make_unit_string()
+	{
+		fixed_string<write_unit<Dim>(nullptr, Style)> result{};
+		write_unit<Dim>(result.data, Style);
+		return result;
+	}
+
+#pragma mark - Values
+	// The power of ten that the unit string stands for in raw units.
+	template<typename Dim>
+	constexpr int base_decimal()
+	{
+		using symbols = unitscxx::unit_symbols<typename Dim::value_type>;
+		int decimal = 0;
+		for (size_t i = 0; i < Dim::size; ++i)
+		{
+			decimal += exponent_at(Dim{}, i) * symbols::decimal(i);
+		}
+		return decimal;
+	}
+
+	// Turns the raw value of Quantity into a number of the units written by
+	// its unit string.
+	template<typename Quantity>
+	constexpr parse::conversion canonical_conversion()
+	{
+		using scale = typename Quantity::scale;
+		constexpr int numDecimal = parse::decimal_exponent(scale::num);
+		constexpr int denDecimal = parse::decimal_exponent(scale::den);
+		parse::conversion result;
+		result.factor = (numDecimal == 0 ? static_cast<double>(scale::num) : 1.0)
+			/ (denDecimal == 0 ? static_cast<double>(scale::den) : 1.0);
+		result.decimal = numDecimal - denDecimal
+			- base_decimal<typename Quantity::dimension>();
+		return result;
+	}
+
+	template<typename Quantity>
+	constexpr bool is_canonical()
+	{
+		return canonical_conversion<Quantity>().factor == 1
+			&& canonical_conversion<Quantity>().decimal == 0;
+	}
+
+	// Integer quantities are written as integers when their raw value is
+	// already in the units of the string, and as doubles otherwise.
+	template<typename Quantity>
+	using canonical_type = std::conditional_t<
+		is_canonical<Quantity>() || std::is_floating_point<typename Quantity::numeric_type>::value,
+		typename Quantity::numeric_type, double>;
+
+	template<typename Quantity>
+	canonical_type<Quantity> canonical_value(Quantity value)
+	{
+		if (is_canonical<Quantity>())
+		{
+			return value.raw_value();
+		}
+		constexpr parse::conversion conversion = canonical_conversion<Quantity>();
+		return static_cast<canonical_type<Quantity>>(
+			conversion.apply(static_cast<double>(value.raw_value())));
+	}
+
+#pragma mark - Numbers
+#if defined(__cpp_lib_to_chars)
+	template<typename T>
+	unitscxx::to_chars_result write_number(char* first, char* last, T value)
+	{
+		auto result = std::to_chars(first, last, value);
+		return {result.ptr, result.ec};
+	}
+#else
+	template<typename T>
+	unitscxx::to_chars_result write_number(char* first, char* last, T value, std::false_type /* floating point */)
+	{
+		char buffer[std::numeric_limits<T>::digits10 + 3];
+		using unsigned_type = std::make_unsigned_t<T>;
+		unsigned_type magnitude = value < 0
+			? static_cast<unsigned_type>(0 - static_cast<unsigned_type>(value))
+			: static_cast<unsigned_type>(value);
+		char* end = buffer + sizeof buffer;
+		char* p = end;
+		do
+		{
+			*--p = static_cast<char>('0' + magnitude % 10);
+			magnitude /= 10;
+		}
+		while (magnitude != 0);
+		if (value < 0)
+		{
+			*--p = '-';
+		}
+		size_t length = static_cast<size_t>(end - p);
+		if (static_cast<size_t>(last - first) < length)
+		{
+			return {last, std::errc::value_too_large};
+		}
+		std::memcpy(first, p, length);
+		return {first + length, std::errc()};
+	}
+
+	// The shortest of %.{digits10}g to %.{max_digits10}g that reads back as
+	// the same value. snprintf uses the decimal point of the C locale, which
+	// is put back to '.'.
+	template<typename T>
+	unitscxx::to_chars_result write_number(char* first, char* last, T value, std::true_type /* floating point */)
+	{
+		char buffer[40];
+		int length = 0;
+		for (int precision = std::numeric_limits<T>::digits10;
+			precision <= std::numeric_limits<T>::max_digits10; ++precision)
+		{
+			length = std::snprintf(buffer, sizeof buffer, "%.*g", precision,
+				static_cast<double>(value));
+			for (int i = 0; i < length; ++i)
+			{
+				char c = buffer[i];
+				bool numeric = (c >= '0' && c <= '9') || c == '-' || c == '+'
+					|| (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+				buffer[i] = numeric ? c : '.';
+			}
+			double back = 0;
+			if (parse::parse_number(buffer, buffer + length, back).ec == unitscxx::parse_errc::ok
+				&& static_cast<T>(back) == value)
+			{
+				break;
+			}
+		}
+		if (last - first < length)
+		{
+			return {last, std::errc::value_too_large};
+		}
+		std::memcpy(first, buffer, static_cast<size_t>(length));
+		return {first + length, std::errc()};
+	}
+
+	template<typename T>
+	unitscxx::to_chars_result write_number(char* first, char* last, T value)
+	{
+		return write_number(first, last, value, std::is_floating_point<T>{});
+	}
+#endif
+
+	inline unitscxx::to_chars_result append_unit(unitscxx::to_chars_result number,
+		char* last, const char* unit, size_t length)
+	{
+		if (number.ec != std::errc() || length == 0)
+		{
+			return number;
+		}
+		if (static_cast<size_t>(last - number.ptr) < length + 1)
+		{
+			return {last, std::errc::value_too_large};
+		}
+		*number.ptr = ' ';
+		std::memcpy(number.ptr + 1, unit, length);
+		return {number.ptr + 1 + length, std::errc()};
+	}
+
+#pragma mark - Symbols of target units
+	inline bool close(double a, double b)
+	{
+		return std::abs(a - b) <= std::abs(b) * 1e-12;
+	}
+
+	inline size_t copy_symbol(char* out, size_t size, const char* a, size_t aLength,
+		const char* b, size_t bLength)
+	{
+		if (aLength + bLength + 1 > size)
+		{
+			return 0;
+		}
+		std::memcpy(out, a, aLength);
+		std::memcpy(out + aLength, b, bLength);
+		out[aLength + bLength] = 0;
+		return aLength + bLength;
+	}
+
+	// Finds the symbol of a unit such as us::ft or std::kilo() * si::m in
+	// unit_registry.hpp, with an SI prefix if needed. Falls back on the unit
+	// string when the unit is the coherent SI unit. Returns the length
+	// written to out, or 0 if the unit has no name.
+	template<typename NT, typename D, typename S>
+	size_t symbol_for(unitscxx::quantity<NT, D, S> unit, char* out, size_t size)
+	{
+		static_assert(std::is_same<typename D::value_type, unitscxx::si::units>::value,
+			"unit names are only known for SI-based units");
+		double factor = registry::base_factor(unit);
+		for (const unitscxx::registered_unit& candidate : registry::units)
+		{
+			bool sameDimension = true;
+			for (size_t i = 0; i < registry::base_count; ++i)
+			{
+				sameDimension &= candidate.exponents[i] == registry::base_exponent<D>(i);
+			}
+			if (!sameDimension)
+			{
+				continue;
+			}
+			if (close(factor, candidate.factor))
+			{
+				return copy_symbol(out, size, "", 0, candidate.symbol, candidate.length);
+			}
+			for (const unitscxx::unit_prefix& prefix : registry::prefixes)
+			{
+				if (candidate.prefixable
+					&& close(factor, parse::conversion{candidate.factor, prefix.decimal}.apply(1)))
+				{
+					return copy_symbol(out, size, prefix.symbol, prefix.length,
+						candidate.symbol, candidate.length);
+				}
+			}
+		}
+		if (close(factor, parse::conversion{1, base_decimal<D>()}.apply(1)))
+		{
+			constexpr auto unit = make_unit_string<D, unit_style::unicode>();
+			return copy_symbol(out, size, "", 0, unit.c_str(), unit.size());
+		}
+		return 0;
+	}
+}
+}
+
+namespace unitscxx
+{
+#pragma mark - Formatting
+	// The unit string of a quantity type, as a constant: for instance,
+	// unit_string<decltype(si::N)>.c_str() is "m·kg/s²".
+	template<typename Quantity, unit_style Style = unit_style::unicode>
+	constexpr auto unit_string = detail::format::make_unit_string<
+		typename std::remove_cv_t<Quantity>::dimension, Style>();
+
+	// Writes value in the units of its unit string, followed by a space and
+	// the unit string ("12.5 m/s"). Like std::to_chars, nothing is written
+	// past last, and ec is value_too_large when the buffer is too short.
+	template<unit_style Style = unit_style::unicode, typename NT, typename D, typename S>
+	to_chars_result to_chars(char* first, char* last, quantity<NT, D, S> value)
+	{
+		constexpr auto& unit = unit_string<quantity<NT, D, S>, Style>;
+		return detail::format::append_unit(
+			detail::format::write_number(first, last, detail::format::canonical_value(value)),
+			last, unit.c_str(), unit.size());
+	}
+
+	// Writes value as a number of units with the given symbol, like
+	// to_chars(first, last, distance, us::ft, "ft").
+	template<typename NT, typename D, typename S, typename UNT, typename US>
+	to_chars_result to_chars(char* first, char* last, quantity<NT, D, S> value,
+		quantity<UNT, D, US> unit, const char* symbol)
+	{
+		using number_type = std::conditional_t<
+			std::is_integral<NT>::value && std::is_integral<UNT>::value,
+			double, std::common_type_t<NT, UNT>>;
+		number_type number = static_cast<number_type>(
+			quantity<number_type, D, S>(value) / quantity<number_type, D, US>(unit));
+		return detail::format::append_unit(
+			detail::format::write_number(first, last, number),
+			last, symbol, std::strlen(symbol));
+	}
+
+	// Same, with the symbol looked up from the unit: us::ft writes "ft" and
+	// std::kilo() * si::m writes "km". ec is invalid_argument if the unit
+	// has no symbol. Pass the symbol explicitly in tight loops.
+	template<typename NT, typename D, typename S, typename UNT, typename US>
+	to_chars_result to_chars(char* first, char* last, quantity<NT, D, S> value,
+		quantity<UNT, D, US> unit)
+	{
+		char symbol[32] = {};
+		if (detail::format::symbol_for(unit, symbol, sizeof symbol) == 0 && D::size != 0)
+		{
+			return {first, std::errc::invalid_argument};
+		}
+		return to_chars(first, last, value, unit, symbol);
+	}
+}
+
+#pragma mark - std::format and fmt
+#if defined(__cpp_lib_format)
+namespace std
+{
+	template<typename NT, typename D, typename S>
+	struct formatter<unitscxx::quantity<NT, D, S>, char>
+		: formatter<::detail::format::canonical_type<unitscxx::quantity<NT, D, S>>, char>
+	{
+		using quantity_type = unitscxx::quantity<NT, D, S>;
+		using number_formatter = formatter<::detail::format::canonical_type<quantity_type>, char>;
+
+		template<typename FormatContext>
+		auto format(const quantity_type& value, FormatContext& context) const
+		{
+			auto out = number_formatter::format(::detail::format::canonical_value(value), context);
+			constexpr auto& unit = unitscxx::unit_string<quantity_type>;
+			if (unit.size() != 0)
+			{
+				*out++ = ' ';
+				out = std::copy(unit.c_str(), unit.c_str() + unit.size(), out);
+			}
+			return out;
+		}
+	};
+}
+#endif
+
+#if defined(FMT_VERSION)
+namespace fmt
+{
+	template<typename NT, typename D, typename S>
+	struct formatter<unitscxx::quantity<NT, D, S>, char>
+		: formatter<::detail::format::canonical_type<unitscxx::quantity<NT, D, S>>, char>
+	{
+		using quantity_type = unitscxx::quantity<NT, D, S>;
+		using number_formatter = formatter<::detail::format::canonical_type<quantity_type>, char>;
+
+		template<typename FormatContext>
+		auto format(const quantity_type& value, FormatContext& context) const
+			-> decltype(context.out())
+		{
+			auto out = number_formatter::format(::detail::format::canonical_value(value), context);
+			constexpr auto& unit = unitscxx::unit_string<quantity_type>;
+			if (unit.size() != 0)
+			{
+				*out++ = ' ';
+				for (const char* c = unit.c_str(); *c != 0; ++c)
+				{
+					*out++ = *c;
+				}
+			}
+			return out;
+		}
+	};
+}
+#endif
+
+#endif
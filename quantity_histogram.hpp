@@ -0,0 +1,344 @@
+//
+// quantity_histogram.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef QUANTITY_HISTOGRAM_HPP
+#define QUANTITY_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <vector>
+#include "units.hpp"
+#include "quantity_span.hpp"
+#include "simd.hpp"
+
+// Histograms whose edges are quantities. Values are binned by their raw
+// numbers, so edges and values must have the same dimension, and values at
+// another scale are converted when they are passed in. Bins come in three
+// kinds:
+//
+//   linear        bins of equal width; the bin index is a subtraction, a
+//                 multiplication and a clamp, vectorized in simd.hpp
+//   logarithmic   bins of equal width in log(value); the log is taken with
+//                 std::log, then the value is binned linearly
+//   edges         any increasing edges, found with a branch-free binary
+//                 search
+//
+// Values below the first edge count as underflow, and values at or above the
+// last edge (and NaN) as overflow.
+
+namespace detail
+{
+namespace bins
+{
+	constexpr size_t chunk_size = 256;
+
+	enum class kind
+	{
+		linear,
+		logarithmic,
+		edges,
+	};
+
+	constexpr size_t search_lanes = 8;
+
+	// The index of the last edge that isn't above value: -1 below the first
+	// edge, and count - 1 at or above the last one or for NaN.
+	template<typename T>
+	std::int32_t search(const T* edges, size_t count, T value)
+	{
+		size_t base = 0;
+		for (size_t length = count; length > 1; length -= length / 2)
+		{
+			size_t half = length / 2;
+			base = value < edges[base + half] ? base : base + half;
+		}
+		return static_cast<std::int32_t>(base) + !(value < edges[base]) - 1;
+	}
+
+	// The steps of the search only depend on the number of edges, so several
+	// values go through them together and their loads overlap.
+	template<typename T>
+	void search(const T* edges, size_t count, const T* values, std::int32_t* out, size_t n)
+	{
+		size_t i = 0;
+		for (; i + search_lanes <= n; i += search_lanes)
+		{
+			size_t base[search_lanes] = {};
+			for (size_t length = count; length > 1; length -= length / 2)
+			{
+				size_t half = length / 2;
+#pragma GCC unroll 8
+				for (size_t lane = 0; lane < search_lanes; ++lane)
+				{
+					base[lane] = values[i + lane] < edges[base[lane] + half] ? base[lane] : base[lane] + half;
+				}
+			}
+			for (size_t lane = 0; lane < search_lanes; ++lane)
+			{
+				out[i + lane] = static_cast<std::int32_t>(base[lane]) + !(values[i + lane] < edges[base[lane]]) - 1;
+			}
+		}
+		for (; i < n; ++i)
+		{
+			out[i] = search(edges, count, values[i]);
+		}
+	}
+
+	template<typename T>
+	void increment(T& counter, T amount)
+	{
+		counter += amount;
+	}
+
+	template<typename T>
+	void increment(std::atomic<T>& counter, T amount)
+	{
+		counter.fetch_add(amount, std::memory_order_relaxed);
+	}
+
+	template<typename T>
+	T load(const T& counter)
+	{
+		return counter;
+	}
+
+	template<typename T>
+	T load(const std::atomic<T>& counter)
+	{
+		return counter.load(std::memory_order_relaxed);
+	}
+}
+}
+
+namespace unitscxx
+{
+	// Counter is std::uint64_t, or std::atomic<std::uint64_t> for a histogram
+	// that several threads fill at once. fill(span) counts locally first, so
+	// shared counters are only touched once per call and bin. Histograms
+	// filled by separate threads can also be merged with +=.
+	template<typename Quantity, typename Counter = std::uint64_t>
+	class quantity_histogram
+	{
+	public:
+		using value_type = std::remove_cv_t<Quantity>;
+		using numeric_type = typename value_type::numeric_type;
+		using count_type = std::uint64_t;
+
+		static_assert(std::is_floating_point<numeric_type>::value,
+			"bins are computed in the quantity's numeric type");
+
+	private:
+		using kind = detail::bins::kind;
+
+		kind binning;
+		std::vector<numeric_type> edges;
+		// In log space for logarithmic bins.
+		numeric_type low;
+		numeric_type high;
+		numeric_type scale;
+		// Underflow, then each bin, then overflow.
+		std::vector<Counter> counters;
+
+		template<typename, typename>
+		friend class quantity_histogram;
+
+		quantity_histogram(kind how, numeric_type from, numeric_type to, size_t count)
+		: binning(how), edges(count + 1), low(from), high(to), scale(count / (to - from)), counters(count + 2)
+		{
+			assert(count > 0 && from < to && "empty histogram range");
+			for (size_t i = 0; i < count; ++i)
+			{
+				edges[i] = from + (to - from) * i / count;
+			}
+			edges[count] = to;
+		}
+
+		// Bin indices of values, from -1 for underflow to bins() for overflow.
+		void index(const numeric_type* values, std::int32_t* out, size_t count) const
+		{
+			if (binning == kind::edges)
+			{
+				detail::bins::search(edges.data(), edges.size(), values, out, count);
+				return;
+			}
+			
+			if (binning == kind::logarithmic)
+			{
+				numeric_type logs[detail::bins::chunk_size];
+				for (size_t i = 0; i < count; ++i)
+				{
+					// Negative values go to the underflow, not to NaN.
+					logs[i] = std::log(std::max(values[i], numeric_type(0)));
+				}
+				detail::simd::bin_linear(logs, out, low, high, scale, bins(), count);
+				return;
+			}
+			
+			detail::simd::bin_linear(values, out, low, high, scale, bins(), count);
+		}
+
+	public:
+		// `bins` bins of equal width from low to high.
+		UNITS_ATTR_NODISCARD static quantity_histogram linear(value_type low, value_type high, size_t bins)
+		{
+			return quantity_histogram(kind::linear, low.raw_value(), high.raw_value(), bins);
+		}
+
+		// `bins` bins from low to high whose edges grow by the same factor;
+		// low must be positive.
+		UNITS_ATTR_NODISCARD static quantity_histogram logarithmic(value_type low, value_type high, size_t bins)
+		{
+			assert(low.raw_value() > 0 && "logarithmic bins start above zero");
+			quantity_histogram result(kind::logarithmic,
+				std::log(low.raw_value()), std::log(high.raw_value()), bins);
+			for (size_t i = 0; i <= bins; ++i)
+			{
+				result.edges[i] = std::exp(result.edges[i]);
+			}
+			result.edges.front() = low.raw_value();
+			result.edges.back() = high.raw_value();
+			return result;
+		}
+
+		// Bin i is [edges[i], edges[i + 1]); edges must be increasing.
+		explicit quantity_histogram(quantity_span<const value_type> boundaries)
+		: binning(kind::edges), edges(boundaries.data(), boundaries.data() + boundaries.size()),
+		low(0), high(0), scale(0), counters(boundaries.size() + 1)
+		{
+			assert(edges.size() > 1 && std::adjacent_find(edges.begin(), edges.end(),
+				std::greater_equal<numeric_type>()) == edges.end() && "histogram edges must be increasing");
+		}
+
+		void fill(value_type value)
+		{
+			numeric_type raw = value.raw_value();
+			std::int32_t bin;
+			if (binning == kind::edges)
+			{
+				bin = detail::bins::search(edges.data(), edges.size(), raw);
+			}
+			else
+			{
+				if (binning == kind::logarithmic)
+				{
+					raw = std::log(std::max(raw, numeric_type(0)));
+				}
+				detail::simd::scalar_bin_linear(&raw, &bin, low, high, scale, numeric_type(bins() - 1), 0, 1);
+			}
+			detail::bins::increment(counters[bin + 1], count_type(1));
+		}
+
+		void fill(quantity_span<const value_type> values)
+		{
+			std::int32_t bins[detail::bins::chunk_size];
+			std::vector<count_type> local(std::is_same<Counter, count_type>::value ? 0 : counters.size());
+			for (size_t start = 0; start < values.size(); start += detail::bins::chunk_size)
+			{
+				size_t count = std::min(detail::bins::chunk_size, values.size() - start);
+				index(values.data() + start, bins, count);
+				if (local.empty())
+				{
+					for (size_t i = 0; i < count; ++i)
+					{
+						++counters[bins[i] + 1];
+					}
+				}
+				else
+				{
+					for (size_t i = 0; i < count; ++i)
+					{
+						++local[bins[i] + 1];
+					}
+				}
+			}
+			
+			for (size_t bin = 0; bin < local.size(); ++bin)
+			{
+				if (local[bin] != 0)
+				{
+					detail::bins::increment(counters[bin], local[bin]);
+				}
+			}
+		}
+
+		// Adds the counts of a histogram with the same edges.
+		template<typename ThatCounter>
+		quantity_histogram& operator+=(const quantity_histogram<Quantity, ThatCounter>& that)
+		{
+			assert(that.edges == edges && "merging histograms with different edges");
+			for (size_t bin = 0; bin < counters.size(); ++bin)
+			{
+				detail::bins::increment(counters[bin], detail::bins::load(that.counters[bin]));
+			}
+			return *this;
+		}
+
+		UNITS_ATTR_NODISCARD size_t bins() const
+		{
+			return edges.size() - 1;
+		}
+
+		// The lower edge of bin i; edge(bins()) is the upper edge of the last
+		// bin.
+		UNITS_ATTR_NODISCARD value_type edge(size_t i) const
+		{
+			return value_type(edges[i]);
+		}
+
+		UNITS_ATTR_NODISCARD count_type count(size_t bin) const
+		{
+			return detail::bins::load(counters[bin + 1]);
+		}
+
+		UNITS_ATTR_NODISCARD count_type underflow() const
+		{
+			return detail::bins::load(counters.front());
+		}
+
+		UNITS_ATTR_NODISCARD count_type overflow() const
+		{
+			return detail::bins::load(counters.back());
+		}
+
+		UNITS_ATTR_NODISCARD count_type total() const
+		{
+			count_type sum = 0;
+			for (const auto& counter : counters)
+			{
+				sum += detail::bins::load(counter);
+			}
+			return sum;
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,344 @@
+//
+// quantity_math.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef QUANTITY_MATH_HPP
+#define QUANTITY_MATH_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <ratio>
+#include <type_traits>
+#include "units.hpp"
+
+// <cmath> for quantities. Result dimensions are computed at compile time
+// (sqrt of an area is a length, cbrt of a length is m^(1/3)) and the raw value
+// goes straight to the <cmath> function, so a call costs what it costs on
+// plain numbers.
+//
+// Scales follow the value where it can be done exactly: sqrt of square
+// millimeters is in millimeters, because std::micro is a perfect square.
+// Scales without an exact root are converted to 1 first.
+
+namespace detail
+{
+	namespace math
+	{
+		// Whether r^k <= n, without overflowing.
+		constexpr bool power_at_most(intmax_t r, int k, intmax_t n)
+		{
+			intmax_t power = 1;
+			for (int i = 0; i < k; ++i)
+			{
+				if (power > n / r)
+				{
+					return false;
+				}
+				power *= r;
+			}
+			return true;
+		}
+
+		// The k-th root of n > 0 if it is an integer, 0 otherwise.
+		constexpr intmax_t integer_root(intmax_t n, int k)
+		{
+			intmax_t low = 1;
+			intmax_t high = n;
+			while (low < high)
+			{
+				intmax_t middle = high - (high - low) / 2;
+				if (power_at_most(middle, k, n))
+				{
+					low = middle;
+				}
+				else
+				{
+					high = middle - 1;
+				}
+			}
+			return power_at_most(low, k, n) && !power_at_most(low, k, n - 1) ? low : 0;
+		}
+
+		constexpr intmax_t integer_power(intmax_t n, int k)
+		{
+			intmax_t power = 1;
+			for (int i = 0; i < k; ++i)
+			{
+				power *= n;
+			}
+			return power;
+		}
+
+		constexpr bool power_fits(intmax_t n, int k)
+		{
+			intmax_t power = 1;
+			for (int i = 0; i < k; ++i)
+			{
+				if (!product_fits(power, n))
+				{
+					return false;
+				}
+				power *= n;
+			}
+			return true;
+		}
+
+		// Scale^N when std::ratio can represent it, 1 otherwise (the value is
+		// then converted to scale 1 before it is raised).
+		template<typename Scale, int N>
+		using power_base_scale = std::conditional_t<
+			power_fits(Scale::num, N) && power_fits(Scale::den, N), Scale, std::ratio<1>>;
+
+		template<typename Ratio, int N>
+		using ratio_power = std::conditional_t<N >= 0,
+			std::ratio<integer_power(Ratio::num, N), integer_power(Ratio::den, N)>,
+			std::ratio<integer_power(Ratio::den, -N), integer_power(Ratio::num, -N)>>;
+
+		// Scale^(Num/Den) when both terms of Scale have an exact Den-th root;
+		// the value is converted to scale 1 otherwise.
+		template<typename Scale, int Num, int Den>
+		struct scale_power
+		{
+			static constexpr intmax_t num_root = integer_root(Scale::num, Den);
+			static constexpr intmax_t den_root = integer_root(Scale::den, Den);
+			static constexpr bool exact = num_root != 0 && den_root != 0;
+
+			using from = std::conditional_t<exact, Scale, std::ratio<1>>;
+			using type = std::conditional_t<exact,
+				ratio_power<std::ratio<exact ? num_root : 1, exact ? den_root : 1>, Num>,
+				std::ratio<1>>;
+		};
+
+		// x^N with a fixed chain of multiplications (binary exponentiation
+		// unrolled at compile time).
+		template<int N>
+		struct power_
+		{
+			template<typename T>
+			static constexpr auto of(T x)
+			{
+				auto half = power_<N / 2>::of(x);
+				return N % 2 == 0 ? half * half : half * half * x;
+			}
+		};
+
+		template<>
+		struct power_<1>
+		{
+			template<typename T>
+			static constexpr T of(T x)
+			{
+				return x;
+			}
+		};
+
+		template<typename NT>
+		using floating_type = decltype(std::sqrt(std::declval<NT>()));
+
+		template<int Num, int Den, typename NT, typename D, typename S, typename Function>
+		auto rational_power(unitscxx::quantity<NT, D, S> q, Function function)
+		{
+			using scale = scale_power<S, Num, Den>;
+			using FT = floating_type<NT>;
+			FT value = rescale<FT, S, typename scale::from>(q.raw_value());
+			return unitscxx::quantity<FT, dimension_power<D, Num, Den>, typename scale::type>(
+				function(value));
+		}
+	}
+}
+
+namespace unitscxx
+{
+#pragma mark - Powers and roots
+	// q^N, computed with multiplications. N = 0 gives a dimensionless 1.
+	template<int N, typename NT, typename D, typename S, typename = std::enable_if_t<(N > 0)>>
+	UNITS_ATTR_NODISCARD constexpr auto pow(quantity<NT, D, S> q)
+	{
+		using base_scale = detail::math::power_base_scale<S, N>;
+		using base_type = std::conditional_t<std::is_same<base_scale, S>::value, NT,
+			detail::math::floating_type<NT>>;
+		auto base = detail::rescale<base_type, S, base_scale>(q.raw_value());
+		using result_quantity = quantity<
+			decltype(detail::math::power_<N>::of(base)),
+			detail::dimension_power<D, N>,
+			detail::math::ratio_power<base_scale, N>>;
+		return result_quantity(detail::math::power_<N>::of(base));
+	}
+
+	template<int N, typename NT, typename D, typename S, typename = std::enable_if_t<(N == 0)>,
+		typename = void>
+	UNITS_ATTR_NODISCARD constexpr auto pow(quantity<NT, D, S>)
+	{
+		return quantity<NT, detail::dimension<typename D::value_type>>(1);
+	}
+
+	template<int N, typename NT, typename D, typename S, typename = std::enable_if_t<(N < 0)>,
+		typename = void, typename = void>
+	UNITS_ATTR_NODISCARD constexpr auto pow(quantity<NT, D, S> q)
+	{
+		return 1 / pow<-N>(q);
+	}
+
+	// q^(Exponent::num / Exponent::den) for a std::ratio exponent.
+	template<typename Exponent, typename NT, typename D, typename S,
+		typename = std::enable_if_t<Exponent::den == 1>>
+	UNITS_ATTR_NODISCARD constexpr auto pow(quantity<NT, D, S> q)
+	{
+		return pow<static_cast<int>(Exponent::num)>(q);
+	}
+
+	template<typename Exponent, typename NT, typename D, typename S,
+		typename = std::enable_if_t<Exponent::den != 1>, typename = void>
+	UNITS_ATTR_NODISCARD auto pow(quantity<NT, D, S> q)
+	{
+		constexpr int num = static_cast<int>(Exponent::num);
+		constexpr int den = static_cast<int>(Exponent::den);
+		return detail::math::rational_power<num, den>(q, [](auto x)
+		{
+			return std::pow(x, static_cast<decltype(x)>(num) / den);
+		});
+	}
+
+	template<typename NT, typename D, typename S>
+	UNITS_ATTR_NODISCARD auto sqrt(quantity<NT, D, S> q)
+	{
+		return detail::math::rational_power<1, 2>(q, [](auto x) { return std::sqrt(x); });
+	}
+
+	template<typename NT, typename D, typename S>
+	UNITS_ATTR_NODISCARD auto cbrt(quantity<NT, D, S> q)
+	{
+		return detail::math::rational_power<1, 3>(q, [](auto x) { return std::cbrt(x); });
+	}
+
+	// sqrt(a² + b²) without intermediate overflow, at the common scale of a
+	// and b.
+	template<typename NT1, typename NT2, typename D, typename S1, typename S2>
+	UNITS_ATTR_NODISCARD auto hypot(quantity<NT1, D, S1> a, quantity<NT2, D, S2> b)
+	{
+		using scale = detail::common_scale<S1, S2>;
+		using FT = detail::math::floating_type<std::common_type_t<NT1, NT2>>;
+		return quantity<FT, D, scale>(std::hypot(
+			detail::rescale<FT, S1, scale>(a.raw_value()),
+			detail::rescale<FT, S2, scale>(b.raw_value())));
+	}
+
+#pragma mark - Fused multiply-add
+	// a * b + c with a single rounding. This is std::fma on the raw values, so
+	// it is one instruction where the target has FMA (build with -mfma or
+	// -march=native on x86; AArch64 always has it) and a library call
+	// otherwise. When the scale of a * b differs from the scale of c, the
+	// factor is folded into a before the call.
+	template<typename NT1, typename D1, typename S1, typename NT2, typename D2, typename S2,
+		typename NT3, typename S3>
+	UNITS_ATTR_NODISCARD auto fma(quantity<NT1, D1, S1> a, quantity<NT2, D2, S2> b,
+		quantity<NT3, detail::dimension_product<D1, D2>, S3> c)
+	{
+		using product = detail::scale_product<S1, S2>;
+		using product_scale = typename product::type;
+		using scale = detail::common_scale<product_scale, S3>;
+		using FT = detail::math::floating_type<std::common_type_t<NT1, NT2, NT3>>;
+		return quantity<FT, detail::dimension_product<D1, D2>, scale>(std::fma(
+			detail::rescale<FT, product_scale, scale>(product::fold(static_cast<FT>(a.raw_value()))),
+			static_cast<FT>(b.raw_value()),
+			detail::rescale<FT, S3, scale>(c.raw_value())));
+	}
+
+#pragma mark - Magnitude and sign
+	template<typename NT, typename D, typename S>
+	UNITS_ATTR_NODISCARD auto abs(quantity<NT, D, S> q)
+	{
+		return quantity<NT, D, S>(static_cast<NT>(std::abs(q.raw_value())));
+	}
+
+	// The magnitude of a with the sign of b, which can have any units.
+	template<typename NT1, typename D1, typename S1, typename NT2, typename D2, typename S2>
+	UNITS_ATTR_NODISCARD auto copysign(quantity<NT1, D1, S1> a, quantity<NT2, D2, S2> b)
+	{
+		return quantity<NT1, D1, S1>(static_cast<NT1>(
+			std::copysign(a.raw_value(), b.raw_value())));
+	}
+
+	// The same-type overloads are more specialized than std::min and std::max,
+	// so `using std::min; min(a, b)` still picks them.
+	template<typename NT, typename D, typename S>
+	UNITS_ATTR_NODISCARD constexpr quantity<NT, D, S> min(quantity<NT, D, S> a, quantity<NT, D, S> b)
+	{
+		return b < a ? b : a;
+	}
+
+	template<typename NT, typename D, typename S>
+	UNITS_ATTR_NODISCARD constexpr quantity<NT, D, S> max(quantity<NT, D, S> a, quantity<NT, D, S> b)
+	{
+		return a < b ? b : a;
+	}
+
+	// Mixed scales or numeric types give the common quantity, like a + b.
+	template<typename NT1, typename NT2, typename D, typename S1, typename S2>
+	UNITS_ATTR_NODISCARD constexpr auto min(quantity<NT1, D, S1> a, quantity<NT2, D, S2> b)
+	{
+		using result_quantity = decltype(a + b);
+		return b < a ? result_quantity(b) : result_quantity(a);
+	}
+
+	template<typename NT1, typename NT2, typename D, typename S1, typename S2>
+	UNITS_ATTR_NODISCARD constexpr auto max(quantity<NT1, D, S1> a, quantity<NT2, D, S2> b)
+	{
+		using result_quantity = decltype(a + b);
+		return a < b ? result_quantity(b) : result_quantity(a);
+	}
+
+#pragma mark - Rounding
+	// These round to whole multiples of the quantity's own scale: convert
+	// first to round to another unit, e.g. round(quantity<double, length,
+	// std::milli>(x)) for whole millimeters.
+
+	template<typename NT, typename D, typename S>
+	UNITS_ATTR_NODISCARD auto floor(quantity<NT, D, S> q)
+	{
+		return quantity<NT, D, S>(static_cast<NT>(std::floor(q.raw_value())));
+	}
+
+	template<typename NT, typename D, typename S>
+	UNITS_ATTR_NODISCARD auto ceil(quantity<NT, D, S> q)
+	{
+		return quantity<NT, D, S>(static_cast<NT>(std::ceil(q.raw_value())));
+	}
+
+	template<typename NT, typename D, typename S>
+	UNITS_ATTR_NODISCARD auto round(quantity<NT, D, S> q)
+	{
+		return quantity<NT, D, S>(static_cast<NT>(std::round(q.raw_value())));
+	}
+
+	template<typename NT, typename D, typename S>
+	UNITS_ATTR_NODISCARD auto trunc(quantity<NT, D, S> q)
+	{
+		return quantity<NT, D, S>(static_cast<NT>(std::trunc(q.raw_value())));
+	}
+}
+
+#endif
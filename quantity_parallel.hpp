@@ -0,0 +1,567 @@
+//
+// quantity_parallel.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef QUANTITY_PARALLEL_HPP
+#define QUANTITY_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "units.hpp"
+
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#define UNITSCXX_PARALLEL_EXCEPTIONS 1
+#endif
+
+#if defined(UNITSCXX_STD_EXECUTION) && __cplusplus >= 201703L
+#include <execution>
+#include <numeric>
+#define UNITSCXX_HAS_STD_EXECUTION 1
+#endif
+
+// transform, reduce, transform_reduce and inclusive_scan over ranges of
+// quantities (quantity_array, quantity_span, std::vector...), split across
+// cores. Units work as they do in a loop: a transform_reduce of lengths by
+// lengths gives an area.
+//
+// The work is cut into blocks that run on a shared work-stealing thread
+// pool, and partial results are combined in block order. By default the
+// block size follows the thread count, so floating-point results can change
+// in the last bits with it; par_deterministic uses fixed blocks, which gives
+// the same bits for any number of threads. The pool has one thread per core
+// unless UNITSCXX_PARALLEL_THREADS says otherwise. Define UNITSCXX_STD_EXECUTION (in
+// C++17, with a standard library that has a parallel backend) to hand the
+// non-deterministic cases to std::execution::par_unseq instead.
+
+namespace detail
+{
+namespace threading
+{
+	// Every participant owns a range of task indices, packed in one word so
+	// that the owner taking from the front and a thief taking the back half
+	// can't both get the same task.
+	class task_ranges
+	{
+		// padded like the shards of sharded_quantity.hpp
+		struct range
+		{
+			std::atomic<uint64_t> bounds;
+			char padding[128 - sizeof(std::atomic<uint64_t>)];
+		};
+
+		std::unique_ptr<range[]> ranges;
+
+		static uint64_t pack(uint64_t first, uint64_t last)
+		{
+			return first << 32 | last;
+		}
+
+	public:
+		explicit task_ranges(size_t participants) : ranges(new range[participants])
+		{
+		}
+
+		void assign(size_t participant, size_t first, size_t last)
+		{
+			ranges[participant].bounds.store(pack(first, last), std::memory_order_relaxed);
+		}
+
+		bool pop(size_t participant, size_t& task)
+		{
+			auto& bounds = ranges[participant].bounds;
+			uint64_t current = bounds.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				uint64_t first = current >> 32, last = current & 0xffffffff;
+				if (first >= last)
+				{
+					return false;
+				}
+				if (bounds.compare_exchange_weak(current, pack(first + 1, last),
+					std::memory_order_relaxed))
+				{
+					task = static_cast<size_t>(first);
+					return true;
+				}
+			}
+		}
+
+		// Moves the back half of another participant's range to this one.
+		bool steal(size_t participant, size_t participants)
+		{
+			for (size_t i = 1; i < participants; ++i)
+			{
+				auto& bounds = ranges[(participant + i) % participants].bounds;
+				uint64_t current = bounds.load(std::memory_order_relaxed);
+				for (;;)
+				{
+					uint64_t first = current >> 32, last = current & 0xffffffff;
+					if (first >= last)
+					{
+						break;
+					}
+					uint64_t middle = last - (last - first + 1) / 2;
+					if (bounds.compare_exchange_weak(current, pack(first, middle),
+						std::memory_order_relaxed))
+					{
+						assign(participant, static_cast<size_t>(middle), static_cast<size_t>(last));
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+	};
+
+	// Workers sleep until a job comes; the calling thread takes part in its
+	// own jobs. One job runs at a time, and jobs started from inside a task
+	// (or while another job runs) run on the calling thread.
+	class thread_pool
+	{
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable wake;
+		uint64_t generation = 0;
+		bool stopping = false;
+
+		std::mutex jobMutex;
+		void (*invoke)(void*, size_t) = nullptr;
+		void* context = nullptr;
+		size_t participants = 0;
+		task_ranges ranges;
+		std::atomic<size_t> busy;
+		// Set when a task throws: the other threads stop taking tasks, and
+		// run() rethrows the first exception once they have all returned.
+		std::atomic<bool> failed;
+		std::exception_ptr failure;
+
+		static bool& inside_task()
+		{
+			thread_local bool inside = false;
+			return inside;
+		}
+
+		void work(size_t participant)
+		{
+			inside_task() = true;
+#ifdef UNITSCXX_PARALLEL_EXCEPTIONS
+			try
+			{
+#endif
+				size_t task;
+				do
+				{
+					while (!failed.load(std::memory_order_relaxed) && ranges.pop(participant, task))
+					{
+						invoke(context, task);
+					}
+				}
+				while (!failed.load(std::memory_order_relaxed) && ranges.steal(participant, participants));
+#ifdef UNITSCXX_PARALLEL_EXCEPTIONS
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!failure)
+				{
+					failure = std::current_exception();
+				}
+				failed.store(true, std::memory_order_relaxed);
+			}
+#endif
+			inside_task() = false;
+		}
+
+		void worker(size_t participant)
+		{
+			uint64_t seen = 0;
+			for (;;)
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [&] { return stopping || generation != seen; });
+				if (stopping)
+				{
+					return;
+				}
+				seen = generation;
+				bool taking = participant < participants;
+				lock.unlock();
+				if (taking)
+				{
+					work(participant);
+					busy.fetch_sub(1, std::memory_order_release);
+				}
+			}
+		}
+
+		explicit thread_pool(size_t threads) : ranges(threads), busy(0), failed(false)
+		{
+			for (size_t i = 1; i < threads; ++i)
+			{
+				workers.emplace_back([this, i] { worker(i); });
+			}
+		}
+
+	public:
+		~thread_pool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			wake.notify_all();
+			for (auto& thread : workers)
+			{
+				thread.join();
+			}
+		}
+
+		static thread_pool& instance()
+		{
+#ifdef UNITSCXX_PARALLEL_THREADS
+			static thread_pool pool(UNITSCXX_PARALLEL_THREADS);
+#else
+			static thread_pool pool(std::max(1u, std::thread::hardware_concurrency()));
+#endif
+			return pool;
+		}
+
+		size_t size() const
+		{
+			return workers.size() + 1;
+		}
+
+		// Calls task(i) for every i below tasks, on up to threads threads. If
+		// tasks throw, the remaining ones are skipped and the first exception
+		// is rethrown here once no thread is running tasks anymore.
+		template<typename Task>
+		void run(size_t threads, size_t tasks, Task& task)
+		{
+			threads = std::min(std::min(threads, size()), tasks);
+			if (threads <= 1 || inside_task() || !jobMutex.try_lock())
+			{
+				for (size_t i = 0; i < tasks; ++i)
+				{
+					task(i);
+				}
+				return;
+			}
+
+			invoke = [](void* job, size_t i) { (*static_cast<Task*>(job))(i); };
+			context = &task;
+			for (size_t p = 0; p < threads; ++p)
+			{
+				ranges.assign(p, tasks * p / threads, tasks * (p + 1) / threads);
+			}
+			busy.store(threads - 1, std::memory_order_relaxed);
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				participants = threads;
+				++generation;
+			}
+			wake.notify_all();
+			work(0);
+			while (busy.load(std::memory_order_acquire) != 0)
+			{
+				std::this_thread::yield();
+			}
+			
+			std::exception_ptr error;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				std::swap(error, failure);
+				failed.store(false, std::memory_order_relaxed);
+			}
+			jobMutex.unlock();
+			if (error)
+			{
+				std::rethrow_exception(error);
+			}
+		}
+	};
+
+	// Fixed so that deterministic results don't depend on the machine.
+	constexpr size_t deterministic_block = 16384;
+	constexpr size_t minimum_block = 4096;
+	constexpr size_t blocks_per_thread = 8;
+
+	template<typename Range>
+	using element_type = std::decay_t<decltype(std::declval<Range&>()[0])>;
+}
+}
+
+namespace unitscxx
+{
+namespace parallel
+{
+	// How to run an algorithm. threads = 0 uses every thread of the pool.
+	struct execution
+	{
+		unsigned threads = 0;
+		bool deterministic = false;
+	};
+
+	constexpr execution par{};
+	constexpr execution par_deterministic{0, true};
+}
+}
+
+namespace detail
+{
+namespace threading
+{
+	struct blocks
+	{
+		size_t size;
+		size_t count;
+		size_t threads;
+	};
+
+	inline blocks split(unitscxx::parallel::execution how, size_t elements)
+	{
+		auto& pool = thread_pool::instance();
+		size_t threads = how.threads == 0 ? pool.size() : how.threads;
+		size_t size = how.deterministic ? deterministic_block
+			: std::max(minimum_block, (elements + threads * blocks_per_thread - 1)
+				/ (threads * blocks_per_thread));
+		return {size, (elements + size - 1) / size, threads};
+	}
+
+	// Calls body(first, last) for every block of [0, elements).
+	template<typename Body>
+	void for_blocks(const blocks& b, size_t elements, Body&& body)
+	{
+		auto task = [&](size_t block) {
+			size_t first = block * b.size;
+			body(block, first, std::min(first + b.size, elements));
+		};
+		thread_pool::instance().run(b.threads, b.count, task);
+	}
+
+	template<typename T, typename BinaryOp, typename Element>
+	T reduce_blocks(unitscxx::parallel::execution how, size_t elements, T init,
+		BinaryOp op, Element element)
+	{
+		if (elements == 0)
+		{
+			return init;
+		}
+		blocks b = split(how, elements);
+		std::vector<T> partials(b.count, init);
+		for_blocks(b, elements, [&](size_t block, size_t first, size_t last) {
+			T sum = element(first);
+			for (size_t i = first + 1; i < last; ++i)
+			{
+				sum = op(sum, element(i));
+			}
+			partials[block] = sum;
+		});
+		for (const T& partial : partials)
+		{
+			init = op(init, partial);
+		}
+		return init;
+	}
+}
+}
+
+namespace unitscxx
+{
+namespace parallel
+{
+	// out[i] = op(in[i]). out must be at least as long as in, and may be in.
+	template<typename In, typename Out, typename UnaryOp>
+	void transform(execution how, const In& in, Out&& out, UnaryOp op)
+	{
+		size_t count = in.size();
+#ifdef UNITSCXX_HAS_STD_EXECUTION
+		if (!how.deterministic)
+		{
+			using std::begin;
+			std::transform(std::execution::par_unseq, begin(in), begin(in) + count,
+				begin(out), op);
+			return;
+		}
+#endif
+		auto blocks = detail::threading::split(how, count);
+		detail::threading::for_blocks(blocks, count, [&](size_t, size_t first, size_t last) {
+			for (size_t i = first; i < last; ++i)
+			{
+				out[i] = op(in[i]);
+			}
+		});
+	}
+
+	// out[i] = op(a[i], b[i]).
+	template<typename In1, typename In2, typename Out, typename BinaryOp>
+	void transform(execution how, const In1& a, const In2& b, Out&& out, BinaryOp op)
+	{
+		size_t count = a.size();
+#ifdef UNITSCXX_HAS_STD_EXECUTION
+		if (!how.deterministic)
+		{
+			using std::begin;
+			std::transform(std::execution::par_unseq, begin(a), begin(a) + count,
+				begin(b), begin(out), op);
+			return;
+		}
+#endif
+		auto blocks = detail::threading::split(how, count);
+		detail::threading::for_blocks(blocks, count, [&](size_t, size_t first, size_t last) {
+			for (size_t i = first; i < last; ++i)
+			{
+				out[i] = op(a[i], b[i]);
+			}
+		});
+	}
+
+	// op must be associative; with par_deterministic it needn't be
+	// commutative either.
+	template<typename In, typename T, typename BinaryOp = std::plus<>>
+	UNITS_ATTR_NODISCARD T reduce(execution how, const In& in, T init, BinaryOp op = {})
+	{
+#ifdef UNITSCXX_HAS_STD_EXECUTION
+		if (!how.deterministic)
+		{
+			using std::begin;
+			return std::reduce(std::execution::par_unseq, begin(in), begin(in) + in.size(),
+				init, op);
+		}
+#endif
+		return detail::threading::reduce_blocks(how, in.size(), init, op,
+			[&](size_t i) { return static_cast<T>(in[i]); });
+	}
+
+	template<typename In>
+	UNITS_ATTR_NODISCARD auto reduce(execution how, const In& in)
+	{
+		return reduce(how, in, detail::threading::element_type<const In>());
+	}
+
+	template<typename In1, typename In2, typename T, typename Reduce, typename Transform>
+	UNITS_ATTR_NODISCARD T transform_reduce(execution how, const In1& a, const In2& b, T init,
+		Reduce reduce, Transform transform)
+	{
+#ifdef UNITSCXX_HAS_STD_EXECUTION
+		if (!how.deterministic)
+		{
+			using std::begin;
+			return std::transform_reduce(std::execution::par_unseq, begin(a),
+				begin(a) + a.size(), begin(b), init, reduce, transform);
+		}
+#endif
+		return detail::threading::reduce_blocks(how, a.size(), init, reduce,
+			[&](size_t i) { return static_cast<T>(transform(a[i], b[i])); });
+	}
+
+	// The sum of a[i] * b[i], in the units of the product.
+	template<typename In1, typename In2>
+	UNITS_ATTR_NODISCARD auto transform_reduce(execution how, const In1& a, const In2& b)
+	{
+		using product = decltype(std::declval<detail::threading::element_type<const In1>>()
+			* std::declval<detail::threading::element_type<const In2>>());
+		return transform_reduce(how, a, b, product(), std::plus<>(), std::multiplies<>());
+	}
+
+	template<typename In, typename T, typename Reduce, typename Transform>
+	UNITS_ATTR_NODISCARD T transform_reduce(execution how, const In& in, T init,
+		Reduce reduce, Transform transform)
+	{
+#ifdef UNITSCXX_HAS_STD_EXECUTION
+		if (!how.deterministic)
+		{
+			using std::begin;
+			return std::transform_reduce(std::execution::par_unseq, begin(in),
+				begin(in) + in.size(), init, reduce, transform);
+		}
+#endif
+		return detail::threading::reduce_blocks(how, in.size(), init, reduce,
+			[&](size_t i) { return static_cast<T>(transform(in[i])); });
+	}
+
+	// out[i] = in[0] op ... op in[i]. Each block is scanned on its own, then
+	// shifted by the total of the blocks before it.
+	template<typename In, typename Out, typename BinaryOp = std::plus<>>
+	void inclusive_scan(execution how, const In& in, Out&& out, BinaryOp op = {})
+	{
+		size_t count = in.size();
+		if (count == 0)
+		{
+			return;
+		}
+#ifdef UNITSCXX_HAS_STD_EXECUTION
+		if (!how.deterministic)
+		{
+			using std::begin;
+			std::inclusive_scan(std::execution::par_unseq, begin(in), begin(in) + count,
+				begin(out), op);
+			return;
+		}
+#endif
+		using T = detail::threading::element_type<std::remove_reference_t<Out>>;
+		auto blocks = detail::threading::split(how, count);
+		std::vector<T> totals(blocks.count);
+		detail::threading::for_blocks(blocks, count, [&](size_t block, size_t first, size_t last) {
+			T sum = static_cast<T>(in[first]);
+			out[first] = sum;
+			for (size_t i = first + 1; i < last; ++i)
+			{
+				sum = op(sum, in[i]);
+				out[i] = sum;
+			}
+			totals[block] = sum;
+		});
+		for (size_t block = 1; block + 1 < blocks.count; ++block)
+		{
+			totals[block] = op(totals[block - 1], totals[block]);
+		}
+		detail::threading::for_blocks(blocks, count, [&](size_t block, size_t first, size_t last) {
+			if (block == 0)
+			{
+				return;
+			}
+			T offset = totals[block - 1];
+			for (size_t i = first; i < last; ++i)
+			{
+				out[i] = op(offset, out[i]);
+			}
+		});
+	}
+}
+}
+
+#endif
@@ -0,0 +1,740 @@
+//
+// quantity_parse.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef QUANTITY_PARSE_HPP
+#define QUANTITY_PARSE_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include "units.hpp"
+#include "siunits.hpp"
+#include "usunits.hpp"
+#include "unit_registry.hpp"
+#include "dyn_quantity.hpp"
+#include "quantity_array.hpp"
+#include "quantity_span.hpp"
+
+#if defined(__has_include)
+#if __has_include(<charconv>) && __cplusplus >= 201703L
+#include <charconv>
+#endif
+#endif
+
+// Parses text like "12.5 m/s", "3.2e4 kg*m/s^2" or "14 ft" into a quantity of
+// a known type. The unit is checked against the type at runtime and the value
+// is converted to the type's scale. Nothing allocates, nothing depends on the
+// locale, and errors are returned instead of thrown.
+//
+// A unit is a list of symbols from unit_registry.hpp separated by '*', '.'
+// or '·', each with an optional exponent ("^2", "^-1" or "²"). Everything
+// after a '/' is in the denominator: "J/kg·K" is J/(kg·K). SI symbols take
+// the usual prefixes ("km", "µs", "hPa"); US symbols don't.
+
+namespace unitscxx
+{
+	enum class parse_errc
+	{
+		ok,
+		invalid_number,      // the text doesn't start with a number
+		unknown_unit,        // a symbol that isn't in unit_registry.hpp
+		invalid_unit,        // a misplaced operator or a bad exponent
+		dimension_mismatch,  // the unit doesn't measure what the type measures
+		out_of_range,        // the value doesn't fit in the numeric type
+		inexact,             // an integer type can't hold the value exactly
+		trailing_characters, // (parse_lines) something follows the unit
+	};
+
+	struct parse_result
+	{
+		const char* ptr;
+		parse_errc ec;
+	};
+}
+
+namespace detail
+{
+namespace parse
+{
+	using unitscxx::parse_errc;
+	using detail::registry::base_count;
+
+#pragma mark - Unit expressions
+	constexpr double exact_powers_of_ten[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+	};
+
+	struct unit_value
+	{
+		const char* ptr = nullptr;
+		parse_errc ec = parse_errc::ok;
+		double factor = 1;
+		int decimal = 0; // the unit is factor * 10^decimal base units
+		int exponents[base_count] = {};
+	};
+
+	constexpr unsigned byte_at(const char* p, size_t index)
+	{
+		return static_cast<unsigned char>(p[index]);
+	}
+
+	// Length of a UTF-8 superscript digit or minus sign at p (0 if there
+	// isn't one). The digit is stored in value, -1 for the minus sign.
+	constexpr size_t superscript(const char* p, const char* last, int& value)
+	{
+		if (last - p >= 2 && byte_at(p, 0) == 0xc2)
+		{
+			switch (byte_at(p, 1))
+			{
+				case 0xb9: value = 1; return 2;
+				case 0xb2: value = 2; return 2;
+				case 0xb3: value = 3; return 2;
+			}
+		}
+		if (last - p >= 3 && byte_at(p, 0) == 0xe2 && byte_at(p, 1) == 0x81)
+		{
+			unsigned c = byte_at(p, 2);
+			if (c == 0xb0 || (c >= 0xb4 && c <= 0xb9))
+			{
+				value = static_cast<int>(c - 0xb0);
+				return 3;
+			}
+			if (c == 0xbb)
+			{
+				value = -1;
+				return 3;
+			}
+		}
+		return 0;
+	}
+
+	// Length of a multiplication sign at p (0 if there isn't one).
+	constexpr size_t multiplication(const char* p, const char* last)
+	{
+		if (*p == '*' || *p == '.')
+		{
+			return 1;
+		}
+		if (last - p >= 2 && byte_at(p, 0) == 0xc2 && byte_at(p, 1) == 0xb7)
+		{
+			return 2;
+		}
+		return 0;
+	}
+
+	constexpr bool is_symbol_char(const char* p, const char* last)
+	{
+		int digit = 0;
+		char c = *p;
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+			|| (byte_at(p, 0) >= 0x80
+				&& superscript(p, last, digit) == 0 && multiplication(p, last) == 0);
+	}
+
+	// Reads an optional exponent after a symbol. Returns false if there is a
+	// '^' without a valid number after it.
+	constexpr bool parse_exponent(const char*& p, const char* last, int& exponent)
+	{
+		exponent = 1;
+		int digit = 0;
+		int sign = 1;
+		int magnitude = 0;
+		size_t digits = 0;
+		if (p != last && *p == '^')
+		{
+			++p;
+			if (p != last && (*p == '-' || *p == '+'))
+			{
+				sign = *p == '-' ? -1 : 1;
+				++p;
+			}
+			for (; p != last && *p >= '0' && *p <= '9'; ++p, ++digits)
+			{
+				magnitude = magnitude * 10 + (*p - '0');
+			}
+		}
+		else if (p != last && superscript(p, last, digit) != 0)
+		{
+			for (size_t length = 0; p != last && (length = superscript(p, last, digit)) != 0; p += length)
+			{
+				if (digit < 0)
+				{
+					if (digits != 0 || sign < 0)
+					{
+						return false;
+					}
+					sign = -1;
+					continue;
+				}
+				magnitude = magnitude * 10 + digit;
+				++digits;
+			}
+		}
+		else
+		{
+			return true;
+		}
+		if (digits == 0 || digits > 2 || magnitude == 0)
+		{
+			return false;
+		}
+		exponent = sign * magnitude;
+		return true;
+	}
+
+	// Parses the unit at the start of [first, last) and stops at the first
+	// character that can't be part of it. A text that doesn't start with a
+	// symbol is dimensionless.
+	constexpr unit_value parse_unit(const char* first, const char* last)
+	{
+		unit_value unit;
+		const char* p = first;
+		int side = 1;
+		bool expectSymbol = false;
+		if (last - p >= 2 && p[0] == '1' && p[1] == '/')
+		{
+			p += 1;
+		}
+		else if (p == last || !is_symbol_char(p, last))
+		{
+			unit.ptr = p;
+			return unit;
+		}
+
+		while (true)
+		{
+			if (p != last && *p == '/' && !expectSymbol)
+			{
+				if (side < 0)
+				{
+					unit.ptr = p;
+					unit.ec = parse_errc::invalid_unit;
+					return unit;
+				}
+				side = -1;
+				expectSymbol = true;
+				++p;
+				continue;
+			}
+
+			const char* name = p;
+			while (p != last && is_symbol_char(p, last))
+			{
+				unsigned lead = byte_at(p, 0);
+				size_t length = lead < 0x80 ? 1 : lead < 0xe0 ? 2 : 3;
+				p += length < static_cast<size_t>(last - p) ? length : static_cast<size_t>(last - p);
+			}
+			if (p == name)
+			{
+				unit.ptr = name;
+				unit.ec = parse_errc::invalid_unit;
+				return unit;
+			}
+
+			unitscxx::unit_lookup found = unitscxx::find_unit(name, static_cast<size_t>(p - name));
+			const unitscxx::registered_unit* symbol = found.unit;
+			if (symbol == nullptr)
+			{
+				unit.ptr = name;
+				unit.ec = parse_errc::unknown_unit;
+				return unit;
+			}
+
+			int exponent = 1;
+			if (!parse_exponent(p, last, exponent))
+			{
+				unit.ptr = name;
+				unit.ec = parse_errc::invalid_unit;
+				return unit;
+			}
+			exponent *= side;
+			for (size_t i = 0; i < base_count; ++i)
+			{
+				unit.exponents[i] += symbol->exponents[i] * exponent;
+			}
+			unit.decimal += found.decimal * exponent;
+			for (int i = 0; i < exponent; ++i)
+			{
+				unit.factor *= symbol->factor;
+			}
+			for (int i = 0; i > exponent; --i)
+			{
+				unit.factor /= symbol->factor;
+			}
+
+			size_t length = 0;
+			if (p != last && (length = multiplication(p, last)) != 0)
+			{
+				p += length;
+				expectSymbol = true;
+			}
+			else if (p != last && *p == '/')
+			{
+				expectSymbol = false;
+			}
+			else
+			{
+				unit.ptr = p;
+				return unit;
+			}
+		}
+	}
+
+	// log10 of a power of ten, or 0 for anything else
+	constexpr int decimal_exponent(intmax_t value)
+	{
+		int exponent = 0;
+		for (; value % 10 == 0; value /= 10)
+		{
+			++exponent;
+		}
+		return value == 1 ? exponent : 0;
+	}
+
+	// How to turn a number in the parsed unit into a raw value of the target
+	// type: raw = number * factor * 10^decimal.
+	struct conversion
+	{
+		double factor = 1;
+		int decimal = 0;
+
+		double apply(double number) const
+		{
+			double raw = number * factor;
+			int n = decimal < 0 ? -decimal : decimal;
+			for (; n > 22; n -= 22)
+			{
+				raw = decimal < 0 ? raw / 1e22 : raw * 1e22;
+			}
+			return decimal < 0 ? raw / exact_powers_of_ten[n] : raw * exact_powers_of_ten[n];
+		}
+	};
+
+	template<typename Quantity>
+	constexpr parse_errc make_conversion(const unit_value& unit, conversion& result)
+	{
+		using dim = typename Quantity::dimension;
+		using scale = typename Quantity::scale;
+		static_assert(dim::denominator == 1,
+			"text units have whole exponents");
+		for (size_t i = 0; i < base_count; ++i)
+		{
+			if (unit.exponents[i] != exponent_at(dim{}, i))
+			{
+				return parse_errc::dimension_mismatch;
+			}
+		}
+		constexpr int numDecimal = decimal_exponent(scale::num);
+		constexpr int denDecimal = decimal_exponent(scale::den);
+		result.factor = unit.factor
+			* (numDecimal == 0 ? 1.0 / scale::num : 1.0)
+			* (denDecimal == 0 ? scale::den : 1.0);
+		result.decimal = unit.decimal - numDecimal + denDecimal;
+		return parse_errc::ok;
+	}
+
+#pragma mark - Numbers
+	inline bool is_digit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+#if defined(__cpp_lib_to_chars)
+	inline unitscxx::parse_result parse_number(const char* first, const char* last, double& value)
+	{
+		auto result = std::from_chars(first, last, value);
+		if (result.ec == std::errc::invalid_argument)
+		{
+			return {first, parse_errc::invalid_number};
+		}
+		if (result.ec == std::errc::result_out_of_range)
+		{
+			return {result.ptr, parse_errc::out_of_range};
+		}
+		return {result.ptr, parse_errc::ok};
+	}
+#else
+	// Decimal numbers with an optional exponent, in the format of
+	// std::from_chars (no leading '+', no hexadecimal). Up to 15 significant
+	// digits with a small exponent are converted exactly; longer or larger
+	// numbers go through long double and may be off by one ulp.
+	inline unitscxx::parse_result parse_number(const char* first, const char* last, double& value)
+	{
+		const char* p = first;
+		bool negative = p != last && *p == '-';
+		p += negative;
+
+		uint64_t mantissa = 0;
+		int significant = 0;
+		int exponent = 0;
+		bool any = false;
+		for (; p != last && is_digit(*p); ++p, any = true)
+		{
+			if (significant < 19)
+			{
+				mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+				significant += mantissa != 0;
+			}
+			else
+			{
+				++exponent;
+			}
+		}
+		if (p != last && *p == '.')
+		{
+			++p;
+			for (; p != last && is_digit(*p); ++p, any = true)
+			{
+				if (significant < 19)
+				{
+					mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+					significant += mantissa != 0;
+					--exponent;
+				}
+			}
+		}
+		if (!any)
+		{
+			return {first, parse_errc::invalid_number};
+		}
+
+		if (p != last && (*p == 'e' || *p == 'E'))
+		{
+			const char* e = p + 1;
+			bool negativeExponent = e != last && *e == '-';
+			e += e != last && (*e == '-' || *e == '+');
+			if (e != last && is_digit(*e))
+			{
+				int written = 0;
+				for (; e != last && is_digit(*e); ++e)
+				{
+					written = written < 100000 ? written * 10 + (*e - '0') : written;
+				}
+				exponent += negativeExponent ? -written : written;
+				p = e;
+			}
+		}
+
+		double result;
+		if (mantissa == 0)
+		{
+			result = 0;
+		}
+		else if (mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22)
+		{
+			result = exponent < 0
+				? static_cast<double>(mantissa) / exact_powers_of_ten[-exponent]
+				: static_cast<double>(mantissa) * exact_powers_of_ten[exponent];
+		}
+		else
+		{
+			long double scaled = static_cast<long double>(mantissa);
+			long double power = 10;
+			for (unsigned n = static_cast<unsigned>(exponent < 0 ? -exponent : exponent); n != 0; n >>= 1)
+			{
+				if (n & 1)
+				{
+					scaled = exponent < 0 ? scaled / power : scaled * power;
+				}
+				power *= power;
+			}
+			result = static_cast<double>(scaled);
+			if (std::isinf(result) || (result == 0 && exponent < 0))
+			{
+				return {p, parse_errc::out_of_range};
+			}
+		}
+		value = negative ? -result : result;
+		return {p, parse_errc::ok};
+	}
+#endif
+
+#pragma mark - Storing
+	template<typename NT>
+	parse_errc store(double raw, NT& out, std::true_type /* floating point */)
+	{
+		if (std::isinf(raw) || std::abs(raw) > static_cast<double>(std::numeric_limits<NT>::max()))
+		{
+			return parse_errc::out_of_range;
+		}
+		out = static_cast<NT>(raw);
+		return parse_errc::ok;
+	}
+
+	// Integer types take whole values, allowing for the rounding error of
+	// converting through double ("0.003 km" is 3 m).
+	template<typename NT>
+	parse_errc store(double raw, NT& out, std::false_type /* floating point */)
+	{
+		double rounded = std::round(raw);
+		if (!(rounded >= static_cast<double>(std::numeric_limits<NT>::min())
+			&& rounded < static_cast<double>(std::numeric_limits<NT>::max()) + 1.0))
+		{
+			return parse_errc::out_of_range;
+		}
+		if (std::abs(raw - rounded) > std::abs(raw) * 4 * std::numeric_limits<double>::epsilon())
+		{
+			return parse_errc::inexact;
+		}
+		out = static_cast<NT>(rounded);
+		return parse_errc::ok;
+	}
+
+	template<typename NT>
+	parse_errc store(double raw, NT& out)
+	{
+		return store(raw, out, std::is_floating_point<NT>{});
+	}
+
+	template<typename Quantity>
+	struct parse_target
+	{
+		static_assert(std::is_same<typename Quantity::unit_system,
+			unitscxx::si::units>::value, "can only parse SI-based quantities");
+		static_assert(!std::is_const<Quantity>::value,
+			"can't parse into a const quantity (use ::var)");
+	};
+
+	// The last few unit spellings seen by parse_lines and what they resolved
+	// to. A column of telemetry rarely uses more than a handful.
+	struct unit_cache
+	{
+		static constexpr size_t capacity = 4;
+		const char* text[capacity] = {};
+		size_t length[capacity] = {};
+		conversion conversions[capacity];
+		size_t next = 0;
+
+		const conversion* find(const char* unit, size_t unitLength) const
+		{
+			for (size_t i = 0; i < capacity; ++i)
+			{
+				if (text[i] != nullptr && length[i] == unitLength
+					&& std::memcmp(text[i], unit, unitLength) == 0)
+				{
+					return &conversions[i];
+				}
+			}
+			return nullptr;
+		}
+
+		const conversion* insert(const char* unit, size_t unitLength, conversion value)
+		{
+			size_t i = next;
+			next = (next + 1) % capacity;
+			text[i] = unit;
+			length[i] = unitLength;
+			conversions[i] = value;
+			return &conversions[i];
+		}
+	};
+
+	inline const char* skip_blanks(const char* p, const char* last)
+	{
+		while (p != last && (*p == ' ' || *p == '\t'))
+		{
+			++p;
+		}
+		return p;
+	}
+}
+}
+
+namespace unitscxx
+{
+#pragma mark - Parsing
+	// Parses "value unit" at the start of [first, last) into value, like
+	// std::from_chars: ptr points past the unit (or to the error), and value
+	// is unchanged on error. Blanks may separate the number and the unit.
+	template<typename Quantity>
+	parse_result from_chars(const char* first, const char* last, Quantity& value)
+	{
+		(void)detail::parse::parse_target<Quantity>{};
+		double number = 0;
+		parse_result result = detail::parse::parse_number(first, last, number);
+		if (result.ec != parse_errc::ok)
+		{
+			return result;
+		}
+
+		const char* unitStart = detail::parse::skip_blanks(result.ptr, last);
+		detail::parse::unit_value unit = detail::parse::parse_unit(unitStart, last);
+		if (unit.ec != parse_errc::ok)
+		{
+			return {unit.ptr, unit.ec};
+		}
+		const char* end = unit.ptr == unitStart ? result.ptr : unit.ptr;
+
+		detail::parse::conversion conversion;
+		parse_errc ec = detail::parse::make_conversion<Quantity>(unit, conversion);
+		typename Quantity::numeric_type raw{};
+		if (ec == parse_errc::ok)
+		{
+			ec = detail::parse::store(conversion.apply(number), raw);
+		}
+		if (ec != parse_errc::ok)
+		{
+			return {first, ec};
+		}
+		value = Quantity(raw);
+		return {end, parse_errc::ok};
+	}
+
+	// Parses "value unit" when the unit is only known at runtime, for
+	// instance from a configuration file. The value is stored in base units
+	// of scale 1.
+	template<typename NT>
+	parse_result from_chars(const char* first, const char* last,
+		dyn_quantity<NT, si::units>& value)
+	{
+		double number = 0;
+		parse_result result = detail::parse::parse_number(first, last, number);
+		if (result.ec != parse_errc::ok)
+		{
+			return result;
+		}
+
+		const char* unitStart = detail::parse::skip_blanks(result.ptr, last);
+		detail::parse::unit_value unit = detail::parse::parse_unit(unitStart, last);
+		if (unit.ec != parse_errc::ok)
+		{
+			return {unit.ptr, unit.ec};
+		}
+		const char* end = unit.ptr == unitStart ? result.ptr : unit.ptr;
+
+		detail::parse::conversion conversion;
+		conversion.factor = unit.factor;
+		conversion.decimal = unit.decimal;
+		NT raw{};
+		parse_errc ec = detail::parse::store(conversion.apply(number), raw);
+		if (ec != parse_errc::ok)
+		{
+			return {first, ec};
+		}
+		value = dyn_quantity<NT, si::units>(raw,
+			dyn_dimension<si::units>::from_exponents(unit.exponents));
+		return {end, parse_errc::ok};
+	}
+
+	struct parse_lines_result
+	{
+		const char* ptr; // start of the line that stopped parsing, or last
+		size_t count;    // number of values written
+		parse_errc ec;
+	};
+
+	// Parses one "value unit" per line into out, skipping blank lines. Stops
+	// at the first bad line, or when out is full; ptr can be used to resume.
+	// Lines tend to repeat the same few units, so the text of recent units
+	// is remembered and compared before parsing a unit again.
+	template<typename Quantity, size_t Extent>
+	parse_lines_result parse_lines(const char* first, const char* last,
+		quantity_span<Quantity, Extent> out)
+	{
+		(void)detail::parse::parse_target<Quantity>{};
+		using detail::parse::skip_blanks;
+		auto* values = out.data();
+		size_t count = 0;
+
+		detail::parse::unit_cache cache;
+
+		const char* p = first;
+		while (p != last)
+		{
+			const char* line = p;
+			p = skip_blanks(p, last);
+			if (p != last && (*p == '\n' || *p == '\r'))
+			{
+				++p;
+				continue;
+			}
+			if (p == last)
+			{
+				break;
+			}
+			if (count == out.size())
+			{
+				return {line, count, parse_errc::ok};
+			}
+
+			double number = 0;
+			parse_result result = detail::parse::parse_number(p, last, number);
+			if (result.ec != parse_errc::ok)
+			{
+				return {line, count, result.ec};
+			}
+
+			const char* unit = skip_blanks(result.ptr, last);
+			const char* unitEnd = unit;
+			while (unitEnd != last && *unitEnd != ' ' && *unitEnd != '\t'
+				&& *unitEnd != '\r' && *unitEnd != '\n')
+			{
+				++unitEnd;
+			}
+			size_t length = static_cast<size_t>(unitEnd - unit);
+			const detail::parse::conversion* conversion = cache.find(unit, length);
+			if (conversion == nullptr)
+			{
+				detail::parse::conversion resolved;
+				detail::parse::unit_value parsed = detail::parse::parse_unit(unit, unitEnd);
+				parse_errc ec = parsed.ec != parse_errc::ok ? parsed.ec
+					: parsed.ptr != unitEnd ? parse_errc::trailing_characters
+					: detail::parse::make_conversion<Quantity>(parsed, resolved);
+				if (ec != parse_errc::ok)
+				{
+					return {line, count, ec};
+				}
+				conversion = cache.insert(unit, length, resolved);
+			}
+
+			p = skip_blanks(unitEnd, last);
+			if (p != last && *p != '\r' && *p != '\n')
+			{
+				return {line, count, parse_errc::trailing_characters};
+			}
+			parse_errc ec = detail::parse::store(conversion->apply(number), values[count]);
+			if (ec != parse_errc::ok)
+			{
+				return {line, count, ec};
+			}
+			++count;
+		}
+		return {last, count, parse_errc::ok};
+	}
+
+	template<typename Quantity, size_t Extent>
+	parse_lines_result parse_lines(const char* first, const char* last,
+		quantity_array<Quantity, Extent>& out)
+	{
+		return parse_lines(first, last, quantity_span<Quantity>(out));
+	}
+}
+
+#endif
@@ -0,0 +1,249 @@
+//
+// quantity_point.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef QUANTITY_POINT_HPP
+#define QUANTITY_POINT_HPP
+
+#include <ratio>
+#include <type_traits>
+#include "units.hpp"
+
+// Points on a scale whose zero is not the zero of the quantity, like
+// temperatures in Celsius or Fahrenheit. A quantity_point stores a quantity
+// counted from its origin, and the origin is a std::ratio of base units in
+// the type (273.15 K for Celsius), next to the scale of the quantity (5/9 K
+// for Fahrenheit). Plain quantities play the role of differences:
+//
+//   point - point = quantity
+//   point + quantity = point
+//
+// Offsets cancel when both sides share an origin, and are otherwise folded
+// with the scale into one multiplication and one addition when a point is
+// converted to another origin.
+
+namespace unitscxx
+{
+	template<typename Quantity, typename Origin>
+	class quantity_point;
+}
+
+namespace detail
+{
+	// The origin of a point type, and 0 for quantities.
+	template<typename T>
+	struct origin_of_
+	{
+		using type = std::ratio<0>;
+		static constexpr bool is_point = false;
+	};
+
+	template<typename Q, typename O>
+	struct origin_of_<unitscxx::quantity_point<Q, O>>
+	{
+		using type = O;
+		static constexpr bool is_point = true;
+	};
+
+	template<typename T>
+	using origin_of = typename origin_of_<std::remove_cv_t<T>>::type;
+
+	// The offset of FromOrigin relative to ToOrigin, in units of ToScale.
+	template<typename FromOrigin, typename ToOrigin, typename ToScale>
+	using origin_offset = std::ratio_divide<std::ratio_subtract<FromOrigin, ToOrigin>, ToScale>;
+
+	template<typename ToNT, typename ToScale, typename ToOrigin,
+		typename FromNT, typename FromScale, typename FromOrigin>
+	using is_lossless_rebase = std::integral_constant<bool,
+		is_lossless_conversion<ToNT, ToScale, FromNT, FromScale>::value
+		&& (std::is_floating_point<ToNT>::value
+			|| origin_offset<FromOrigin, ToOrigin, ToScale>::den == 1)>;
+
+	// The raw value of a point at another origin and scale: value * factor +
+	// offset, with both folded at compile time.
+	template<typename To, typename ToScale, typename ToOrigin,
+		typename FromScale, typename FromOrigin, typename NT>
+	constexpr To rebase(NT value)
+	{
+		using offset = origin_offset<FromOrigin, ToOrigin, ToScale>;
+		using CT = std::common_type_t<To, NT>;
+		static_assert(std::is_floating_point<CT>::value || offset::den == 1,
+			"the origins are not a whole number of units apart");
+		return offset::num == 0
+			? rescale<To, FromScale, ToScale>(value)
+			: static_cast<To>(rescale<CT, FromScale, ToScale>(value)
+				+ static_cast<CT>(offset::num) / static_cast<CT>(offset::den));
+	}
+}
+
+namespace unitscxx
+{
+	template<typename Quantity, typename Origin = std::ratio<0>>
+	class quantity_point;
+
+	template<typename Quantity, typename Origin>
+	class quantity_point
+	{
+		Quantity fromOrigin;
+
+		template<typename Q>
+		using same_dimension = std::is_same<typename Q::dimension, typename Quantity::dimension>;
+
+	public:
+		using quantity_type = Quantity;
+		using numeric_type = typename Quantity::numeric_type;
+		using dimension = typename Quantity::dimension;
+		using scale = typename Quantity::scale;
+		using origin = Origin;
+
+		template<typename Q, typename O>
+		friend class quantity_point;
+
+		constexpr quantity_point() : fromOrigin{}
+		{
+		}
+
+		explicit quantity_point(for_overwrite_t) : fromOrigin(for_overwrite)
+		{
+		}
+
+		// The point at distance q from the origin.
+		explicit constexpr quantity_point(Quantity q) : fromOrigin(q)
+		{
+		}
+
+		// The same point measured from another origin. Implicit when nothing
+		// can be lost, like quantity conversions.
+		template<typename Q, typename O, typename = std::enable_if_t<same_dimension<Q>::value
+			&& detail::is_lossless_rebase<numeric_type, scale, Origin,
+				typename Q::numeric_type, typename Q::scale, O>::value>>
+		constexpr quantity_point(quantity_point<Q, O> that)
+			: fromOrigin(detail::rebase<numeric_type, scale, Origin,
+				typename Q::scale, O>(that.raw_value()))
+		{
+		}
+
+		template<typename Q, typename O, typename = std::enable_if_t<same_dimension<Q>::value
+			&& !detail::is_lossless_rebase<numeric_type, scale, Origin,
+				typename Q::numeric_type, typename Q::scale, O>::value>, typename = void>
+		explicit constexpr quantity_point(quantity_point<Q, O> that)
+			: fromOrigin(detail::rebase<numeric_type, scale, Origin,
+				typename Q::scale, O>(that.raw_value()))
+		{
+		}
+
+		UNITS_ATTR_NODISCARD constexpr numeric_type raw_value() const
+		{
+			return fromOrigin.raw_value();
+		}
+
+		UNITS_ATTR_NODISCARD constexpr Quantity quantity_from_origin() const
+		{
+			return fromOrigin;
+		}
+
+		template<typename NT, typename S>
+		quantity_point& operator+=(quantity<NT, dimension, S> delta)
+		{
+			fromOrigin += delta;
+			return *this;
+		}
+
+		template<typename NT, typename S>
+		quantity_point& operator-=(quantity<NT, dimension, S> delta)
+		{
+			fromOrigin -= delta;
+			return *this;
+		}
+
+		template<typename NT, typename S>
+		UNITS_ATTR_NODISCARD constexpr auto operator+(quantity<NT, dimension, S> delta) const
+		{
+			return quantity_point<decltype(fromOrigin + delta), Origin>(fromOrigin + delta);
+		}
+
+		template<typename NT, typename S>
+		UNITS_ATTR_NODISCARD constexpr auto operator-(quantity<NT, dimension, S> delta) const
+		{
+			return quantity_point<decltype(fromOrigin - delta), Origin>(fromOrigin - delta);
+		}
+
+		// The difference between two points, in the common numeric type of
+		// both. With different origins, the right side is first converted to
+		// the origin and scale of the left.
+		template<typename Q, typename O, typename = std::enable_if_t<same_dimension<Q>::value>>
+		UNITS_ATTR_NODISCARD constexpr auto operator-(quantity_point<Q, O> that) const
+		{
+			using common = std::common_type_t<numeric_type, typename Q::numeric_type>;
+			using delta = quantity<common, dimension, scale>;
+			return delta(fromOrigin.raw_value()) - delta(detail::rebase<common, scale, Origin,
+				typename Q::scale, O>(that.raw_value()));
+		}
+
+		template<typename Q>
+		UNITS_ATTR_NODISCARD constexpr bool operator==(quantity_point<Q, Origin> that) const
+		{
+			return fromOrigin == that.fromOrigin;
+		}
+
+		template<typename Q>
+		UNITS_ATTR_NODISCARD constexpr bool operator!=(quantity_point<Q, Origin> that) const
+		{
+			return fromOrigin != that.fromOrigin;
+		}
+
+		template<typename Q>
+		UNITS_ATTR_NODISCARD constexpr bool operator<(quantity_point<Q, Origin> that) const
+		{
+			return fromOrigin < that.fromOrigin;
+		}
+
+		template<typename Q>
+		UNITS_ATTR_NODISCARD constexpr bool operator>(quantity_point<Q, Origin> that) const
+		{
+			return fromOrigin > that.fromOrigin;
+		}
+
+		template<typename Q>
+		UNITS_ATTR_NODISCARD constexpr bool operator<=(quantity_point<Q, Origin> that) const
+		{
+			return fromOrigin <= that.fromOrigin;
+		}
+
+		template<typename Q>
+		UNITS_ATTR_NODISCARD constexpr bool operator>=(quantity_point<Q, Origin> that) const
+		{
+			return fromOrigin >= that.fromOrigin;
+		}
+	};
+
+	template<typename NT, typename D, typename S, typename Q, typename O>
+	UNITS_ATTR_NODISCARD constexpr auto operator+(quantity<NT, D, S> delta, quantity_point<Q, O> point)
+	{
+		return point + delta;
+	}
+}
+
+#endif
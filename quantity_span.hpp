@@ -0,0 +1,352 @@
+//
+// quantity_span.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef QUANTITY_SPAN_HPP
+#define QUANTITY_SPAN_HPP
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include "units.hpp"
+#include "quantity_expr.hpp"
+
+// Non-owning views that let an existing buffer of numbers be used as
+// quantities of a fixed unit, without copying. Use a const quantity type
+// (for instance decltype(si::m), which is already const) for a read-only view.
+
+namespace detail
+{
+	template<typename Quantity>
+	using span_numeric_type = std::conditional_t<std::is_const<Quantity>::value,
+		const typename Quantity::numeric_type,
+		typename Quantity::numeric_type>;
+
+	template<typename Quantity>
+	struct span_layout_check
+	{
+		static_assert(unitscxx::has_numeric_layout<std::remove_cv_t<Quantity>>::value,
+			"quantity must have the same layout as its numeric type");
+	};
+}
+
+namespace unitscxx
+{
+#pragma mark - Contiguous span
+	template<typename Quantity, size_t Extent = dynamic_extent>
+	class quantity_span : detail::span_layout_check<Quantity>
+	{
+	public:
+		using element_type = Quantity;
+		using value_type = std::remove_cv_t<Quantity>;
+		using numeric_type = detail::span_numeric_type<Quantity>;
+		using size_type = size_t;
+		using reference = element_type&;
+		using pointer = element_type*;
+		using iterator = pointer;
+
+		static constexpr size_t extent = Extent;
+
+	private:
+		numeric_type* values;
+		size_t count;
+
+	public:
+		constexpr quantity_span() : values(nullptr), count(0)
+		{
+			static_assert(Extent == 0 || Extent == dynamic_extent,
+				"default-constructed fixed-size span");
+		}
+
+		constexpr quantity_span(numeric_type* data, size_t size)
+			: values(data), count(size)
+		{
+			assert((Extent == dynamic_extent || size == Extent)
+				&& "wrong size for a fixed-size quantity_span");
+		}
+
+		quantity_span(pointer data, size_t size)
+			: quantity_span(reinterpret_cast<numeric_type*>(data), size)
+		{
+		}
+
+		// Anything with data() and size() over numbers or quantities of this
+		// type: std::vector<double>, std::array, quantity_array, ...
+		template<typename Container, typename = decltype(
+			quantity_span(std::declval<Container&>().data(), size_t()))>
+		quantity_span(Container& container)
+			: quantity_span(container.data(), container.size())
+		{
+		}
+
+		template<typename Q, size_t E, typename = std::enable_if_t<
+			std::is_convertible<detail::span_numeric_type<Q>*, numeric_type*>::value
+			&& std::is_same<std::remove_cv_t<Q>, value_type>::value
+			&& (Extent == dynamic_extent || Extent == E)>>
+		constexpr quantity_span(const quantity_span<Q, E>& that)
+			: quantity_span(that.data(), that.size())
+		{
+		}
+
+		UNITS_ATTR_NODISCARD constexpr size_t size() const { return count; }
+		UNITS_ATTR_NODISCARD constexpr bool empty() const { return count == 0; }
+
+		// The raw numeric storage, for handing to routines that don't know
+		// about units.
+		UNITS_ATTR_NODISCARD constexpr numeric_type* data() const { return values; }
+
+		UNITS_ATTR_NODISCARD reference operator[](size_t index) const
+		{
+			assert(index < count && "quantity_span index out of range");
+			return reinterpret_cast<reference>(values[index]);
+		}
+
+		UNITS_ATTR_NODISCARD iterator begin() const { return reinterpret_cast<pointer>(values); }
+		UNITS_ATTR_NODISCARD iterator end() const { return begin() + count; }
+
+		// Evaluates an expression over quantity containers into the viewed
+		// buffer. (Assignment operators rebind the span, like std::span.)
+		template<typename Expr, typename = std::enable_if_t<
+			detail::expr::is_node<std::decay_t<Expr>>::value>>
+		void assign(const Expr& expr) const
+		{
+			static_assert(!std::is_const<Quantity>::value,
+				"assigning through a read-only quantity_span");
+			detail::expr::assign<value_type>(expr, values, count);
+		}
+
+		UNITS_ATTR_NODISCARD quantity_span<Quantity> subspan(size_t offset,
+			size_t size = dynamic_extent) const
+		{
+			assert(offset <= count && (size == dynamic_extent || size <= count - offset)
+				&& "subspan out of range");
+			return {values + offset, size == dynamic_extent ? count - offset : size};
+		}
+
+		UNITS_ATTR_NODISCARD quantity_span<Quantity> first(size_t size) const
+		{
+			return subspan(0, size);
+		}
+
+		UNITS_ATTR_NODISCARD quantity_span<Quantity> last(size_t size) const
+		{
+			assert(size <= count && "last() out of range");
+			return subspan(count - size, size);
+		}
+	};
+
+	template<typename Quantity, size_t Extent>
+	constexpr size_t quantity_span<Quantity, Extent>::extent;
+
+}
+
+namespace detail
+{
+namespace expr
+{
+	template<typename Quantity, size_t Extent>
+	struct is_range<unitscxx::quantity_span<Quantity, Extent>> : std::true_type
+	{
+	};
+}
+}
+
+namespace unitscxx
+{
+#pragma mark - Strided span
+	// Every stride-th number of a buffer, for instance one channel of
+	// interleaved samples. The stride is counted in numbers, not bytes.
+	template<typename Quantity>
+	class quantity_strided_span : detail::span_layout_check<Quantity>
+	{
+	public:
+		using element_type = Quantity;
+		using value_type = std::remove_cv_t<Quantity>;
+		using numeric_type = detail::span_numeric_type<Quantity>;
+		using size_type = size_t;
+		using reference = element_type&;
+
+		class iterator
+		{
+			numeric_type* position;
+			ptrdiff_t step;
+
+		public:
+			using iterator_category = std::random_access_iterator_tag;
+			using value_type = quantity_strided_span::value_type;
+			using difference_type = ptrdiff_t;
+			using pointer = element_type*;
+			using reference = element_type&;
+
+			iterator(numeric_type* position, ptrdiff_t step)
+				: position(position), step(step)
+			{
+			}
+
+			reference operator*() const { return reinterpret_cast<reference>(*position); }
+			reference operator[](ptrdiff_t n) const { return *(*this + n); }
+			iterator& operator++() { position += step; return *this; }
+			iterator operator++(int) { iterator copy = *this; ++*this; return copy; }
+			iterator& operator--() { position -= step; return *this; }
+			iterator operator--(int) { iterator copy = *this; --*this; return copy; }
+			iterator& operator+=(ptrdiff_t n) { position += n * step; return *this; }
+			iterator& operator-=(ptrdiff_t n) { position -= n * step; return *this; }
+			iterator operator+(ptrdiff_t n) const { return iterator(position + n * step, step); }
+			iterator operator-(ptrdiff_t n) const { return iterator(position - n * step, step); }
+			ptrdiff_t operator-(iterator that) const { return (position - that.position) / step; }
+			bool operator==(iterator that) const { return position == that.position; }
+			bool operator!=(iterator that) const { return position != that.position; }
+			bool operator<(iterator that) const { return *this - that < 0; }
+			bool operator>(iterator that) const { return that < *this; }
+			bool operator<=(iterator that) const { return !(that < *this); }
+			bool operator>=(iterator that) const { return !(*this < that); }
+		};
+
+	private:
+		numeric_type* values;
+		size_t count;
+		ptrdiff_t step;
+
+	public:
+		constexpr quantity_strided_span(numeric_type* data, size_t size, ptrdiff_t stride)
+			: values(data), count(size), step(stride)
+		{
+		}
+
+		constexpr quantity_strided_span(quantity_span<Quantity> span)
+			: values(span.data()), count(span.size()), step(1)
+		{
+		}
+
+		UNITS_ATTR_NODISCARD constexpr size_t size() const { return count; }
+		UNITS_ATTR_NODISCARD constexpr bool empty() const { return count == 0; }
+		UNITS_ATTR_NODISCARD constexpr ptrdiff_t stride() const { return step; }
+		UNITS_ATTR_NODISCARD constexpr numeric_type* data() const { return values; }
+
+		UNITS_ATTR_NODISCARD reference operator[](size_t index) const
+		{
+			assert(index < count && "quantity_strided_span index out of range");
+			return reinterpret_cast<reference>(values[static_cast<ptrdiff_t>(index) * step]);
+		}
+
+		UNITS_ATTR_NODISCARD iterator begin() const { return iterator(values, step); }
+		UNITS_ATTR_NODISCARD iterator end() const { return begin() + static_cast<ptrdiff_t>(count); }
+	};
+
+#pragma mark - Multi-dimensional span
+	// A Rank-dimensional view with an extent and a stride (in numbers) for
+	// each dimension. The default strides are row-major, like a C array.
+	template<typename Quantity, size_t Rank>
+	class quantity_mdspan : detail::span_layout_check<Quantity>
+	{
+		static_assert(Rank > 0, "quantity_mdspan needs at least one dimension");
+
+	public:
+		using element_type = Quantity;
+		using value_type = std::remove_cv_t<Quantity>;
+		using numeric_type = detail::span_numeric_type<Quantity>;
+		using size_type = size_t;
+		using reference = element_type&;
+		using index_type = std::array<size_t, Rank>;
+
+		static constexpr size_t rank = Rank;
+
+	private:
+		numeric_type* values;
+		index_type extents;
+		std::array<ptrdiff_t, Rank> strides;
+
+		ptrdiff_t offset_of(const index_type& index) const
+		{
+			ptrdiff_t offset = 0;
+			for (size_t i = 0; i < Rank; ++i)
+			{
+				assert(index[i] < extents[i] && "quantity_mdspan index out of range");
+				offset += static_cast<ptrdiff_t>(index[i]) * strides[i];
+			}
+			return offset;
+		}
+
+	public:
+		quantity_mdspan(numeric_type* data, index_type extents)
+			: values(data), extents(extents)
+		{
+			ptrdiff_t stride = 1;
+			for (size_t i = Rank; i > 0; --i)
+			{
+				strides[i - 1] = stride;
+				stride *= static_cast<ptrdiff_t>(extents[i - 1]);
+			}
+		}
+
+		quantity_mdspan(numeric_type* data, index_type extents,
+			std::array<ptrdiff_t, Rank> strides)
+			: values(data), extents(extents), strides(strides)
+		{
+		}
+
+		UNITS_ATTR_NODISCARD size_t extent(size_t dimension) const { return extents[dimension]; }
+		UNITS_ATTR_NODISCARD ptrdiff_t stride(size_t dimension) const { return strides[dimension]; }
+		UNITS_ATTR_NODISCARD numeric_type* data() const { return values; }
+
+		UNITS_ATTR_NODISCARD size_t size() const
+		{
+			size_t size = 1;
+			for (size_t extent : extents)
+			{
+				size *= extent;
+			}
+			return size;
+		}
+
+		template<typename... Indices, typename = std::enable_if_t<sizeof...(Indices) == Rank>>
+		UNITS_ATTR_NODISCARD reference operator()(Indices... indices) const
+		{
+			return (*this)[index_type{{static_cast<size_t>(indices)...}}];
+		}
+
+		UNITS_ATTR_NODISCARD reference operator[](const index_type& index) const
+		{
+			return reinterpret_cast<reference>(values[offset_of(index)]);
+		}
+
+		// A view along one dimension, starting at index and keeping every
+		// other coordinate fixed.
+		UNITS_ATTR_NODISCARD quantity_strided_span<Quantity> along(size_t dimension,
+			const index_type& index) const
+		{
+			return {values + offset_of(index), extents[dimension] - index[dimension],
+				strides[dimension]};
+		}
+	};
+
+	template<typename Quantity, size_t Rank>
+	constexpr size_t quantity_mdspan<Quantity, Rank>::rank;
+}
+
+#endif
@@ -0,0 +1,471 @@
+//
+// quantity_stats.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef QUANTITY_STATS_HPP
+#define QUANTITY_STATS_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include "units.hpp"
+#include "quantity_span.hpp"
+#include "simd.hpp"
+
+// Single-pass estimators over streams of quantities, in constant memory:
+//
+//   quantity_stats<Q>   count, mean, variance (in Q's units squared),
+//                       standard deviation, min and max
+//   quantity_digest<Q>  a t-digest, for quantiles such as the p50 and p99
+//
+// Both take values one at a time with += or a buffer at once with add(span),
+// and merge with +, so each thread or shard can keep its own and combine them
+// when reporting.
+
+namespace detail
+{
+namespace statistics
+{
+	constexpr size_t block_size = 1024;
+
+	// Welford's running mean and sum of squared deviations.
+	template<typename T>
+	struct moments
+	{
+		std::uint64_t count = 0;
+		T mean = 0;
+		T m2 = 0;
+		T minimum = std::numeric_limits<T>::infinity();
+		T maximum = -std::numeric_limits<T>::infinity();
+
+		void add(T value)
+		{
+			++count;
+			T delta = value - mean;
+			mean += delta / T(count);
+			m2 += delta * (value - mean);
+			minimum = std::min(minimum, value);
+			maximum = std::max(maximum, value);
+		}
+
+		// Chan, Golub and LeVeque's update for two partial results.
+		void merge(const moments& that)
+		{
+			if (that.count == 0)
+			{
+				return;
+			}
+			if (count == 0)
+			{
+				*this = that;
+				return;
+			}
+			
+			T delta = that.mean - mean;
+			T weight = T(that.count) / T(count + that.count);
+			mean += delta * weight;
+			m2 += that.m2 + delta * delta * T(count) * weight;
+			count += that.count;
+			minimum = std::min(minimum, that.minimum);
+			maximum = std::max(maximum, that.maximum);
+		}
+	};
+
+	// The moments of a block that fits in L1, in two vectorized passes: sum,
+	// min and max, then the squared deviations from the block's mean.
+	template<typename T>
+	moments<T> block_moments(const T* values, size_t count)
+	{
+		auto summary = simd::summarize(values, count);
+		moments<T> result;
+		result.count = count;
+		result.mean = summary.sum / T(count);
+		result.m2 = simd::squared_deviations(values, count, result.mean);
+		result.minimum = summary.minimum;
+		result.maximum = summary.maximum;
+		return result;
+	}
+
+	template<typename T>
+	struct centroid
+	{
+		T mean;
+		T weight;
+	};
+
+	// Merging t-digest (Dunning and Ertl). Values are buffered, then sorted
+	// and merged into centroids that are smallest near q = 0 and q = 1: the
+	// smallest and largest values stay alone, so tail quantiles are the most
+	// accurate.
+	template<typename T>
+	class digest
+	{
+		T compression;
+		size_t bufferCapacity;
+		std::vector<T> buffer;
+		std::vector<centroid<T>> centroids;
+		std::vector<centroid<T>> incoming;
+		std::vector<centroid<T>> sorted;
+		T total = 0;
+		T minimum = std::numeric_limits<T>::infinity();
+		T maximum = -std::numeric_limits<T>::infinity();
+		
+		// The largest quantile that a centroid starting at q may reach: one
+		// step of the stricter of two scale functions. k1 = compression / 2pi *
+		// asin(2q - 1) bounds centroids in the middle, and k2 = compression /
+		// (4 log(n / compression) + 24) * logit(q), which multiplies the odds
+		// q / (1 - q) by `growth`, bounds them near the ends.
+		T quantile_limit(T q, T growth) const
+		{
+			const T pi = T(3.14159265358979323846);
+			T k1 = compression / (2 * pi) * std::asin(2 * q - 1) + 1;
+			T limit1 = k1 >= compression / 4 ? 1 : (std::sin(k1 * 2 * pi / compression) + 1) / 2;
+			T limit2 = q * growth / (1 - q + q * growth);
+			return std::min(limit1, limit2);
+		}
+		
+		// Merges centroids sorted by mean into these, then combines neighbors
+		// as long as they stay within the scale function's limit.
+		void absorb(const std::vector<centroid<T>>& that, T weight)
+		{
+			sorted.clear();
+			std::merge(centroids.begin(), centroids.end(), that.begin(), that.end(), std::back_inserter(sorted),
+				[](const centroid<T>& a, const centroid<T>& b) { return a.mean < b.mean; });
+			total += weight;
+			
+			T normalizer = compression / (4 * std::log(std::max(total / compression, T(1))) + 24);
+			T growth = std::exp(1 / normalizer);
+			T before = 0;
+			T limit = 0;
+			centroids.clear();
+			centroids.push_back(sorted[0]);
+			for (size_t i = 1; i < sorted.size(); ++i)
+			{
+				centroid<T>& last = centroids.back();
+				if (before + last.weight + sorted[i].weight <= limit)
+				{
+					last.weight += sorted[i].weight;
+					last.mean += (sorted[i].mean - last.mean) * sorted[i].weight / last.weight;
+				}
+				else
+				{
+					before += last.weight;
+					limit = total * quantile_limit(before / total, growth);
+					centroids.push_back(sorted[i]);
+				}
+			}
+		}
+		
+	public:
+		explicit digest(T factor)
+		: compression(factor), bufferCapacity(factor >= 1 ? size_t(factor) * 5 : 5)
+		{
+			buffer.reserve(bufferCapacity);
+		}
+		
+		T count() const { return total + T(buffer.size()); }
+		T min() const { return minimum; }
+		T max() const { return maximum; }
+		
+		void add(T value)
+		{
+			minimum = std::min(minimum, value);
+			maximum = std::max(maximum, value);
+			buffer.push_back(value);
+			if (buffer.size() >= bufferCapacity)
+			{
+				compress();
+			}
+		}
+		
+		void add(const T* values, size_t count)
+		{
+			while (count != 0)
+			{
+				size_t chunk = std::min(count, bufferCapacity - buffer.size());
+				auto summary = simd::summarize(values, chunk);
+				minimum = std::min(minimum, summary.minimum);
+				maximum = std::max(maximum, summary.maximum);
+				buffer.insert(buffer.end(), values, values + chunk);
+				values += chunk;
+				count -= chunk;
+				if (buffer.size() >= bufferCapacity)
+				{
+					compress();
+				}
+			}
+		}
+		
+		void merge(const digest& that)
+		{
+			add(that.buffer.data(), that.buffer.size());
+			compress();
+			if (that.total != 0)
+			{
+				minimum = std::min(minimum, that.minimum);
+				maximum = std::max(maximum, that.maximum);
+				absorb(that.centroids, that.total);
+			}
+		}
+		
+		// New values are sorted on their own, which is cheaper than sorting
+		// them as centroids, and then merged with the existing centroids.
+		void compress()
+		{
+			if (buffer.empty())
+			{
+				return;
+			}
+			
+			std::sort(buffer.begin(), buffer.end());
+			incoming.clear();
+			for (T value : buffer)
+			{
+				incoming.push_back({value, 1});
+			}
+			absorb(incoming, T(buffer.size()));
+			buffer.clear();
+		}
+		
+		// Each centroid's weight is centered on its mean, and the exact min and
+		// max sit at ranks 0 and count; quantiles interpolate in between.
+		T quantile(T q) const
+		{
+			if (!buffer.empty())
+			{
+				digest copy(*this);
+				copy.compress();
+				return copy.quantile(q);
+			}
+			if (centroids.empty())
+			{
+				return std::numeric_limits<T>::quiet_NaN();
+			}
+			
+			T rank = std::min(std::max(q, T(0)), T(1)) * total;
+			T previousRank = 0;
+			T previousValue = minimum;
+			T seen = 0;
+			for (const auto& value : centroids)
+			{
+				T center = seen + value.weight / 2;
+				if (rank < center)
+				{
+					return previousValue + (value.mean - previousValue) * (rank - previousRank) / (center - previousRank);
+				}
+				previousRank = center;
+				previousValue = value.mean;
+				seen += value.weight;
+			}
+			if (total == previousRank)
+			{
+				return maximum;
+			}
+			return previousValue + (maximum - previousValue) * (rank - previousRank) / (total - previousRank);
+		}
+	};
+}
+}
+
+namespace unitscxx
+{
+	template<typename Quantity>
+	class quantity_stats
+	{
+	public:
+		using value_type = std::remove_cv_t<Quantity>;
+		using numeric_type = typename value_type::numeric_type;
+		using squared_type = decltype(std::declval<value_type>() * std::declval<value_type>());
+
+		static_assert(std::is_floating_point<numeric_type>::value,
+			"statistics are computed in the quantity's numeric type");
+
+	private:
+		detail::statistics::moments<numeric_type> moments;
+
+		// Squared scales past the range of std::ratio fold into the variance,
+		// as they do in value_type * value_type.
+		using square = detail::scale_product<typename value_type::scale, typename value_type::scale>;
+
+		numeric_type or_nan(numeric_type value) const
+		{
+			return moments.count == 0 ? std::numeric_limits<numeric_type>::quiet_NaN() : value;
+		}
+
+	public:
+		quantity_stats& operator+=(value_type value)
+		{
+			moments.add(value.raw_value());
+			return *this;
+		}
+
+		quantity_stats& add(quantity_span<const value_type> values)
+		{
+			for (size_t start = 0; start < values.size(); start += detail::statistics::block_size)
+			{
+				size_t count = std::min(detail::statistics::block_size, values.size() - start);
+				moments.merge(detail::statistics::block_moments(values.data() + start, count));
+			}
+			return *this;
+		}
+
+		quantity_stats& operator+=(const quantity_stats& that)
+		{
+			moments.merge(that.moments);
+			return *this;
+		}
+
+		UNITS_ATTR_NODISCARD friend quantity_stats operator+(quantity_stats left,
+			const quantity_stats& right)
+		{
+			return left += right;
+		}
+
+		UNITS_ATTR_NODISCARD std::uint64_t count() const
+		{
+			return moments.count;
+		}
+
+		// NaN when empty.
+		UNITS_ATTR_NODISCARD value_type mean() const
+		{
+			return value_type(or_nan(moments.mean));
+		}
+
+		// The population variance, divided by count.
+		UNITS_ATTR_NODISCARD squared_type variance() const
+		{
+			return squared_type(square::fold(or_nan(moments.m2 / numeric_type(moments.count))));
+		}
+
+		// The unbiased estimate, divided by count - 1.
+		UNITS_ATTR_NODISCARD squared_type sample_variance() const
+		{
+			return squared_type(square::fold(moments.count < 2
+				? std::numeric_limits<numeric_type>::quiet_NaN()
+				: moments.m2 / numeric_type(moments.count - 1)));
+		}
+
+		UNITS_ATTR_NODISCARD value_type stddev() const
+		{
+			return value_type(std::sqrt(or_nan(moments.m2 / numeric_type(moments.count))));
+		}
+
+		// +infinity and -infinity when empty.
+		UNITS_ATTR_NODISCARD value_type min() const
+		{
+			return value_type(moments.minimum);
+		}
+
+		UNITS_ATTR_NODISCARD value_type max() const
+		{
+			return value_type(moments.maximum);
+		}
+	};
+
+	// Higher compression keeps more centroids: about `compression` of them,
+	// plus a buffer of five times as many values. 100 gives quantiles within
+	// about 0.1% of rank near the median and much closer in the tails.
+	template<typename Quantity>
+	class quantity_digest
+	{
+	public:
+		using value_type = std::remove_cv_t<Quantity>;
+		using numeric_type = typename value_type::numeric_type;
+
+		static_assert(std::is_floating_point<numeric_type>::value,
+			"quantiles are interpolated in the quantity's numeric type");
+
+	private:
+		detail::statistics::digest<numeric_type> digest;
+
+	public:
+		explicit quantity_digest(numeric_type compression = 100)
+		: digest(compression)
+		{
+			assert(compression >= 1 && "quantity_digest needs a compression of at least 1");
+		}
+
+		quantity_digest& operator+=(value_type value)
+		{
+			digest.add(value.raw_value());
+			return *this;
+		}
+
+		quantity_digest& add(quantity_span<const value_type> values)
+		{
+			digest.add(values.data(), values.size());
+			return *this;
+		}
+
+		quantity_digest& operator+=(const quantity_digest& that)
+		{
+			digest.merge(that.digest);
+			return *this;
+		}
+
+		UNITS_ATTR_NODISCARD friend quantity_digest operator+(quantity_digest left,
+			const quantity_digest& right)
+		{
+			return left += right;
+		}
+
+		// Merges buffered values into the centroids. quantile() does it on a
+		// copy otherwise; compress first when asking for several quantiles.
+		void compress()
+		{
+			digest.compress();
+		}
+
+		UNITS_ATTR_NODISCARD std::uint64_t count() const
+		{
+			return std::uint64_t(digest.count());
+		}
+
+		// q in [0, 1], for instance 0.99 for the p99. NaN when empty.
+		UNITS_ATTR_NODISCARD value_type quantile(numeric_type q) const
+		{
+			return value_type(digest.quantile(q));
+		}
+
+		UNITS_ATTR_NODISCARD value_type min() const
+		{
+			return value_type(digest.min());
+		}
+
+		UNITS_ATTR_NODISCARD value_type max() const
+		{
+			return value_type(digest.max());
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,363 @@
+//
+// quantity_sum.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef QUANTITY_SUM_HPP
+#define QUANTITY_SUM_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include "units.hpp"
+#include "quantity_span.hpp"
+
+// Accumulators that lose less than operator+= when adding many quantities,
+// for instance a billion small energy increments. The method is a type
+// parameter:
+//
+//   summation::neumaier     running compensation (Kahan-Babuska), for values
+//                           added one at a time; the default
+//   summation::pairwise     blocks summed in a binary tree, O(log n) error
+//                           and cheaper than compensation per element
+//   summation::kahan_lanes  several independent Kahan sums that the compiler
+//                           vectorizes, for whole buffers added with add(span)
+//
+// Sums of the same type can be merged, so they work as the value of a
+// parallel reduction. Compensation doesn't survive -ffast-math.
+
+namespace unitscxx
+{
+namespace summation
+{
+	struct neumaier
+	{
+	};
+
+	struct pairwise
+	{
+	};
+
+	template<size_t Lanes = 8>
+	struct kahan_lanes
+	{
+		static_assert(Lanes > 0 && (Lanes & (Lanes - 1)) == 0, "lanes must be a power of two");
+	};
+}
+}
+
+namespace detail
+{
+namespace accumulation
+{
+	// sum + compensation is closer to the exact sum than sum alone.
+	template<typename T>
+	void neumaier_add(T& sum, T& compensation, T value)
+	{
+		T total = sum + value;
+		if (std::abs(sum) >= std::abs(value))
+		{
+			compensation += (sum - total) + value;
+		}
+		else
+		{
+			compensation += (value - total) + sum;
+		}
+		sum = total;
+	}
+
+	template<typename T, typename Method>
+	class state;
+
+	template<typename T>
+	class state<T, unitscxx::summation::neumaier>
+	{
+		T sum = T();
+		T compensation = T();
+
+	public:
+		void add(T value)
+		{
+			neumaier_add(sum, compensation, value);
+		}
+
+		void add(const T* values, size_t count)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				neumaier_add(sum, compensation, values[i]);
+			}
+		}
+
+		void merge(const state& that)
+		{
+			neumaier_add(sum, compensation, that.sum);
+			compensation += that.compensation;
+		}
+
+		T value() const
+		{
+			return sum + compensation;
+		}
+	};
+
+	// Values are added naively into blocks of block_size; a finished block
+	// goes into a binary counter of partial sums where level k holds
+	// block_size * 2^k values, so every value goes through O(log n) additions
+	// of similar magnitude.
+	template<typename T>
+	class state<T, unitscxx::summation::pairwise>
+	{
+		static constexpr size_t block_size = 128;
+		static constexpr size_t levels = 64;
+
+		T block = T();
+		size_t blockCount = 0;
+		T partials[levels] = {};
+		unsigned long long occupied = 0;
+
+		void carry(T sum, size_t level)
+		{
+			for (; level < levels - 1 && (occupied >> level & 1); ++level)
+			{
+				sum += partials[level];
+				occupied &= ~(1ull << level);
+			}
+			partials[level] = (occupied >> level & 1) ? partials[level] + sum : sum;
+			occupied |= 1ull << level;
+		}
+
+	public:
+		void add(T value)
+		{
+			block += value;
+			if (++blockCount == block_size)
+			{
+				carry(block, 0);
+				block = T();
+				blockCount = 0;
+			}
+		}
+
+		void add(const T* values, size_t count)
+		{
+			while (count != 0)
+			{
+				size_t take = block_size - blockCount < count ? block_size - blockCount : count;
+				for (size_t i = 0; i < take; ++i)
+				{
+					block += values[i];
+				}
+				values += take;
+				count -= take;
+				blockCount += take;
+				if (blockCount == block_size)
+				{
+					carry(block, 0);
+					block = T();
+					blockCount = 0;
+				}
+			}
+		}
+
+		void merge(const state& that)
+		{
+			for (size_t level = 0; level < levels; ++level)
+			{
+				if (that.occupied >> level & 1)
+				{
+					carry(that.partials[level], level);
+				}
+			}
+			block += that.block;
+			blockCount += that.blockCount;
+			if (blockCount >= block_size)
+			{
+				carry(block, 0);
+				block = T();
+				blockCount = 0;
+			}
+		}
+
+		T value() const
+		{
+			T sum = block;
+			for (size_t level = 0; level < levels; ++level)
+			{
+				if (occupied >> level & 1)
+				{
+					sum += partials[level];
+				}
+			}
+			return sum;
+		}
+	};
+
+	// Lane i sums the elements at positions i, i + Lanes... with Kahan's
+	// compensation. The lanes don't depend on one another, so the loop over
+	// them turns into vector instructions without reordering any addition.
+	template<typename T, size_t Lanes>
+	class state<T, unitscxx::summation::kahan_lanes<Lanes>>
+	{
+		T sums[Lanes] = {};
+		T compensations[Lanes] = {};
+		size_t next = 0;
+
+		void add_lane(size_t lane, T value)
+		{
+			T y = value - compensations[lane];
+			T t = sums[lane] + y;
+			compensations[lane] = (t - sums[lane]) - y;
+			sums[lane] = t;
+		}
+
+	public:
+		void add(T value)
+		{
+			add_lane(next, value);
+			next = (next + 1) & (Lanes - 1);
+		}
+
+		void add(const T* values, size_t count)
+		{
+			// locals, so that the compiler keeps them in registers instead of
+			// assuming they alias values
+			T s[Lanes], c[Lanes];
+			for (size_t lane = 0; lane < Lanes; ++lane)
+			{
+				s[lane] = sums[lane];
+				c[lane] = compensations[lane];
+			}
+			size_t i = 0;
+			for (; i + Lanes <= count; i += Lanes)
+			{
+#pragma GCC unroll 16
+				for (size_t lane = 0; lane < Lanes; ++lane)
+				{
+					T y = values[i + lane] - c[lane];
+					T t = s[lane] + y;
+					c[lane] = (t - s[lane]) - y;
+					s[lane] = t;
+				}
+			}
+			for (size_t lane = 0; lane < Lanes; ++lane)
+			{
+				sums[lane] = s[lane];
+				compensations[lane] = c[lane];
+			}
+			for (; i < count; ++i)
+			{
+				add(values[i]);
+			}
+		}
+
+		void merge(const state& that)
+		{
+			for (size_t lane = 0; lane < Lanes; ++lane)
+			{
+				add_lane(lane, that.sums[lane]);
+				compensations[lane] += that.compensations[lane];
+			}
+		}
+
+		T value() const
+		{
+			T sum = T();
+			T compensation = T();
+			for (size_t lane = 0; lane < Lanes; ++lane)
+			{
+				neumaier_add(sum, compensation, sums[lane]);
+				compensation -= compensations[lane];
+			}
+			return sum + compensation;
+		}
+	};
+}
+}
+
+namespace unitscxx
+{
+	template<typename Quantity, typename Method = summation::neumaier>
+	class quantity_sum
+	{
+	public:
+		using value_type = std::remove_cv_t<Quantity>;
+		using numeric_type = typename value_type::numeric_type;
+		using dimension = typename value_type::dimension;
+		using scale = typename value_type::scale;
+		using method = Method;
+
+		static_assert(std::is_floating_point<numeric_type>::value,
+			"integer sums are exact with operator+=");
+
+	private:
+		detail::accumulation::state<numeric_type, Method> state;
+
+	public:
+		quantity_sum() = default;
+
+		explicit quantity_sum(value_type initial)
+		{
+			state.add(initial.raw_value());
+		}
+
+		quantity_sum& operator+=(value_type value)
+		{
+			state.add(value.raw_value());
+			return *this;
+		}
+
+		quantity_sum& operator-=(value_type value)
+		{
+			state.add(-value.raw_value());
+			return *this;
+		}
+
+		// A whole buffer at once, which is where kahan_lanes vectorizes.
+		quantity_sum& add(quantity_span<const value_type> values)
+		{
+			state.add(values.data(), values.size());
+			return *this;
+		}
+
+		quantity_sum& operator+=(const quantity_sum& that)
+		{
+			state.merge(that.state);
+			return *this;
+		}
+
+		UNITS_ATTR_NODISCARD friend quantity_sum operator+(quantity_sum left,
+			const quantity_sum& right)
+		{
+			return left += right;
+		}
+
+		UNITS_ATTR_NODISCARD value_type value() const
+		{
+			return value_type(state.value());
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,282 @@
+//
+// quantity_wire.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef QUANTITY_WIRE_HPP
+#define QUANTITY_WIRE_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "units.hpp"
+#include "dyn_quantity.hpp"
+#include "quantity_span.hpp"
+#include "quantity_column.hpp"
+
+// A binary encoding for sending quantities between processes. A batch is a
+// 40-byte header (dimension fingerprint, scale, numeric type, byte order,
+// count) followed by the raw numbers, zero-padded to a multiple of 8 bytes.
+// A single quantity is a batch of one.
+//
+//   std::vector<unsigned char> message;
+//   unitscxx::encode(quantity_span<const decltype(Pa)::var>(pressures), message);
+//   ...
+//   unitscxx::quantity_column<const decltype(kPa)::var> received;
+//   auto result = unitscxx::decode(bytes, size, received);
+//   // result.ec == wire_errc::ok, result.next is past the batch
+//
+// Decoding checks the header once for the whole batch. When the numbers are
+// the receiver's type and scale, in its byte order and suitably aligned,
+// the column views them in the buffer and received.span() costs nothing;
+// otherwise values are converted (and byte-swapped) as they are read. Headers
+// and padded numbers are both 8-byte multiples, so batches encoded one after
+// another into an aligned buffer stay aligned for numbers up to 8 bytes.
+
+namespace unitscxx
+{
+	enum class wire_errc
+	{
+		ok,
+		truncated,          // the buffer ends before the batch does
+		not_wire_data,      // the magic number doesn't match
+		unsupported,        // another version, an unknown numeric type or a bad scale
+		dimension_mismatch, // the batch doesn't measure what the type measures
+		not_single,         // a batch of several values decoded as one quantity
+		lossy_scale,        // integer quantities would truncate the batch's values
+	};
+
+	enum class wire_order : std::uint8_t
+	{
+		little,
+		big,
+	};
+
+	inline wire_order native_order()
+	{
+		const std::uint16_t probe = 1;
+		unsigned char first;
+		std::memcpy(&first, &probe, 1);
+		return first == 1 ? wire_order::little : wire_order::big;
+	}
+
+	struct wire_result
+	{
+		const unsigned char* next;
+		wire_errc ec;
+	};
+}
+
+namespace detail
+{
+namespace wire
+{
+	using unitscxx::column_type;
+	using unitscxx::wire_order;
+
+	constexpr char magic[4] = {'U', 'C', 'X', 'W'};
+	constexpr std::uint8_t version = 1;
+
+	struct header
+	{
+		char magic[4];
+		std::uint8_t version;
+		wire_order order;
+		column_type type;
+		std::uint8_t reserved;
+		std::uint64_t dimension;
+		std::int64_t num;
+		std::int64_t den;
+		std::uint64_t count;
+	};
+
+	static_assert(sizeof(header) == 40, "wire headers are packed");
+
+	// The numbers take up whole 8-byte words, so the next batch is aligned.
+	constexpr size_t padded(size_t bytes)
+	{
+		return (bytes + 7) / 8 * 8;
+	}
+
+	template<typename Quantity>
+	header header_of(size_t count, wire_order order)
+	{
+		using value_type = std::remove_cv_t<Quantity>;
+		using scale = typename value_type::scale;
+		bool swap = order != unitscxx::native_order();
+		header result = {};
+		std::memcpy(result.magic, magic, sizeof magic);
+		result.version = version;
+		result.order = order;
+		result.type = columns::type_code<typename value_type::numeric_type>::value;
+		result.dimension = columns::swap_bytes_if(unitscxx::fingerprint<value_type>, swap);
+		result.num = columns::swap_bytes_if<std::int64_t>(scale::num, swap);
+		result.den = columns::swap_bytes_if<std::int64_t>(scale::den, swap);
+		result.count = columns::swap_bytes_if<std::uint64_t>(count, swap);
+		return result;
+	}
+
+	template<typename NT>
+	void store_numbers(const NT* numbers, size_t count, unsigned char* out, bool swap)
+	{
+		if (!swap)
+		{
+			std::memcpy(out, numbers, count * sizeof(NT));
+			return;
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			NT number = columns::swap_bytes(numbers[i]);
+			std::memcpy(out + i * sizeof(NT), &number, sizeof(NT));
+		}
+	}
+}
+}
+
+namespace unitscxx
+{
+	// Bytes needed to encode count values of Quantity.
+	template<typename Quantity>
+	constexpr size_t wire_size(size_t count)
+	{
+		return sizeof(detail::wire::header)
+			+ detail::wire::padded(count * sizeof(typename std::remove_cv_t<Quantity>::numeric_type));
+	}
+
+	// Encodes values into out[0, capacity) and returns the number of bytes
+	// written, or 0 if they don't fit.
+	template<typename Quantity, size_t E>
+	size_t encode(quantity_span<Quantity, E> values, void* out, size_t capacity,
+		wire_order order = native_order())
+	{
+		size_t size = wire_size<Quantity>(values.size());
+		if (capacity < size)
+		{
+			return 0;
+		}
+		auto header = detail::wire::header_of<Quantity>(values.size(), order);
+		auto bytes = static_cast<unsigned char*>(out);
+		std::memcpy(bytes, &header, sizeof header);
+		size_t numbers = values.size() * sizeof(*values.data());
+		detail::wire::store_numbers(values.data(), values.size(), bytes + sizeof header,
+			order != native_order());
+		std::memset(bytes + sizeof header + numbers, 0, size - sizeof header - numbers);
+		return size;
+	}
+
+	// Appends the encoded values to out.
+	template<typename Quantity, size_t E>
+	void encode(quantity_span<Quantity, E> values, std::vector<unsigned char>& out,
+		wire_order order = native_order())
+	{
+		size_t start = out.size();
+		out.resize(start + wire_size<Quantity>(values.size()));
+		encode(values, out.data() + start, out.size() - start, order);
+	}
+
+	template<typename NT, typename D, typename S>
+	size_t encode(quantity<NT, D, S> value, void* out, size_t capacity, wire_order order = native_order())
+	{
+		NT number = value.raw_value();
+		return encode(quantity_span<const quantity<NT, D, S>>(&number, 1), out, capacity, order);
+	}
+
+	// Decodes the batch at the start of data[0, size) into out, which then
+	// points into data. The dimension is checked here, once; the scale and
+	// numeric type may differ from Quantity's and are converted on access,
+	// as long as an integer Quantity can hold the numbers exactly.
+	template<typename Quantity>
+	wire_result decode(const void* data, size_t size, quantity_column<Quantity>& out)
+	{
+		using namespace detail::wire;
+		using detail::columns::swap_bytes_if;
+		auto bytes = static_cast<const unsigned char*>(data);
+		header batch;
+		if (size < sizeof batch)
+		{
+			return {bytes, size < sizeof magic || std::memcmp(bytes, magic, sizeof magic) == 0
+				? wire_errc::truncated
+				: wire_errc::not_wire_data};
+		}
+		std::memcpy(&batch, bytes, sizeof batch);
+		if (std::memcmp(batch.magic, magic, sizeof magic) != 0)
+		{
+			return {bytes, wire_errc::not_wire_data};
+		}
+		size_t element = detail::columns::size_of(batch.type);
+		if (batch.version != version || element == 0
+			|| (batch.order != wire_order::little && batch.order != wire_order::big))
+		{
+			return {bytes, wire_errc::unsupported};
+		}
+		
+		bool swapped = batch.order != native_order();
+		if (swap_bytes_if(batch.dimension, swapped) != fingerprint<Quantity>)
+		{
+			return {bytes, wire_errc::dimension_mismatch};
+		}
+		std::int64_t num = swap_bytes_if(batch.num, swapped);
+		std::int64_t den = swap_bytes_if(batch.den, swapped);
+		if (num <= 0 || den <= 0)
+		{
+			return {bytes, wire_errc::unsupported};
+		}
+		std::uint64_t count = swap_bytes_if(batch.count, swapped);
+		if (count > (size - sizeof batch) / element
+			|| padded(size_t(count) * element) > size - sizeof batch)
+		{
+			return {bytes, wire_errc::truncated};
+		}
+		quantity_column<Quantity> column;
+		detail::columns::access::assign(column, bytes + sizeof batch, size_t(count), batch.type, 1,
+			num, den, swapped);
+		if (!detail::columns::access::lossless(column))
+		{
+			return {bytes, wire_errc::lossy_scale};
+		}
+		out = column;
+		return {bytes + sizeof batch + padded(size_t(count) * element), wire_errc::ok};
+	}
+
+	template<typename NT, typename D, typename S>
+	wire_result decode(const void* data, size_t size, quantity<NT, D, S>& out)
+	{
+		quantity_column<quantity<NT, D, S>> batch;
+		wire_result result = decode(data, size, batch);
+		if (result.ec == wire_errc::ok && batch.size() != 1)
+		{
+			return {static_cast<const unsigned char*>(data), wire_errc::not_single};
+		}
+		if (result.ec == wire_errc::ok)
+		{
+			out = batch[0];
+		}
+		return result;
+	}
+}
+
+#endif
@@ -0,0 +1,264 @@
+//
+// sharded_quantity.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef SHARDED_QUANTITY_HPP
+#define SHARDED_QUANTITY_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include "units.hpp"
+#include "atomic_quantity.hpp"
+#include "quantity_sum.hpp"
+
+// A total that many threads add to, such as bytes sent or energy spent. Each
+// thread adds to one of several partial sums (shards) that sit on cache lines
+// of their own, so that threads don't fight over one line the way they do
+// with a single atomic_quantity; reading the total combines the shards.
+// Threads are given shards round-robin the first time they add to any
+// sharded_quantity. With Compensated, floating-point shards carry a Neumaier
+// compensation term, at the cost of a short per-shard lock instead of an
+// atomic add; it is lost to -ffast-math.
+
+namespace detail
+{
+namespace sharding
+{
+	// A small number unique to the calling thread, in order of first use.
+	inline unsigned thread_index()
+	{
+		static std::atomic<unsigned> next(0);
+		thread_local unsigned index = next.fetch_add(1, std::memory_order_relaxed);
+		return index;
+	}
+
+	inline size_t default_shard_count()
+	{
+		size_t threads = std::thread::hardware_concurrency();
+		size_t count = 1;
+		while (count < threads)
+		{
+			count *= 2;
+		}
+		return count;
+	}
+
+	// Two cache lines, so that neither neighbors nor the adjacent-line
+	// prefetcher share a shard, whatever the alignment of the array.
+	constexpr size_t shard_size = 128;
+
+	template<typename T, bool Compensated>
+	struct shard
+	{
+		std::atomic<T> sum;
+		char padding[shard_size - sizeof(std::atomic<T>)];
+
+		shard() : sum(T())
+		{
+		}
+
+		void add(T value)
+		{
+			atomics::fetch_add(sum, value, std::memory_order_relaxed);
+		}
+
+		T load() const
+		{
+			return sum.load(std::memory_order_relaxed);
+		}
+
+		void reset()
+		{
+			sum.store(T(), std::memory_order_relaxed);
+		}
+	};
+
+	template<typename T>
+	struct shard<T, true>
+	{
+		mutable std::atomic<bool> busy;
+		T sum;
+		T compensation;
+		char padding[shard_size - sizeof(std::atomic<bool>) - 2 * sizeof(T)];
+
+		shard() : busy(false), sum(), compensation()
+		{
+		}
+
+		void lock() const
+		{
+			while (busy.exchange(true, std::memory_order_acquire))
+			{
+				while (busy.load(std::memory_order_relaxed))
+				{
+				}
+			}
+		}
+
+		void unlock() const
+		{
+			busy.store(false, std::memory_order_release);
+		}
+
+		void add(T value)
+		{
+			lock();
+			accumulation::neumaier_add(sum, compensation, value);
+			unlock();
+		}
+
+		void load(T& total, T& totalCompensation) const
+		{
+			lock();
+			T s = sum;
+			T c = compensation;
+			unlock();
+			accumulation::neumaier_add(total, totalCompensation, s);
+			totalCompensation += c;
+		}
+
+		void reset()
+		{
+			lock();
+			sum = T();
+			compensation = T();
+			unlock();
+		}
+	};
+}
+}
+
+namespace unitscxx
+{
+	template<typename Quantity, bool Compensated = false>
+	class sharded_quantity
+	{
+	public:
+		using value_type = std::remove_cv_t<Quantity>;
+		using numeric_type = typename value_type::numeric_type;
+		using dimension = typename value_type::dimension;
+		using scale = typename value_type::scale;
+
+		static_assert(!Compensated || std::is_floating_point<numeric_type>::value,
+			"compensated summation is for floating-point quantities");
+
+	private:
+		using shard = detail::sharding::shard<numeric_type, Compensated>;
+
+		std::unique_ptr<shard[]> shards;
+		size_t mask;
+
+		shard& local_shard()
+		{
+			return shards[detail::sharding::thread_index() & mask];
+		}
+
+		value_type combine(std::false_type) const
+		{
+			numeric_type total = numeric_type();
+			for (size_t i = 0; i <= mask; ++i)
+			{
+				total += shards[i].load();
+			}
+			return value_type(total);
+		}
+
+		value_type combine(std::true_type) const
+		{
+			numeric_type total = numeric_type();
+			numeric_type compensation = numeric_type();
+			for (size_t i = 0; i <= mask; ++i)
+			{
+				shards[i].load(total, compensation);
+			}
+			return value_type(total + compensation);
+		}
+
+	public:
+		// The shard count is rounded up to a power of two. More shards than
+		// threads avoids sharing; fewer saves memory and makes reads cheaper.
+		explicit sharded_quantity(size_t shardCount = detail::sharding::default_shard_count())
+		{
+			size_t count = 1;
+			while (count < shardCount)
+			{
+				count *= 2;
+			}
+			shards.reset(new shard[count]);
+			mask = count - 1;
+		}
+
+		sharded_quantity(const sharded_quantity&) = delete;
+		sharded_quantity& operator=(const sharded_quantity&) = delete;
+
+		UNITS_ATTR_NODISCARD size_t shard_count() const
+		{
+			return mask + 1;
+		}
+
+		void add(value_type delta)
+		{
+			local_shard().add(delta.raw_value());
+		}
+
+		void subtract(value_type delta)
+		{
+			local_shard().add(static_cast<numeric_type>(-delta.raw_value()));
+		}
+
+		sharded_quantity& operator+=(value_type delta)
+		{
+			add(delta);
+			return *this;
+		}
+
+		sharded_quantity& operator-=(value_type delta)
+		{
+			subtract(delta);
+			return *this;
+		}
+
+		// The sum of the shards. Additions that race with the read may or may
+		// not be counted, but none is counted twice.
+		UNITS_ATTR_NODISCARD value_type load() const
+		{
+			return combine(std::integral_constant<bool, Compensated>{});
+		}
+
+		// Not atomic with respect to concurrent additions.
+		void reset()
+		{
+			for (size_t i = 0; i <= mask; ++i)
+			{
+				shards[i].reset();
+			}
+		}
+	};
+}
+
+#endif
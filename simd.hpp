@@ -0,0 +1,821 @@
+//
+// simd.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(UNITSCXX_NO_SIMD)
+#define UNITSCXX_X86_SIMD 1
+#define UNITSCXX_TARGET(isa) __attribute__((target(isa)))
+#include <immintrin.h>
+#endif
+
+// Element-wise kernels over raw numeric buffers. These know nothing about
+// units: the containers that use them compute result units at compile time and
+// only hand the numeric storage down here.
+
+namespace detail
+{
+namespace simd
+{
+#pragma mark - Operations
+	struct add_op
+	{
+		template<typename A, typename B>
+		static constexpr auto apply(A a, B b) { return a + b; }
+	};
+
+	struct sub_op
+	{
+		template<typename A, typename B>
+		static constexpr auto apply(A a, B b) { return a - b; }
+	};
+
+	struct mul_op
+	{
+		template<typename A, typename B>
+		static constexpr auto apply(A a, B b) { return a * b; }
+	};
+
+	struct div_op
+	{
+		template<typename A, typename B>
+		static constexpr auto apply(A a, B b) { return a / b; }
+	};
+
+	// Like minpd and maxpd: b when either is NaN.
+	struct min_op
+	{
+		template<typename A, typename B>
+		static constexpr auto apply(A a, B b) { return a < b ? a : b; }
+	};
+
+	struct max_op
+	{
+		template<typename A, typename B>
+		static constexpr auto apply(A a, B b) { return a > b ? a : b; }
+	};
+
+#pragma mark - Scalar loop
+	// Operands are either pointers to one value per element, or a single value
+	// that is broadcast to every element.
+	template<typename T>
+	constexpr T* offset(T* values, size_t index)
+	{
+		return values + index;
+	}
+
+	template<typename T, typename = std::enable_if_t<!std::is_pointer<T>::value>>
+	constexpr T offset(T value, size_t)
+	{
+		return value;
+	}
+
+	template<typename T>
+	constexpr std::remove_cv_t<T> element(T* values, size_t index)
+	{
+		return values[index];
+	}
+
+	template<typename T, typename = std::enable_if_t<!std::is_pointer<T>::value>>
+	constexpr T element(T value, size_t)
+	{
+		return value;
+	}
+
+	template<typename Op, typename A, typename B, typename T>
+	void scalar_loop(Op, A a, B b, T* out, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			out[i] = static_cast<T>(Op::apply(element(a, i), element(b, i)));
+		}
+	}
+
+	// GCC contracts a * b + c into a fused multiply-add wherever the target has
+	// one, and target("avx512f") does. The affine kernels pass the product
+	// through here so that every path rounds the same way, unless the whole
+	// build has FMA anyway.
+	template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+	inline void keep_rounding(T&)
+	{
+	}
+
+	template<typename T, typename = std::enable_if_t<!std::is_integral<T>::value>, typename = void>
+	inline void keep_rounding(T& value)
+	{
+#if defined(UNITSCXX_X86_SIMD) && !defined(__FMA__)
+		__asm__("" : "+v"(value));
+#else
+		(void)value;
+#endif
+	}
+
+	// out[i] = in[i] * factor + offset, computed in T and converted to Out.
+	// The addition is left out when HasOffset is false, so that the result is
+	// exactly in[i] * factor (including the sign of zero).
+	template<bool HasOffset, typename T, typename In, typename Out>
+	void scalar_affine_loop(const In* in, Out* out, T factor, T offset, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			T value = static_cast<T>(in[i]) * factor;
+			keep_rounding(value);
+			out[i] = static_cast<Out>(HasOffset ? value + offset : value);
+		}
+	}
+
+	// Sum, minimum and maximum of a buffer, in one pass.
+	template<typename T>
+	struct summary
+	{
+		T sum;
+		T minimum;
+		T maximum;
+	};
+
+	template<typename T>
+	void scalar_summary(const T* values, summary<T>& result, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			result.sum += values[i];
+			result.minimum = min_op::apply(values[i], result.minimum);
+			result.maximum = max_op::apply(values[i], result.maximum);
+		}
+	}
+
+	template<typename T>
+	T scalar_squared_deviations(const T* values, T mean, T sum, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			T deviation = values[i] - mean;
+			sum += deviation * deviation;
+		}
+		return sum;
+	}
+
+	// Folds the lanes of the vector accumulators, then adds the elements that
+	// didn't fill a vector.
+	template<size_t Width, typename T>
+	summary<T> fold_summary(const T* sums, const T* lows, const T* highs,
+		const T* values, size_t begin, size_t end)
+	{
+		summary<T> result{0, lows[0], highs[0]};
+		for (size_t lane = 0; lane < Width; ++lane)
+		{
+			result.sum += sums[lane];
+			result.minimum = min_op::apply(lows[lane], result.minimum);
+			result.maximum = max_op::apply(highs[lane], result.maximum);
+		}
+		scalar_summary(values, result, begin, end);
+		return result;
+	}
+
+	template<size_t Width, typename T>
+	T fold_squared_deviations(const T* sums, const T* values, T mean, size_t begin, size_t end)
+	{
+		T sum = 0;
+		for (size_t lane = 0; lane < Width; ++lane)
+		{
+			sum += sums[lane];
+		}
+		return scalar_squared_deviations(values, mean, sum, begin, end);
+	}
+
+	// The bin of each value among `last + 1` bins of equal width starting at
+	// low: -1 below low, last + 1 at or above high and for NaN. The position
+	// is clamped to the last bin so that rounding just below high stays in it.
+	template<typename T>
+	void scalar_bin_linear(const T* values, std::int32_t* out, T low, T high, T scale, T last,
+		size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			T position = min_op::apply((values[i] - low) * scale, last);
+			position = values[i] < high ? position : last + 1;
+			out[i] = static_cast<std::int32_t>(values[i] < low ? T(-1) : position);
+		}
+	}
+
+	enum class isa
+	{
+		scalar,
+		sse2,
+		avx2,
+		avx512,
+	};
+
+#ifdef UNITSCXX_X86_SIMD
+#pragma mark - SSE2
+	template<typename T>
+	struct sse2;
+
+	template<>
+	struct sse2<double>
+	{
+		using reg = __m128d;
+		static constexpr size_t width = 2;
+		UNITSCXX_TARGET("sse2") static reg load(const double* p) { return _mm_loadu_pd(p); }
+		UNITSCXX_TARGET("sse2") static reg load(double v) { return _mm_set1_pd(v); }
+		UNITSCXX_TARGET("sse2") static void store(double* p, reg v) { _mm_storeu_pd(p, v); }
+		UNITSCXX_TARGET("sse2") static reg load(const float* p) { return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)))); }
+		UNITSCXX_TARGET("sse2") static void store(float* p, reg v) { _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_castps_si128(_mm_cvtpd_ps(v))); }
+		UNITSCXX_TARGET("sse2") static reg apply(add_op, reg a, reg b) { return _mm_add_pd(a, b); }
+		UNITSCXX_TARGET("sse2") static reg apply(sub_op, reg a, reg b) { return _mm_sub_pd(a, b); }
+		UNITSCXX_TARGET("sse2") static reg apply(mul_op, reg a, reg b) { return _mm_mul_pd(a, b); }
+		UNITSCXX_TARGET("sse2") static reg apply(div_op, reg a, reg b) { return _mm_div_pd(a, b); }
+		UNITSCXX_TARGET("sse2") static reg apply(min_op, reg a, reg b) { return _mm_min_pd(a, b); }
+		UNITSCXX_TARGET("sse2") static reg apply(max_op, reg a, reg b) { return _mm_max_pd(a, b); }
+		using mask = reg;
+		UNITSCXX_TARGET("sse2") static mask less(reg a, reg b) { return _mm_cmplt_pd(a, b); }
+		UNITSCXX_TARGET("sse2") static reg select(mask m, reg a, reg b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+		UNITSCXX_TARGET("sse2") static void store_index(std::int32_t* p, reg v) { _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_cvttpd_epi32(v)); }
+	};
+
+	template<>
+	struct sse2<float>
+	{
+		using reg = __m128;
+		static constexpr size_t width = 4;
+		UNITSCXX_TARGET("sse2") static reg load(const float* p) { return _mm_loadu_ps(p); }
+		UNITSCXX_TARGET("sse2") static reg load(float v) { return _mm_set1_ps(v); }
+		UNITSCXX_TARGET("sse2") static void store(float* p, reg v) { _mm_storeu_ps(p, v); }
+		UNITSCXX_TARGET("sse2") static reg apply(add_op, reg a, reg b) { return _mm_add_ps(a, b); }
+		UNITSCXX_TARGET("sse2") static reg apply(sub_op, reg a, reg b) { return _mm_sub_ps(a, b); }
+		UNITSCXX_TARGET("sse2") static reg apply(mul_op, reg a, reg b) { return _mm_mul_ps(a, b); }
+		UNITSCXX_TARGET("sse2") static reg apply(div_op, reg a, reg b) { return _mm_div_ps(a, b); }
+		UNITSCXX_TARGET("sse2") static reg apply(min_op, reg a, reg b) { return _mm_min_ps(a, b); }
+		UNITSCXX_TARGET("sse2") static reg apply(max_op, reg a, reg b) { return _mm_max_ps(a, b); }
+		using mask = reg;
+		UNITSCXX_TARGET("sse2") static mask less(reg a, reg b) { return _mm_cmplt_ps(a, b); }
+		UNITSCXX_TARGET("sse2") static reg select(mask m, reg a, reg b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+		UNITSCXX_TARGET("sse2") static void store_index(std::int32_t* p, reg v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_cvttps_epi32(v)); }
+	};
+
+	template<typename Op, typename A, typename B, typename T>
+	UNITSCXX_TARGET("sse2") void sse2_loop(Op op, A a, B b, T* out, size_t count)
+	{
+		using ops = sse2<T>;
+		size_t i = 0;
+		for (; i + ops::width <= count; i += ops::width)
+		{
+			auto va = ops::load(offset(a, i));
+			auto vb = ops::load(offset(b, i));
+			ops::store(out + i, ops::apply(op, va, vb));
+		}
+		scalar_loop(op, a, b, out, i, count);
+	}
+
+	template<bool HasOffset, typename T, typename In, typename Out>
+	UNITSCXX_TARGET("sse2") void sse2_affine_loop(const In* in, Out* out, T factor, T offset, size_t count)
+	{
+		using ops = sse2<T>;
+		auto vfactor = ops::load(factor);
+		auto voffset = ops::load(offset);
+		size_t i = 0;
+		for (; i + ops::width <= count; i += ops::width)
+		{
+			auto value = ops::apply(mul_op(), ops::load(in + i), vfactor);
+			keep_rounding(value);
+			ops::store(out + i, HasOffset ? ops::apply(add_op(), value, voffset) : value);
+		}
+		scalar_affine_loop<HasOffset>(in, out, factor, offset, i, count);
+	}
+
+	template<typename T>
+	UNITSCXX_TARGET("sse2") summary<T> sse2_summary(const T* values, size_t count)
+	{
+		using ops = sse2<T>;
+		auto sum = ops::load(T(0));
+		auto low = ops::load(values[0]);
+		auto high = low;
+		size_t i = 0;
+		for (; i + ops::width <= count; i += ops::width)
+		{
+			auto value = ops::load(values + i);
+			sum = ops::apply(add_op(), sum, value);
+			low = ops::apply(min_op(), value, low);
+			high = ops::apply(max_op(), value, high);
+		}
+		T sums[ops::width], lows[ops::width], highs[ops::width];
+		ops::store(sums, sum);
+		ops::store(lows, low);
+		ops::store(highs, high);
+		return fold_summary<ops::width>(sums, lows, highs, values, i, count);
+	}
+
+	template<typename T>
+	UNITSCXX_TARGET("sse2") T sse2_squared_deviations(const T* values, size_t count, T mean)
+	{
+		using ops = sse2<T>;
+		auto center = ops::load(mean);
+		auto sum = ops::load(T(0));
+		size_t i = 0;
+		for (; i + ops::width <= count; i += ops::width)
+		{
+			auto deviation = ops::apply(sub_op(), ops::load(values + i), center);
+			sum = ops::apply(add_op(), sum, ops::apply(mul_op(), deviation, deviation));
+		}
+		T sums[ops::width];
+		ops::store(sums, sum);
+		return fold_squared_deviations<ops::width>(sums, values, mean, i, count);
+	}
+
+	template<typename T>
+	UNITSCXX_TARGET("sse2") void sse2_bin_linear(const T* values, std::int32_t* out, T low, T high, T scale,
+		T last, size_t count)
+	{
+		using ops = sse2<T>;
+		auto vlow = ops::load(low);
+		auto vhigh = ops::load(high);
+		auto vscale = ops::load(scale);
+		auto vlast = ops::load(last);
+		auto below = ops::load(T(-1));
+		auto above = ops::load(last + 1);
+		size_t i = 0;
+		for (; i + ops::width <= count; i += ops::width)
+		{
+			auto value = ops::load(values + i);
+			auto position = ops::apply(min_op(), ops::apply(mul_op(), ops::apply(sub_op(), value, vlow), vscale), vlast);
+			position = ops::select(ops::less(value, vhigh), position, above);
+			ops::store_index(out + i, ops::select(ops::less(value, vlow), below, position));
+		}
+		scalar_bin_linear(values, out, low, high, scale, last, i, count);
+	}
+
+#pragma mark - AVX2
+	template<typename T>
+	struct avx2;
+
+	template<>
+	struct avx2<double>
+	{
+		using reg = __m256d;
+		static constexpr size_t width = 4;
+		UNITSCXX_TARGET("avx2") static reg load(const double* p) { return _mm256_loadu_pd(p); }
+		UNITSCXX_TARGET("avx2") static reg load(double v) { return _mm256_set1_pd(v); }
+		UNITSCXX_TARGET("avx2") static void store(double* p, reg v) { _mm256_storeu_pd(p, v); }
+		UNITSCXX_TARGET("avx2") static reg load(const float* p) { return _mm256_cvtps_pd(_mm_loadu_ps(p)); }
+		UNITSCXX_TARGET("avx2") static void store(float* p, reg v) { _mm_storeu_ps(p, _mm256_cvtpd_ps(v)); }
+		UNITSCXX_TARGET("avx2") static reg apply(add_op, reg a, reg b) { return _mm256_add_pd(a, b); }
+		UNITSCXX_TARGET("avx2") static reg apply(sub_op, reg a, reg b) { return _mm256_sub_pd(a, b); }
+		UNITSCXX_TARGET("avx2") static reg apply(mul_op, reg a, reg b) { return _mm256_mul_pd(a, b); }
+		UNITSCXX_TARGET("avx2") static reg apply(div_op, reg a, reg b) { return _mm256_div_pd(a, b); }
+		UNITSCXX_TARGET("avx2") static reg apply(min_op, reg a, reg b) { return _mm256_min_pd(a, b); }
+		UNITSCXX_TARGET("avx2") static reg apply(max_op, reg a, reg b) { return _mm256_max_pd(a, b); }
+		using mask = reg;
+		UNITSCXX_TARGET("avx2") static mask less(reg a, reg b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+		UNITSCXX_TARGET("avx2") static reg select(mask m, reg a, reg b) { return _mm256_blendv_pd(b, a, m); }
+		UNITSCXX_TARGET("avx2") static void store_index(std::int32_t* p, reg v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_cvttpd_epi32(v)); }
+	};
+
+	template<>
+	struct avx2<float>
+	{
+		using reg = __m256;
+		static constexpr size_t width = 8;
+		UNITSCXX_TARGET("avx2") static reg load(const float* p) { return _mm256_loadu_ps(p); }
+		UNITSCXX_TARGET("avx2") static reg load(float v) { return _mm256_set1_ps(v); }
+		UNITSCXX_TARGET("avx2") static void store(float* p, reg v) { _mm256_storeu_ps(p, v); }
+		UNITSCXX_TARGET("avx2") static reg apply(add_op, reg a, reg b) { return _mm256_add_ps(a, b); }
+		UNITSCXX_TARGET("avx2") static reg apply(sub_op, reg a, reg b) { return _mm256_sub_ps(a, b); }
+		UNITSCXX_TARGET("avx2") static reg apply(mul_op, reg a, reg b) { return _mm256_mul_ps(a, b); }
+		UNITSCXX_TARGET("avx2") static reg apply(div_op, reg a, reg b) { return _mm256_div_ps(a, b); }
+		UNITSCXX_TARGET("avx2") static reg apply(min_op, reg a, reg b) { return _mm256_min_ps(a, b); }
+		UNITSCXX_TARGET("avx2") static reg apply(max_op, reg a, reg b) { return _mm256_max_ps(a, b); }
+		using mask = reg;
+		UNITSCXX_TARGET("avx2") static mask less(reg a, reg b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+		UNITSCXX_TARGET("avx2") static reg select(mask m, reg a, reg b) { return _mm256_blendv_ps(b, a, m); }
+		UNITSCXX_TARGET("avx2") static void store_index(std::int32_t* p, reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm256_cvttps_epi32(v)); }
+	};
+
+	template<typename Op, typename A, typename B, typename T>
+	UNITSCXX_TARGET("avx2") void avx2_loop(Op op, A a, B b, T* out, size_t count)
+	{
+		using ops = avx2<T>;
+		size_t i = 0;
+		for (; i + ops::width <= count; i += ops::width)
+		{
+			auto va = ops::load(offset(a, i));
+			auto vb = ops::load(offset(b, i));
+			ops::store(out + i, ops::apply(op, va, vb));
+		}
+		scalar_loop(op, a, b, out, i, count);
+	}
+
+	template<bool HasOffset, typename T, typename In, typename Out>
+	UNITSCXX_TARGET("avx2") void avx2_affine_loop(const In* in, Out* out, T factor, T offset, size_t count)
+	{
+		using ops = avx2<T>;
+		auto vfactor = ops::load(factor);
+		auto voffset = ops::load(offset);
+		size_t i = 0;
+		for (; i + ops::width <= count; i += ops::width)
+		{
+			auto value = ops::apply(mul_op(), ops::load(in + i), vfactor);
+			keep_rounding(value);
+			ops::store(out + i, HasOffset ? ops::apply(add_op(), value, voffset) : value);
+		}
+		scalar_affine_loop<HasOffset>(in, out, factor, offset, i, count);
+	}
+
+	template<typename T>
+	UNITSCXX_TARGET("avx2") summary<T> avx2_summary(const T* values, size_t count)
+	{
+		using ops = avx2<T>;
+		auto sum = ops::load(T(0));
+		auto low = ops::load(values[0]);
+		auto high = low;
+		size_t i = 0;
+		for (; i + ops::width <= count; i += ops::width)
+		{
+			auto value = ops::load(values + i);
+			sum = ops::apply(add_op(), sum, value);
+			low = ops::apply(min_op(), value, low);
+			high = ops::apply(max_op(), value, high);
+		}
+		T sums[ops::width], lows[ops::width], highs[ops::width];
+		ops::store(sums, sum);
+		ops::store(lows, low);
+		ops::store(highs, high);
+		return fold_summary<ops::width>(sums, lows, highs, values, i, count);
+	}
+
+	template<typename T>
+	UNITSCXX_TARGET("avx2") T avx2_squared_deviations(const T* values, size_t count, T mean)
+	{
+		using ops = avx2<T>;
+		auto center = ops::load(mean);
+		auto sum = ops::load(T(0));
+		size_t i = 0;
+		for (; i + ops::width <= count; i += ops::width)
+		{
+			auto deviation = ops::apply(sub_op(), ops::load(values + i), center);
+			sum = ops::apply(add_op(), sum, ops::apply(mul_op(), deviation, deviation));
+		}
+		T sums[ops::width];
+		ops::store(sums, sum);
+		return fold_squared_deviations<ops::width>(sums, values, mean, i, count);
+	}
+
+	template<typename T>
+	UNITSCXX_TARGET("avx2") void avx2_bin_linear(const T* values, std::int32_t* out, T low, T high, T scale,
+		T last, size_t count)
+	{
+		using ops = avx2<T>;
+		auto vlow = ops::load(low);
+		auto vhigh = ops::load(high);
+		auto vscale = ops::load(scale);
+		auto vlast = ops::load(last);
+		auto below = ops::load(T(-1));
+		auto above = ops::load(last + 1);
+		size_t i = 0;
+		for (; i + ops::width <= count; i += ops::width)
+		{
+			auto value = ops::load(values + i);
+			auto position = ops::apply(min_op(), ops::apply(mul_op(), ops::apply(sub_op(), value, vlow), vscale), vlast);
+			position = ops::select(ops::less(value, vhigh), position, above);
+			ops::store_index(out + i, ops::select(ops::less(value, vlow), below, position));
+		}
+		scalar_bin_linear(values, out, low, high, scale, last, i, count);
+	}
+
+#pragma mark - AVX-512
+	template<typename T>
+	struct avx512;
+
+	template<>
+	struct avx512<double>
+	{
+		using reg = __m512d;
+		static constexpr size_t width = 8;
+		UNITSCXX_TARGET("avx512f") static reg load(const double* p) { return _mm512_loadu_pd(p); }
+		UNITSCXX_TARGET("avx512f") static reg load(double v) { return _mm512_set1_pd(v); }
+		UNITSCXX_TARGET("avx512f") static void store(double* p, reg v) { _mm512_storeu_pd(p, v); }
+		UNITSCXX_TARGET("avx512f") static reg load(const float* p) { return _mm512_maskz_cvtps_pd(0xff, _mm256_loadu_ps(p)); }
+		UNITSCXX_TARGET("avx512f") static void store(float* p, reg v) { _mm256_storeu_ps(p, _mm512_maskz_cvtpd_ps(0xff, v)); }
+		UNITSCXX_TARGET("avx512f") static reg apply(add_op, reg a, reg b) { return _mm512_add_pd(a, b); }
+		UNITSCXX_TARGET("avx512f") static reg apply(sub_op, reg a, reg b) { return _mm512_sub_pd(a, b); }
+		UNITSCXX_TARGET("avx512f") static reg apply(mul_op, reg a, reg b) { return _mm512_mul_pd(a, b); }
+		UNITSCXX_TARGET("avx512f") static reg apply(div_op, reg a, reg b) { return _mm512_div_pd(a, b); }
+		UNITSCXX_TARGET("avx512f") static reg apply(min_op, reg a, reg b) { return _mm512_maskz_min_pd(0xff, a, b); }
+		UNITSCXX_TARGET("avx512f") static reg apply(max_op, reg a, reg b) { return _mm512_maskz_max_pd(0xff, a, b); }
+		using mask = __mmask8;
+		UNITSCXX_TARGET("avx512f") static mask less(reg a, reg b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+		UNITSCXX_TARGET("avx512f") static reg select(mask m, reg a, reg b) { return _mm512_mask_blend_pd(m, b, a); }
+		UNITSCXX_TARGET("avx512f") static void store_index(std::int32_t* p, reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm512_maskz_cvttpd_epi32(0xff, v)); }
+	};
+
+	template<>
+	struct avx512<float>
+	{
+		using reg = __m512;
+		static constexpr size_t width = 16;
+		UNITSCXX_TARGET("avx512f") static reg load(const float* p) { return _mm512_loadu_ps(p); }
+		UNITSCXX_TARGET("avx512f") static reg load(float v) { return _mm512_set1_ps(v); }
+		UNITSCXX_TARGET("avx512f") static void store(float* p, reg v) { _mm512_storeu_ps(p, v); }
+		UNITSCXX_TARGET("avx512f") static reg apply(add_op, reg a, reg b) { return _mm512_add_ps(a, b); }
+		UNITSCXX_TARGET("avx512f") static reg apply(sub_op, reg a, reg b) { return _mm512_sub_ps(a, b); }
+		UNITSCXX_TARGET("avx512f") static reg apply(mul_op, reg a, reg b) { return _mm512_mul_ps(a, b); }
+		UNITSCXX_TARGET("avx512f") static reg apply(div_op, reg a, reg b) { return _mm512_div_ps(a, b); }
+		UNITSCXX_TARGET("avx512f") static reg apply(min_op, reg a, reg b) { return _mm512_maskz_min_ps(0xffff, a, b); }
+		UNITSCXX_TARGET("avx512f") static reg apply(max_op, reg a, reg b) { return _mm512_maskz_max_ps(0xffff, a, b); }
+		using mask = __mmask16;
+		UNITSCXX_TARGET("avx512f") static mask less(reg a, reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+		UNITSCXX_TARGET("avx512f") static reg select(mask m, reg a, reg b) { return _mm512_mask_blend_ps(m, b, a); }
+		UNITSCXX_TARGET("avx512f") static void store_index(std::int32_t* p, reg v) { _mm512_storeu_si512(p, _mm512_maskz_cvttps_epi32(0xffff, v)); }
+	};
+
+	template<typename Op, typename A, typename B, typename T>
+	UNITSCXX_TARGET("avx512f") void avx512_loop(Op op, A a, B b, T* out, size_t count)
+	{
+		using ops = avx512<T>;
+		size_t i = 0;
+		for (; i + ops::width <= count; i += ops::width)
+		{
+			auto va = ops::load(offset(a, i));
+			auto vb = ops::load(offset(b, i));
+			ops::store(out + i, ops::apply(op, va, vb));
+		}
+		scalar_loop(op, a, b, out, i, count);
+	}
+
+	template<bool HasOffset, typename T, typename In, typename Out>
+	UNITSCXX_TARGET("avx512f") void avx512_affine_loop(const In* in, Out* out, T factor, T offset, size_t count)
+	{
+		using ops = avx512<T>;
+		auto vfactor = ops::load(factor);
+		auto voffset = ops::load(offset);
+		size_t i = 0;
+		for (; i + ops::width <= count; i += ops::width)
+		{
+			auto value = ops::apply(mul_op(), ops::load(in + i), vfactor);
+			keep_rounding(value);
+			ops::store(out + i, HasOffset ? ops::apply(add_op(), value, voffset) : value);
+		}
+		scalar_affine_loop<HasOffset>(in, out, factor, offset, i, count);
+	}
+
+	template<typename T>
+	UNITSCXX_TARGET("avx512f") summary<T> avx512_summary(const T* values, size_t count)
+	{
+		using ops = avx512<T>;
+		auto sum = ops::load(T(0));
+		auto low = ops::load(values[0]);
+		auto high = low;
+		size_t i = 0;
+		for (; i + ops::width <= count; i += ops::width)
+		{
+			auto value = ops::load(values + i);
+			sum = ops::apply(add_op(), sum, value);
+			low = ops::apply(min_op(), value, low);
+			high = ops::apply(max_op(), value, high);
+		}
+		T sums[ops::width], lows[ops::width], highs[ops::width];
+		ops::store(sums, sum);
+		ops::store(lows, low);
+		ops::store(highs, high);
+		return fold_summary<ops::width>(sums, lows, highs, values, i, count);
+	}
+
+	template<typename T>
+	UNITSCXX_TARGET("avx512f") T avx512_squared_deviations(const T* values, size_t count, T mean)
+	{
+		using ops = avx512<T>;
+		auto center = ops::load(mean);
+		auto sum = ops::load(T(0));
+		size_t i = 0;
+		for (; i + ops::width <= count; i += ops::width)
+		{
+			auto deviation = ops::apply(sub_op(), ops::load(values + i), center);
+			sum = ops::apply(add_op(), sum, ops::apply(mul_op(), deviation, deviation));
+		}
+		T sums[ops::width];
+		ops::store(sums, sum);
+		return fold_squared_deviations<ops::width>(sums, values, mean, i, count);
+	}
+
+	template<typename T>
+	UNITSCXX_TARGET("avx512f") void avx512_bin_linear(const T* values, std::int32_t* out, T low, T high, T scale,
+		T last, size_t count)
+	{
+		using ops = avx512<T>;
+		auto vlow = ops::load(low);
+		auto vhigh = ops::load(high);
+		auto vscale = ops::load(scale);
+		auto vlast = ops::load(last);
+		auto below = ops::load(T(-1));
+		auto above = ops::load(last + 1);
+		size_t i = 0;
+		for (; i + ops::width <= count; i += ops::width)
+		{
+			auto value = ops::load(values + i);
+			auto position = ops::apply(min_op(), ops::apply(mul_op(), ops::apply(sub_op(), value, vlow), vscale), vlast);
+			position = ops::select(ops::less(value, vhigh), position, above);
+			ops::store_index(out + i, ops::select(ops::less(value, vlow), below, position));
+		}
+		scalar_bin_linear(values, out, low, high, scale, last, i, count);
+	}
+
+#pragma mark - Runtime dispatch
+	inline isa detect_isa()
+	{
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f"))
+		{
+			return isa::avx512;
+		}
+		if (__builtin_cpu_supports("avx2"))
+		{
+			return isa::avx2;
+		}
+		return isa::sse2;
+	}
+
+	// The widest instruction set that the running processor supports; checked
+	// once per process.
+	inline isa active_isa()
+	{
+		static const isa best = detect_isa();
+		return best;
+	}
+
+	template<typename Op, typename A, typename B, typename T>
+	void dispatch(Op op, A a, B b, T* out, size_t count, std::true_type)
+	{
+		switch (active_isa())
+		{
+			case isa::avx512: return avx512_loop(op, a, b, out, count);
+			case isa::avx2: return avx2_loop(op, a, b, out, count);
+			default: return sse2_loop(op, a, b, out, count);
+		}
+	}
+
+	template<bool HasOffset, typename T, typename In, typename Out>
+	void dispatch_affine(const In* in, Out* out, T factor, T offset, size_t count, std::true_type)
+	{
+		switch (active_isa())
+		{
+			case isa::avx512: return avx512_affine_loop<HasOffset>(in, out, factor, offset, count);
+			case isa::avx2: return avx2_affine_loop<HasOffset>(in, out, factor, offset, count);
+			default: return sse2_affine_loop<HasOffset>(in, out, factor, offset, count);
+		}
+	}
+
+	template<typename T>
+	summary<T> dispatch_summary(const T* values, size_t count, std::true_type)
+	{
+		switch (active_isa())
+		{
+			case isa::avx512: return avx512_summary(values, count);
+			case isa::avx2: return avx2_summary(values, count);
+			default: return sse2_summary(values, count);
+		}
+	}
+
+	template<typename T>
+	T dispatch_squared_deviations(const T* values, size_t count, T mean, std::true_type)
+	{
+		switch (active_isa())
+		{
+			case isa::avx512: return avx512_squared_deviations(values, count, mean);
+			case isa::avx2: return avx2_squared_deviations(values, count, mean);
+			default: return sse2_squared_deviations(values, count, mean);
+		}
+	}
+
+	template<typename T>
+	void dispatch_bin_linear(const T* values, std::int32_t* out, T low, T high, T scale, T last,
+		size_t count, std::true_type)
+	{
+		switch (active_isa())
+		{
+			case isa::avx512: return avx512_bin_linear(values, out, low, high, scale, last, count);
+			case isa::avx2: return avx2_bin_linear(values, out, low, high, scale, last, count);
+			default: return sse2_bin_linear(values, out, low, high, scale, last, count);
+		}
+	}
+#else
+	inline isa active_isa()
+	{
+		return isa::scalar;
+	}
+#endif
+
+	template<typename Op, typename A, typename B, typename T>
+	void dispatch(Op op, A a, B b, T* out, size_t count, std::false_type)
+	{
+		scalar_loop(op, a, b, out, 0, count);
+	}
+
+	template<bool HasOffset, typename T, typename In, typename Out>
+	void dispatch_affine(const In* in, Out* out, T factor, T offset, size_t count, std::false_type)
+	{
+		scalar_affine_loop<HasOffset>(in, out, factor, offset, 0, count);
+	}
+
+	template<typename T>
+	summary<T> dispatch_summary(const T* values, size_t count, std::false_type)
+	{
+		summary<T> result{0, values[0], values[0]};
+		scalar_summary(values, result, 0, count);
+		return result;
+	}
+
+	template<typename T>
+	T dispatch_squared_deviations(const T* values, size_t count, T mean, std::false_type)
+	{
+		return scalar_squared_deviations(values, mean, T(0), 0, count);
+	}
+
+	template<typename T>
+	void dispatch_bin_linear(const T* values, std::int32_t* out, T low, T high, T scale, T last,
+		size_t count, std::false_type)
+	{
+		scalar_bin_linear(values, out, low, high, scale, last, 0, count);
+	}
+
+	template<typename T>
+	using is_vectorized = std::integral_constant<bool,
+#ifdef UNITSCXX_X86_SIMD
+		std::is_same<T, float>::value || std::is_same<T, double>::value
+#else
+		false
+#endif
+	>;
+
+#pragma mark - Entry point
+	// out[i] = Op::apply(a[i], b[i]) for i in [0, count). Either operand can be
+	// a single value instead of a pointer. out may alias a or b.
+	template<typename Op, typename A, typename B, typename T>
+	void apply(Op op, A a, B b, T* out, size_t count)
+	{
+		dispatch(op, a, b, out, count, is_vectorized<T>{});
+	}
+
+	// out[i] = in[i] * factor (+ offset) for i in [0, count), computed in the
+	// wider of In and Out. out may be in itself, but not otherwise overlap it.
+	template<bool HasOffset, typename T, typename In, typename Out>
+	void affine(const In* in, Out* out, T factor, T offset, size_t count)
+	{
+		dispatch_affine<HasOffset>(in, out, factor, offset, count, std::integral_constant<bool,
+			is_vectorized<T>::value && is_vectorized<In>::value && is_vectorized<Out>::value>{});
+	}
+
+	// The sum, minimum and maximum of values[0, count), for count > 0. NaNs
+	// are skipped by the minimum and maximum unless they come first. The sum
+	// is accumulated in as many lanes as the instruction set has, so its
+	// last bits depend on the processor.
+	template<typename T>
+	summary<T> summarize(const T* values, size_t count)
+	{
+		return dispatch_summary(values, count, is_vectorized<T>{});
+	}
+
+	// The sum of (values[i] - mean)^2, accumulated the same way.
+	template<typename T>
+	T squared_deviations(const T* values, size_t count, T mean)
+	{
+		return dispatch_squared_deviations(values, count, mean, is_vectorized<T>{});
+	}
+
+	// out[i] = the bin of values[i] among `bins` bins of width 1 / scale from
+	// low to high, or -1 below and `bins` above; see scalar_bin_linear.
+	template<typename T>
+	void bin_linear(const T* values, std::int32_t* out, T low, T high, T scale, size_t bins, size_t count)
+	{
+		dispatch_bin_linear(values, out, low, high, scale, T(bins - 1), count, is_vectorized<T>{});
+	}
+}
+}
+
+#endif
@@ -30,6 +30,7 @@
 #include <cmath>
 #include <ratio>
 #include "units.hpp"
+#include "quantity_point.hpp"
 
 #ifndef UNITSCXX_SI_ARITHMETIC_TYPE
 #define UNITSCXX_SI_ARITHMETIC_TYPE double
@@ -99,6 +100,11 @@ namespace si
 		return (kelvinTemperature - Czero) / K;
 	}
 	
+	// Absolute temperatures as typed points; differences are plain kelvins.
+	using kelvin_point = quantity_point<std::remove_const_t<decltype(K)>>;
+	using celsius_point = quantity_point<std::remove_const_t<decltype(K)>,
+		std::ratio<27315, 100>>;
+	
 #pragma mark - Commonly-accepted non-standard units
 	namespace detail
 	{
@@ -24,6 +24,35 @@
 //
 
 #include "units.hpp"
+#include "quantity_array.hpp"
+#include "quantity_span.hpp"
+#include "quantity_math.hpp"
+#include "quantity_sum.hpp"
+#include "quantity_stats.hpp"
+#include "quantity_histogram.hpp"
+#include "quantity_convert.hpp"
+#include "atomic_quantity.hpp"
+#include "sharded_quantity.hpp"
+#include "quantity_parallel.hpp"
+#include "dyn_quantity.hpp"
+#include "unit_registry.hpp"
+#include "quantity_parse.hpp"
+#include "quantity_format.hpp"
+#include "quantity_column.hpp"
+#include "quantity_wire.hpp"
+
+// The Eigen and BLAS bindings are opt-in; they're checked where the
+// libraries are installed (Eigen needs -I/usr/include/eigen3 or similar).
+#if defined(__has_include)
+#if __has_include(<Eigen/Core>)
+#include "quantity_eigen.hpp"
+#define UNITSCXX_TEST_EIGEN 1
+#endif
+#if __has_include(<cblas.h>)
+#include "quantity_blas.hpp"
+#define UNITSCXX_TEST_BLAS 1
+#endif
+#endif
 
 using namespace std;
 using namespace detail;
@@ -94,3 +123,567 @@ void static_sequence_tests()
 	static_assert(seq_get<2>(seq5) == 4, "sorted/seq_get");
 	static_assert(seq_get<3>(seq5) == 6, "sorted/seq_get");
 }
+
+void static_dimension_tests()
+{
+	enum units { a, b, c };
+	using A = sequence_dimension<sequence<units, a>>;
+	using B = sequence_dimension<sequence<units, b>>;
+	using C = sequence_dimension<sequence<units, c>>;
+	static_assert(is_same<A, dimension<units, 1>>::value,
+		"sequence_dimension");
+	static_assert(is_same<C, dimension<units, 0, 0, 1>>::value,
+		"sequence_dimension");
+	static_assert(is_same<sequence_dimension<sequence<units, c, a, c>>,
+		dimension<units, 1, 0, 2>>::value, "sequence_dimension");
+	
+	using AC = dimension_product<A, C>;
+	using CA = dimension_product<C, A>;
+	static_assert(is_same<AC, CA>::value, "dimension_product");
+	static_assert(is_same<dimension_quotient<AC, C>, A>::value,
+		"dimension_quotient");
+	static_assert(is_same<dimension_quotient<C, C>, dimension<units>>::value,
+		"dimension_quotient/trim");
+	static_assert(is_same<dimension_inverse<B>, dimension<units, 0, -1>>::value,
+		"dimension_inverse");
+	
+	using ABoverCC = dimension_quotient<dimension_product<A, B>,
+		dimension_product<C, C>>;
+	using num = numerator_factors<ABoverCC>;
+	using den = denominator_factors<ABoverCC>;
+	static_assert(num::size == 2 && den::size == 2, "factors/size");
+	static_assert(seq_get<0>(num{}) == a && seq_get<1>(num{}) == b,
+		"numerator_factors");
+	static_assert(seq_get<0>(den{}) == c && seq_get<1>(den{}) == c,
+		"denominator_factors");
+	
+	using q = unitscxx::unit_base<double, units, c, a, c>;
+	static_assert(is_same<q::dimension, dimension<units, 1, 0, 2>>::value,
+		"unit_base");
+	static_assert(is_same<q::numerator, sequence<units, a, c, c>>::value,
+		"quantity::numerator");
+	static_assert(q::denominator::size == 0, "quantity::denominator");
+}
+
+void static_sequence_quantity_tests()
+{
+	enum units { length, time };
+	using m = unitscxx::unit_base<double, units, length>;
+	using speed = decltype(m() / unitscxx::unit_base<double, units, time>());
+	static_assert(is_same<unitscxx::sequence_quantity<double, sequence<units, length>, sequence<units, time>>,
+		speed>::value && is_same<unitscxx::sequence_quantity<double, sequence<units, length, length>,
+		sequence<units, length>>, m>::value, "sequence_quantity names the old form");
+}
+
+void static_scale_tests()
+{
+	enum units { length };
+	using L = dimension<units, 1>;
+	using mm = unitscxx::quantity<long long, L, std::milli>;
+	using m = unitscxx::quantity<long long, L>;
+	using km = unitscxx::quantity<long long, L, std::kilo>;
+	
+	static_assert(is_same<common_scale<std::kilo, std::milli>, std::milli>::value,
+		"common_scale");
+	static_assert(is_same<common_scale<std::ratio<1, 3>, std::ratio<1, 2>>,
+		std::ratio<1, 6>>::value, "common_scale/coprime");
+	static_assert(std::is_convertible<km, mm>::value
+		&& !std::is_convertible<mm, m>::value, "lossless conversions are implicit");
+	
+	constexpr auto sum = km(2) + mm(3);
+	static_assert(is_same<decltype(sum), const mm>::value
+		&& sum.raw_value() == 2000003, "exact integer sum");
+	static_assert(m(mm(4999)).raw_value() == 4, "explicit truncation");
+	static_assert(mm(1) < m(1) && km(1) == mm(1000000), "cross-scale comparison");
+	
+	constexpr auto area = km(3) * mm(2);
+	static_assert(area.raw_value() == 6
+		&& is_same<decltype(area)::scale, std::ratio<1>>::value, "scales multiply");
+	
+	using unitscxx::si::kg;
+	using unitscxx::si::t;
+	constexpr auto kg6 = kg * kg * kg * kg * kg * kg;
+	constexpr auto kg7 = kg6 * kg;
+	static_assert(is_same<decltype(kg6)::scale, std::exa>::value && kg6.raw_value() == 1,
+		"scales multiply up to the range of std::ratio");
+	static_assert(is_same<decltype(kg7)::scale, std::ratio<1>>::value && kg7.raw_value() == 1e21
+		&& kg7 / kg6 == kg && kg7 / kg == kg6,
+		"scales past the range of std::ratio fold into the value");
+	static_assert((t * t * t * t).raw_value() == 1e24 && unitscxx::pow<4>(t).raw_value() == 1e24
+		&& t * t * t * t / (t * t) == t * t && (1 / (t * t * t * t)).raw_value() < 1.000001e-24,
+		"deep products of tonnes");
+}
+
+void static_quantity_math_tests()
+{
+	enum units { length, time };
+	using L = dimension<units, 1>;
+	using m = unitscxx::quantity<double, L>;
+	using mm = unitscxx::quantity<double, L, std::milli>;
+	using area = decltype(m() * m());
+	
+	static_assert(is_same<dimension_power<L, 1, 2>, rational_dimension<units, 2, 1>>::value,
+		"dimension_power/root");
+	static_assert(is_same<dimension_product<dimension_power<L, 1, 2>, dimension_power<L, 1, 2>>, L>::value,
+		"rational exponents reduce");
+	static_assert(is_same<dimension_power<dimension<units, 2, -4>, 1, 2>, dimension<units, 1, -2>>::value
+		&& is_same<dimension_power<L, 0>, dimension<units>>::value, "dimension_power/normalized");
+	static_assert(is_same<rational_dimension<units, 3, 2>::value_type, units>::value
+		&& is_same<numerator_factors<rational_dimension<units, 3, 2>>, void>::value,
+		"fractional exponents have no factor sequence");
+	
+	static_assert(is_same<decltype(unitscxx::sqrt(area())), m>::value, "sqrt/dimension");
+	static_assert(is_same<decltype(unitscxx::sqrt(mm() * mm()))::scale, std::milli>::value,
+		"sqrt/exact scale root");
+	static_assert(is_same<decltype(unitscxx::pow<std::ratio<3, 2>>(area())),
+		decltype(m() * m() * m())>::value, "pow/rational");
+	
+	constexpr auto cube = unitscxx::pow<3>(mm(2));
+	static_assert(cube.raw_value() == 8 && is_same<decltype(cube)::scale, std::nano>::value,
+		"pow/integer");
+	static_assert(unitscxx::max(m(1), mm(2)) == m(1)
+		&& is_same<decltype(unitscxx::min(m(1), mm(2))), mm>::value, "min/max at the common scale");
+}
+
+void static_quantity_sum_tests()
+{
+	using namespace unitscxx;
+	using J = std::remove_const_t<decltype(si::J)>;
+	using kJ = quantity<double, J::dimension, std::ratio_multiply<J::scale, std::kilo>>;
+	
+	static_assert(is_same<decltype(quantity_sum<J>().value()), J>::value
+		&& is_same<decltype(quantity_sum<J, summation::pairwise>() + quantity_sum<J, summation::pairwise>()),
+			quantity_sum<J, summation::pairwise>>::value,
+		"quantity_sum keeps the dimension and merges");
+	static_assert(is_convertible<kJ, quantity_sum<J, summation::kahan_lanes<4>>::value_type>::value
+		&& !is_convertible<decltype(si::N), quantity_sum<J>::value_type>::value,
+		"quantity_sum/same dimension only");
+}
+
+void static_quantity_stats_tests()
+{
+	using namespace unitscxx;
+	using s = std::remove_const_t<decltype(si::s)>;
+	using ms = quantity<double, s::dimension, std::milli>;
+	using s2 = decltype(si::s * si::s);
+	
+	static_assert(is_same<decltype(quantity_stats<ms>().mean()), ms>::value
+		&& is_same<decltype(quantity_stats<ms>().stddev()), ms>::value
+		&& is_same<decltype(quantity_stats<ms>().variance())::dimension, s2::dimension>::value
+		&& is_same<decltype(quantity_stats<ms>().variance())::scale, std::micro>::value,
+		"variance is in squared units");
+	using Tm = std::remove_const_t<decltype(std::tera() * si::m)>;
+	using Tm2 = decltype(Tm() * Tm());
+	static_assert(is_same<decltype(quantity_stats<Tm>().variance()), Tm2>::value,
+		"variance/squared scales past the range of std::ratio");
+	static_assert(is_same<decltype(quantity_digest<s>().quantile(0.99)), s>::value
+		&& is_same<decltype(quantity_stats<s>() + quantity_stats<s>()), quantity_stats<s>>::value
+		&& is_same<decltype(quantity_digest<s>() + quantity_digest<s>()), quantity_digest<s>>::value,
+		"quantiles are typed and sketches merge");
+}
+
+template<typename Histogram, typename Value, typename = void>
+struct accepts_fill : false_type
+{
+};
+
+template<typename Histogram, typename Value>
+struct accepts_fill<Histogram, Value,
+	decltype((void)declval<Histogram&>().fill(declval<Value>()))> : true_type
+{
+};
+
+void static_quantity_histogram_tests()
+{
+	using namespace unitscxx;
+	using m = std::remove_const_t<decltype(si::m)>;
+	using mm = quantity<double, m::dimension, std::milli>;
+	using histogram = quantity_histogram<m>;
+	
+	static_assert(accepts_fill<histogram, m>::value && accepts_fill<histogram, mm>::value
+		&& accepts_fill<histogram, quantity_span<const m>>::value
+		&& !accepts_fill<histogram, decltype(si::s)>::value && !accepts_fill<histogram, double>::value,
+		"quantity_histogram/values have the dimension of the edges");
+	static_assert(is_same<decltype(histogram::logarithmic(mm(1), m(1), 30)), histogram>::value
+		&& is_same<decltype(declval<histogram&>().edge(0)), m>::value,
+		"quantity_histogram");
+}
+
+void static_quantity_point_tests()
+{
+	using namespace unitscxx;
+	using K = std::remove_const_t<decltype(si::K)>;
+	
+	constexpr si::celsius_point freezing{};
+	constexpr si::kelvin_point absolute = freezing;
+	constexpr us::fahrenheit_point fahrenheit = freezing;
+	static_assert(absolute.raw_value() == 273.15 && fahrenheit.raw_value() == 32,
+		"points at another origin");
+	static_assert(is_same<decltype(freezing - absolute), K>::value
+		&& is_same<decltype(freezing + K(1)), si::celsius_point>::value,
+		"point - point, point + quantity");
+	constexpr quantity_point<quantity<int, K::dimension>> two_kelvins{quantity<int, K::dimension>(2)};
+	static_assert((two_kelvins - quantity_point<K>(K(0.5))).raw_value() == 1.5,
+		"point - point/common numeric type");
+	static_assert(!std::is_convertible<quantity_point<quantity<int, K::dimension>, std::ratio<27315, 100>>,
+		quantity_point<quantity<int, K::dimension>>>::value, "lossy origin shifts are explicit");
+}
+
+template<typename Atomic, typename Delta, typename = void>
+struct accepts_delta : false_type
+{
+};
+
+template<typename Atomic, typename Delta>
+struct accepts_delta<Atomic, Delta,
+	decltype((void)declval<Atomic&>().fetch_add(declval<Delta>()))> : true_type
+{
+};
+
+void static_atomic_quantity_tests()
+{
+	using namespace unitscxx;
+	enum units { byte };
+	using J = std::remove_const_t<decltype(si::J)>;
+	using kJ = quantity<double, J::dimension, std::ratio_multiply<J::scale, std::kilo>>;
+	using bytes = unit_base<uint64_t, units, byte>;
+	
+	static_assert(accepts_delta<atomic_quantity<J>, J>::value
+		&& accepts_delta<atomic_quantity<J>, kJ>::value
+		&& !accepts_delta<atomic_quantity<J>, decltype(si::N)>::value
+		&& !accepts_delta<atomic_quantity<J>, double>::value,
+		"atomic_quantity/fetch_add takes the same dimension");
+	static_assert(is_same<decltype(declval<atomic_quantity<bytes>&>().fetch_sub(bytes())), bytes>::value
+		&& !is_copy_constructible<atomic_quantity<J>>::value,
+		"atomic_quantity");
+	static_assert(is_same<decltype(sharded_quantity<J, true>().load()), J>::value
+		&& is_convertible<kJ, sharded_quantity<J>::value_type>::value
+		&& !is_copy_constructible<sharded_quantity<bytes>>::value,
+		"sharded_quantity");
+}
+
+void static_quantity_parallel_tests()
+{
+	using namespace unitscxx;
+	using meters = std::remove_const_t<decltype(si::m)>;
+	using lengths = quantity_array<meters>;
+	
+	static_assert(is_same<decltype(parallel::transform_reduce(parallel::par, lengths(), lengths())),
+		decltype(si::m * si::m)>::value, "parallel::transform_reduce/units of the product");
+	static_assert(is_same<decltype(parallel::reduce(parallel::par_deterministic, lengths())),
+		meters>::value, "parallel::reduce");
+}
+
+void static_quantity_convert_tests()
+{
+	using namespace unitscxx;
+	using K = std::remove_const_t<decltype(si::K)>;
+	using mK = quantity<float, K::dimension, std::milli>;
+	using int_K = quantity<int, K::dimension>;
+	using int_mK = quantity<long, K::dimension, std::milli>;
+	
+	static_assert(us::fahrenheit.zero == us::F2K(0) && si::celsius.zero == si::C2K(0),
+		"temperature scales");
+	static_assert(is_same<decltype(convert(quantity_span<const K>(), quantity_span<mK>())), void>::value
+		&& is_same<decltype(convert(quantity_span<const int_K>(), quantity_span<int_mK>())), void>::value
+		&& is_same<decltype(convert((const float*)nullptr, us::fahrenheit, quantity_span<K>())), void>::value,
+		"convert/overloads");
+}
+
+void static_quantity_array_tests()
+{
+	enum units { a, b };
+	using A = unitscxx::unit_base<double, units, a>;
+	using B = unitscxx::unit_base<double, units, b>;
+	using unitscxx::quantity_array;
+	
+	using AoverB = decltype(quantity_array<A>() / quantity_array<B>());
+	static_assert(is_same<AoverB::value_type, decltype(A() / B())>::value,
+		"quantity_array/operator/");
+	static_assert(AoverB::extent == unitscxx::dynamic_extent,
+		"quantity_array/extent");
+	
+	using AA = decltype(quantity_array<A, 3>() * quantity_array<A>());
+	static_assert(is_same<AA::value_type, decltype(A() * A())>::value,
+		"quantity_array/operator*");
+	static_assert(AA::extent == 3, "quantity_array/extent");
+	
+	using invB = decltype(2.0 / quantity_array<B>());
+	static_assert(is_same<invB::value_type, decltype(1 / B())>::value,
+		"quantity_array/scalar operator/");
+	using milliA = decltype(quantity_array<A>() * std::milli())::value_type;
+	static_assert(is_same<milliA::dimension, A::dimension>::value
+		&& is_same<milliA::scale, std::milli>::value,
+		"quantity_array/ratio operator*");
+	
+	using t2 = std::remove_const_t<decltype(unitscxx::si::t * unitscxx::si::t)>;
+	using t4 = decltype(quantity_array<t2>() * quantity_array<t2>());
+	static_assert(is_same<t4::value_type, decltype(t2() * t2())>::value
+		&& t4::fold::fold(4.0) == (t2(2) * t2(2)).raw_value(),
+		"quantity_array/scales past the range of std::ratio fold into the values");
+	
+	using buffer = unitscxx::quantity_buffer<A>;
+	static_assert(is_constructible<A, unitscxx::for_overwrite_t>::value
+		&& !is_convertible<unitscxx::for_overwrite_t, A>::value
+		&& is_constructible<quantity_array<A>, size_t, unitscxx::for_overwrite_t>::value,
+		"for_overwrite");
+	static_assert(is_same<buffer::value_type, A>::value
+		&& is_same<std::allocator_traits<buffer::allocator_type>::rebind_alloc<double>,
+			unitscxx::default_init_allocator<double>>::value,
+		"quantity_buffer");
+}
+
+void static_quantity_span_tests()
+{
+	enum units { a };
+	using A = unitscxx::unit_base<double, units, a>;
+	static_assert(unitscxx::has_numeric_layout<A>::value, "has_numeric_layout");
+	static_assert(unitscxx::has_numeric_layout<
+		unitscxx::unit_base<float, units, a, a>>::value, "has_numeric_layout");
+	
+	using span = unitscxx::quantity_span<A>;
+	using const_span = unitscxx::quantity_span<const A>;
+	static_assert(is_same<span::numeric_type*, double*>::value,
+		"quantity_span/data");
+	static_assert(is_same<const_span::numeric_type*, const double*>::value,
+		"quantity_span/const data");
+	static_assert(is_convertible<span, const_span>::value,
+		"quantity_span/const conversion");
+	static_assert(!is_convertible<const_span, span>::value,
+		"quantity_span/const conversion");
+}
+
+void static_dyn_quantity_tests()
+{
+	using namespace unitscxx;
+	using dim = dyn_dimension<si::units>;
+	constexpr dim m = dim::of<decltype(si::m)::dimension>();
+	constexpr dim s = dim::of<decltype(si::s)::dimension>();
+	constexpr dim N = dim::of<decltype(si::N)::dimension>();
+	static_assert(m * m / s / s * dim::of<decltype(si::kg)::dimension>() / m == N,
+		"dyn_dimension/product and quotient");
+	static_assert((dim() / s).exponent(si::second) == -1, "dyn_dimension/exponent");
+	static_assert(!m.common(s).valid() && !(m.common(s) * s).valid(),
+		"dyn_dimension/invalid propagates");
+	
+	constexpr dyn_quantity<double, si::units> work = 2.0 * si::N * (3.0 * si::m);
+	static_assert(work.is<decltype(si::J)>() && work.raw_value() == 6000,
+		"dyn_quantity/base units");
+}
+
+// Same fingerprint exactly when same dimension, for Q against each of All.
+template<typename Q, typename... All>
+constexpr bool fingerprint_matches_dimension()
+{
+	using namespace unitscxx;
+	bool same_dimension[] = {is_same<typename remove_cv_t<Q>::dimension,
+		typename remove_cv_t<All>::dimension>::value...};
+	uint64_t prints[] = {fingerprint<All>...};
+	for (size_t i = 0; i < sizeof...(All); ++i)
+	{
+		if ((prints[i] == fingerprint<Q>) != same_dimension[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+template<typename... All>
+constexpr bool no_fingerprint_collisions()
+{
+	bool results[] = {fingerprint_matches_dimension<All, All...>()...};
+	for (bool result : results)
+	{
+		if (!result)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void static_fingerprint_tests()
+{
+	using namespace unitscxx;
+	using namespace si;
+	using namespace us;
+	using root_Hz = quantity<double, dimension_power<decltype(Hz)::dimension, 1, 2>>;
+	using cbrt_m = quantity<double, dimension_power<decltype(si::m)::dimension, 1, 3>>;
+	// Every unit quantity in siunits.hpp and usunits.hpp (deg is a plain
+	// number), plus a few dimensions none of them has.
+	static_assert(no_fingerprint_collisions<
+		decltype(si::m), decltype(g), decltype(s), decltype(A), decltype(K), decltype(mol), decltype(cd),
+		decltype(kg), decltype(Hz), decltype(N), decltype(Pa), decltype(J), decltype(W), decltype(si::C),
+		decltype(V), decltype(F), decltype(Ohm), decltype(S), decltype(Wb), decltype(si::T), decltype(H),
+		decltype(lx), decltype(Gy), decltype(kat), decltype(Czero), decltype(unitscxx::si::detail::dm),
+		decltype(unitscxx::si::detail::hm), decltype(ha), decltype(L), decltype(si::t), decltype(au),
+		decltype(ft), decltype(in), decltype(pica), decltype(us::p), decltype(yd), decltype(li),
+		decltype(rd), decltype(ch), decltype(fur), decltype(mi), decltype(lea), decltype(ftm), decltype(cb),
+		decltype(nmi), decltype(acre), decltype(section), decltype(twp),
+		decltype(us::min), decltype(tsp), decltype(Tbsp), decltype(jig), decltype(fl::oz), decltype(gi),
+		decltype(cp), decltype(fl::pt), decltype(fl::qt), decltype(fl::gal), decltype(hogshead),
+		decltype(fl::bbl), decltype(oilbbl), decltype(dry::pt), decltype(dry::qt), decltype(dry::gal),
+		decltype(pk), decltype(bu), decltype(dry::bbl),
+		decltype(lb), decltype(us::oz), decltype(dr), decltype(gr), decltype(cwt), decltype(ton),
+		decltype(dwt), decltype(ozt), decltype(lbt), fahrenheit_degrees, decltype(si::m / si::m),
+		root_Hz, cbrt_m, decltype(1 / (s * s))>(),
+		"fingerprint/no collisions between different dimensions");
+	
+	static_assert(fingerprint<decltype(N)> == 0xfe0101 && fingerprint<decltype(si::m / si::m)> == 0
+		&& fingerprint<root_Hz> == 0x0100000000ff0000,
+		"fingerprint/stable layout");
+	static_assert(fingerprint<decltype(kg * si::m / (s * s))> == fingerprint<decltype(si::m / s * kg / s)>,
+		"fingerprint/independent of the order of factors");
+	static_assert(fingerprint<decltype(Pa)> == dyn_dimension<units>::of<decltype(Pa)::dimension>().packed(),
+		"fingerprint/same word as dyn_dimension");
+	
+	constexpr auto root = decode_fingerprint(fingerprint<root_Hz>);
+	static_assert(root.valid && root.denominator == 2 && root.numerators[second] == -1,
+		"decode_fingerprint");
+	static_assert(!decode_fingerprint(0x0100000000000002).valid && !decode_fingerprint(1ull << 63).valid,
+		"decode_fingerprint/not a dimension");
+}
+
+constexpr bool same_text(const char* a, const char* b)
+{
+	for (; *a != 0 && *a == *b; ++a, ++b)
+	{
+	}
+	return *a == *b;
+}
+
+void static_unit_registry_tests()
+{
+	using namespace unitscxx;
+	static_assert(registry::table.complete, "perfect hash");
+	static_assert(same_text(find_unit("Pa", 2).unit->symbol, "Pa")
+		&& find_unit("Pa", 2).decimal == 0, "find_unit");
+	static_assert(same_text(find_unit("hPa", 3).unit->symbol, "Pa")
+		&& find_unit("hPa", 3).decimal == 2, "find_unit/prefix");
+	static_assert(same_text(find_unit("µs", 3).unit->symbol, "s")
+		&& find_unit("µs", 3).decimal == -6, "find_unit/two-byte prefix");
+	static_assert(same_text(find_unit("ft", 2).unit->symbol, "ft")
+		&& find_unit("kft", 3).unit == nullptr && find_unit("zz", 2).unit == nullptr,
+		"find_unit/exact symbols first");
+	static_assert(same_text(find_unit("min", 3).unit->symbol, "min")
+		&& find_unit("min", 3).decimal == 0 && same_text(symbol_of(us::dry::pt), "drypt"),
+		"find_unit/every unit of usunits.hpp");
+	static_assert(same_text(symbol_of(us::fl::gal), "gal")
+		&& same_text(symbol_of(si::N), "N") && symbol_of(3 * si::m) == nullptr,
+		"symbol_of");
+}
+
+constexpr parse::unit_value parse_unit_text(const char* text)
+{
+	const char* last = text;
+	while (*last != 0)
+	{
+		++last;
+	}
+	return parse::parse_unit(text, last);
+}
+
+void static_quantity_parse_tests()
+{
+	using unitscxx::parse_errc;
+	constexpr auto newton = parse_unit_text("kg*m/s^2");
+	static_assert(newton.ec == parse_errc::ok && newton.decimal == 3
+		&& newton.exponents[0] == 1 && newton.exponents[1] == 1
+		&& newton.exponents[2] == -2, "parse_unit");
+	constexpr auto superscripts = parse_unit_text("kg·m/s²");
+	static_assert(superscripts.ec == parse_errc::ok
+		&& superscripts.exponents[2] == -2, "parse_unit/superscripts");
+	static_assert(parse_unit_text("J/kg·K").exponents[4] == -1,
+		"parse_unit/denominator");
+	static_assert(parse_unit_text("ft").decimal == 0
+		&& parse_unit_text("ft").factor != 1, "parse_unit/exact symbols first");
+	static_assert(parse_unit_text("kft").ec == parse_errc::unknown_unit,
+		"parse_unit/US units take no prefix");
+	static_assert(parse_unit_text("m/s/s").ec == parse_errc::invalid_unit,
+		"parse_unit/single denominator");
+}
+
+void static_quantity_format_tests()
+{
+	using namespace unitscxx;
+	static_assert(same_text(unit_string<decltype(si::N)>.c_str(), "m·kg/s²"),
+		"unit_string");
+	static_assert(same_text(unit_string<decltype(si::V), unit_style::ascii>.c_str(),
+		"m^2*kg/s^3*A"), "unit_string/ascii");
+	static_assert(same_text(unit_string<decltype(si::Hz)>.c_str(), "1/s"),
+		"unit_string/denominator only");
+	static_assert(unit_string<decltype(si::m / si::m)>.size() == 0,
+		"unit_string/dimensionless");
+	static_assert(format::canonical_conversion<decltype(si::kg)>().decimal == 0
+		&& format::canonical_conversion<decltype(si::g)>().decimal == -3,
+		"canonical_conversion");
+	constexpr auto N = parse_unit_text(unit_string<decltype(si::N)>.c_str());
+	static_assert(N.ec == unitscxx::parse_errc::ok && N.exponents[2] == -2,
+		"unit_string/parses back");
+}
+
+void static_quantity_column_tests()
+{
+	using namespace unitscxx;
+	using m = std::remove_const_t<decltype(si::m)>;
+	static_assert(is_same<decltype(declval<quantity_column<const m>&>().span()), quantity_span<const m>>::value
+		&& is_same<decltype(declval<quantity_column<m>&>()[0]), m>::value,
+		"quantity_column");
+	static_assert(detail::columns::type_code<long long>::value == column_type::int64
+		&& detail::columns::type_code<unsigned long>::value == column_type::uint64
+		&& detail::columns::type_code<double>::value == column_type::float64,
+		"column types by size");
+}
+
+void static_quantity_wire_tests()
+{
+	using namespace unitscxx;
+	using m = std::remove_const_t<decltype(si::m)>;
+	static_assert(wire_size<m>(3) == 64 && wire_size<const quantity<float, m::dimension>>(1) == 48
+		&& wire_size<const quantity<float, m::dimension>>(3) == 56,
+		"wire_size");
+	static_assert(is_same<decltype(unitscxx::decode(nullptr, 0, declval<quantity_column<const m>&>())), wire_result>::value
+		&& is_same<decltype(unitscxx::decode(nullptr, 0, declval<m&>())), wire_result>::value,
+		"decode");
+}
+
+#ifdef UNITSCXX_TEST_EIGEN
+void static_quantity_eigen_tests()
+{
+	using namespace unitscxx;
+	using m = std::remove_const_t<decltype(si::m)>;
+	using N = std::remove_const_t<decltype(si::N)>;
+	using J = decltype(m() * N());
+	static_assert(is_same<Eigen::NumTraits<m>::Real, m>::value
+		&& is_same<Eigen::NumTraits<m>::Literal, double>::value, "NumTraits");
+	
+	Eigen::Matrix<m, 3, 3> arms = Eigen::Matrix<m, 3, 3>::Constant(m(1));
+	Eigen::Matrix<N, 3, 3> forces = Eigen::Matrix<N, 3, 3>::Constant(N(2));
+	Eigen::Matrix<J, 3, 3> torque = matrix_product(arms, forces);
+	m total = arms.sum() + arms.trace() + arms.maxCoeff() + unitscxx::mean(arms) + unitscxx::norm(arms);
+	decltype(m() * m()) area = unitscxx::squared_norm(arms);
+	Eigen::Matrix<m, 3, 1> path = arms.col(0);
+	Eigen::Matrix<N, 3, 1> push = forces.col(0);
+	J work = unitscxx::dot(path, push) + torque.sum();
+	Eigen::Matrix<m, 3, 3> scaled = arms * 2.0 + arms.cwiseAbs();
+	Eigen::Matrix<double, 3, 3> raw = raw_matrix(scaled);
+	Eigen::Map<Eigen::Matrix<m, 3, 3>> typed = with_units<m>(raw);
+	(void)total; (void)area; (void)work; (void)typed;
+}
+#endif
+
+#ifdef UNITSCXX_TEST_BLAS
+void static_quantity_blas_tests()
+{
+	using namespace unitscxx;
+	using m = std::remove_const_t<decltype(si::m)>;
+	using N = std::remove_const_t<decltype(si::N)>;
+	using kJ = quantity<double, decltype(m() * N())::dimension, std::kilo>;
+	double a[4] = {}, b[4] = {}, c[4] = {};
+	gemm(quantity_span<const m>(a, 4), quantity_span<const N>(b, 4), quantity_span<kJ>(c, 4), 2, 2, 2);
+	axpy(2.0, quantity_span<const m>(a, 4), quantity_span<m>(c, 4));
+	static_assert(is_same<decltype(unitscxx::dot(quantity_span<const m>(a, 4), quantity_span<const N>(b, 4))),
+		decltype(m() * N())>::value, "dot");
+}
+#endif
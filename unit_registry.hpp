@@ -0,0 +1,423 @@
+//
+// unit_registry.hpp
+// units-cxx14
+//
+// Copyright (c) 2016 Félix Cloutier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef UNIT_REGISTRY_HPP
+#define UNIT_REGISTRY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "units.hpp"
+#include "siunits.hpp"
+#include "usunits.hpp"
+
+// The names of the units of siunits.hpp and usunits.hpp. Each unit is bound
+// to its symbol at compile time, and a perfect hash table over the symbols is
+// also built at compile time, so looking up a symbol costs one hash of the
+// text, one probe and one comparison (plus one probe for each prefix that
+// the text starts with).
+
+namespace unitscxx
+{
+	// A unit with a symbol. The factor is the size of the unit in base units
+	// of scale 1 (grams for masses), and the exponents are indexed by
+	// si::units.
+	struct registered_unit
+	{
+		const char* symbol;
+		size_t length;
+		double factor;
+		bool prefixable;
+		signed char exponents[7];
+	};
+
+	// Prefixes are kept as powers of ten rather than folded into the factor,
+	// so that "5 µg" divides by an exact 10^9 and reads as the closest double
+	// to 5e-9 kg.
+	struct unit_prefix
+	{
+		const char* symbol;
+		size_t length;
+		int decimal;
+	};
+
+	struct unit_lookup
+	{
+		const registered_unit* unit; // null if the symbol is unknown
+		int decimal;                 // the power of ten of the prefix
+	};
+}
+
+namespace detail
+{
+namespace registry
+{
+	using unitscxx::registered_unit;
+	using unitscxx::unit_prefix;
+
+	// one exponent for each value of si::units
+	constexpr size_t base_count = 7;
+
+#pragma mark - Units
+	template<typename Dim>
+	constexpr signed char base_exponent(size_t index)
+	{
+		static_assert(Dim::denominator == 1, "units have whole exponents");
+		return static_cast<signed char>(exponent_at(Dim{}, index));
+	}
+
+	template<typename Quantity>
+	constexpr double base_factor(Quantity unit)
+	{
+		using scale = typename Quantity::scale;
+		return static_cast<double>(unit.raw_value()) * scale::num / scale::den;
+	}
+
+	template<size_t N, typename Quantity>
+	constexpr registered_unit named(const char (&symbol)[N], Quantity unit, bool prefixable)
+	{
+		using dim = typename Quantity::dimension;
+		static_assert(std::is_same<typename Quantity::unit_system,
+			unitscxx::si::units>::value, "registered units must be SI-based");
+		return {symbol, N - 1, base_factor(unit), prefixable,
+			{base_exponent<dim>(0), base_exponent<dim>(1), base_exponent<dim>(2),
+			base_exponent<dim>(3), base_exponent<dim>(4), base_exponent<dim>(5),
+			base_exponent<dim>(6)}};
+	}
+
+	namespace si = unitscxx::si;
+	namespace us = unitscxx::us;
+
+	// SI units take prefixes; US units don't, so that "min" is the minim and
+	// not a milli-inch. Dry measures that share a name with a fluid one get
+	// a "dry" in front.
+	constexpr registered_unit units[] = {
+		named("m", si::m, true),
+		named("g", si::g, true),
+		named("s", si::s, true),
+		named("A", si::A, true),
+		named("K", si::K, true),
+		named("mol", si::mol, true),
+		named("cd", si::cd, true),
+		named("Hz", si::Hz, true),
+		named("N", si::N, true),
+		named("Pa", si::Pa, true),
+		named("J", si::J, true),
+		named("W", si::W, true),
+		named("C", si::C, true),
+		named("V", si::V, true),
+		named("F", si::F, true),
+		named("Ohm", si::Ohm, true),
+		named("Ω", si::Ohm, true),
+		named("S", si::S, true),
+		named("Wb", si::Wb, true),
+		named("T", si::T, true),
+		named("H", si::H, true),
+		named("lx", si::lx, true),
+		named("Gy", si::Gy, true),
+		named("kat", si::kat, true),
+		named("L", si::L, true),
+		named("t", si::t, true),
+		named("ha", si::ha, false),
+		named("au", si::au, false),
+		named("deg", si::deg * (si::m / si::m), false),
+
+		named("ft", us::ft, false),
+		named("in", us::in, false),
+		named("pica", us::pica, false),
+		named("p", us::p, false),
+		named("yd", us::yd, false),
+		named("li", us::li, false),
+		named("rd", us::rd, false),
+		named("ch", us::ch, false),
+		named("fur", us::fur, false),
+		named("mi", us::mi, false),
+		named("lea", us::lea, false),
+		named("ftm", us::ftm, false),
+		named("cb", us::cb, false),
+		named("nmi", us::nmi, false),
+		named("acre", us::acre, false),
+		named("section", us::section, false),
+		named("twp", us::twp, false),
+		named("min", us::min, false),
+		named("tsp", us::tsp, false),
+		named("Tbsp", us::Tbsp, false),
+		named("jig", us::jig, false),
+		named("floz", us::fl::oz, false),
+		named("gi", us::gi, false),
+		named("cp", us::cp, false),
+		named("pt", us::fl::pt, false),
+		named("qt", us::fl::qt, false),
+		named("gal", us::fl::gal, false),
+		named("bbl", us::fl::bbl, false),
+		named("hogshead", us::hogshead, false),
+		named("oilbbl", us::oilbbl, false),
+		named("drypt", us::dry::pt, false),
+		named("dryqt", us::dry::qt, false),
+		named("drygal", us::dry::gal, false),
+		named("pk", us::pk, false),
+		named("bu", us::bu, false),
+		named("drybbl", us::dry::bbl, false),
+		named("lb", us::lb, false),
+		named("oz", us::oz, false),
+		named("dr", us::dr, false),
+		named("gr", us::gr, false),
+		named("cwt", us::cwt, false),
+		named("ton", us::ton, false),
+		named("dwt", us::dwt, false),
+		named("ozt", us::ozt, false),
+		named("lbt", us::lbt, false),
+	};
+
+	constexpr size_t unit_count = sizeof(units) / sizeof(units[0]);
+
+	constexpr unit_prefix prefixes[] = {
+		{"Y", 1, 24}, {"Z", 1, 21}, {"E", 1, 18}, {"P", 1, 15},
+		{"T", 1, 12}, {"G", 1, 9}, {"M", 1, 6}, {"k", 1, 3},
+		{"h", 1, 2}, {"da", 2, 1}, {"d", 1, -1}, {"c", 1, -2},
+		{"m", 1, -3}, {"µ", 2, -6}, {"μ", 2, -6}, {"u", 1, -6},
+		{"n", 1, -9}, {"p", 1, -12}, {"f", 1, -15}, {"a", 1, -18},
+		{"z", 1, -21}, {"y", 1, -24},
+	};
+
+	constexpr bool equal(const char* a, const char* b, size_t length)
+	{
+		for (size_t i = 0; i < length; ++i)
+		{
+			if (a[i] != b[i])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+#pragma mark - Perfect hash
+	// FNV-1a over the bytes of a symbol, last byte first: the hash of "Pa"
+	// is an intermediate state of the hash of "hPa", so prefixed symbols are
+	// hashed in a single pass.
+	constexpr uint64_t hash_seed = 14695981039346656037ull;
+
+	constexpr uint64_t hash_step(uint64_t hash, char c)
+	{
+		return (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+	}
+
+	constexpr uint64_t hash(const char* text, size_t length)
+	{
+		uint64_t result = hash_seed;
+		for (size_t i = length; i-- > 0;)
+		{
+			result = hash_step(result, text[i]);
+		}
+		return result;
+	}
+
+	// Spreads a symbol hash over the slots, differently for each seed
+	// (splitmix64 finalizer).
+	constexpr uint64_t mix(uint64_t hash, uint64_t seed)
+	{
+		uint64_t z = hash + (seed + 1) * 0x9e3779b97f4a7c15ull;
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return z ^ (z >> 31);
+	}
+
+	constexpr size_t power_of_two_above(size_t value)
+	{
+		size_t result = 1;
+		while (result < value)
+		{
+			result *= 2;
+		}
+		return result;
+	}
+
+	// Hash and displace: symbols are split into buckets by their hash, and
+	// each bucket gets the first seed that sends all of its symbols to free
+	// slots. Buckets are placed largest first.
+	constexpr size_t bucket_count = power_of_two_above(unit_count / 4 + 1);
+	constexpr size_t slot_count = power_of_two_above(unit_count * 2);
+	constexpr unsigned char empty_slot = 0xff;
+	static_assert(unit_count < empty_slot, "too many units for the symbol table");
+
+	struct perfect_hash
+	{
+		bool complete;
+		uint16_t seeds[bucket_count];
+		unsigned char slots[slot_count];
+	};
+
+	constexpr perfect_hash build_perfect_hash()
+	{
+		perfect_hash table{};
+		uint64_t hashes[unit_count] = {};
+		size_t sizes[bucket_count] = {};
+		bool placed[bucket_count] = {};
+		for (size_t slot = 0; slot < slot_count; ++slot)
+		{
+			table.slots[slot] = empty_slot;
+		}
+		for (size_t i = 0; i < unit_count; ++i)
+		{
+			hashes[i] = hash(units[i].symbol, units[i].length);
+			++sizes[hashes[i] % bucket_count];
+		}
+
+		for (size_t round = 0; round < bucket_count; ++round)
+		{
+			size_t bucket = 0;
+			for (size_t b = 0; b < bucket_count; ++b)
+			{
+				if (!placed[b] && (placed[bucket] || sizes[b] > sizes[bucket]))
+				{
+					bucket = b;
+				}
+			}
+			placed[bucket] = true;
+
+			bool fits = false;
+			for (uint16_t seed = 0; !fits && seed < 0xffff; ++seed)
+			{
+				size_t taken[unit_count] = {};
+				size_t count = 0;
+				fits = true;
+				for (size_t i = 0; fits && i < unit_count; ++i)
+				{
+					if (hashes[i] % bucket_count != bucket)
+					{
+						continue;
+					}
+					size_t slot = mix(hashes[i], seed) % slot_count;
+					if (table.slots[slot] != empty_slot)
+					{
+						fits = false;
+						continue;
+					}
+					table.slots[slot] = static_cast<unsigned char>(i);
+					taken[count++] = slot;
+				}
+				if (fits)
+				{
+					table.seeds[bucket] = seed;
+				}
+				else
+				{
+					for (size_t j = 0; j < count; ++j)
+					{
+						table.slots[taken[j]] = empty_slot;
+					}
+				}
+			}
+			if (!fits)
+			{
+				return table;
+			}
+		}
+		table.complete = true;
+		return table;
+	}
+
+	constexpr perfect_hash table = build_perfect_hash();
+	static_assert(table.complete, "no perfect hash for the unit symbols (is a symbol registered twice?)");
+
+	constexpr const registered_unit* probe(uint64_t hash, const char* text, size_t length)
+	{
+		unsigned char index = table.slots[
+			mix(hash, table.seeds[hash % bucket_count]) % slot_count];
+		if (index == empty_slot)
+		{
+			return nullptr;
+		}
+		const registered_unit& unit = units[index];
+		return unit.length == length && equal(unit.symbol, text, length) ? &unit : nullptr;
+	}
+}
+}
+
+namespace unitscxx
+{
+#pragma mark - Lookup
+	// Finds the unit that a symbol stands for, with an optional SI prefix
+	// ("km", "µs", "hPa"). Exact symbols win over prefixed ones: "ft" is a
+	// foot, not a femtotonne.
+	constexpr unit_lookup find_unit(const char* text, size_t length)
+	{
+		using namespace detail::registry;
+		uint64_t full = hash_seed;
+		uint64_t withoutOne = hash_seed;
+		uint64_t withoutTwo = hash_seed;
+		for (size_t i = length; i-- > 0;)
+		{
+			withoutOne = i == 0 ? full : withoutOne;
+			withoutTwo = i == 1 ? full : withoutTwo;
+			full = hash_step(full, text[i]);
+		}
+
+		if (const registered_unit* unit = probe(full, text, length))
+		{
+			return {unit, 0};
+		}
+		for (const unit_prefix& prefix : prefixes)
+		{
+			if (prefix.length < length && equal(prefix.symbol, text, prefix.length))
+			{
+				const registered_unit* unit = probe(
+					prefix.length == 1 ? withoutOne : withoutTwo,
+					text + prefix.length, length - prefix.length);
+				if (unit != nullptr && unit->prefixable)
+				{
+					return {unit, prefix.decimal};
+				}
+			}
+		}
+		return {nullptr, 0};
+	}
+
+	// The symbol of a registered unit, or null: symbol_of(us::ft) is "ft".
+	// Units are matched by value, so the first of several names for the
+	// same unit wins ("Ohm" rather than "Ω").
+	template<typename NT, typename D, typename S>
+	constexpr const char* symbol_of(quantity<NT, D, S> unit)
+	{
+		using namespace detail::registry;
+		for (const registered_unit& candidate : units)
+		{
+			bool same = candidate.factor == base_factor(unit);
+			for (size_t i = 0; i < base_count; ++i)
+			{
+				same = same && candidate.exponents[i] == base_exponent<D>(i);
+			}
+			if (same)
+			{
+				return candidate.symbol;
+			}
+		}
+		return nullptr;
+	}
+}
+
+#endif
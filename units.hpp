@@ -33,6 +33,7 @@
 #endif
 
 #include <cstddef>
+#include <cstdint>
 #include <ratio>
 #include <type_traits>
 #include <utility>
@@ -227,26 +228,375 @@ namespace detail
 
 	template<typename Sequence>
 	using sorted = typename sorted_<Sequence>::type;
+
+#pragma mark - Dimension type
+	// A dimension stores one exponent per base unit, indexed by the value of
+	// the unit enum. Exponents are fractions over a common denominator so that
+	// roots have a type: sqrt of m² is m, and sqrt of m is m^(1/2). Trailing
+	// zero exponents are always trimmed and fractions kept in lowest terms, so
+	// that each dimension has exactly one spelling and can be compared with
+	// is_same.
+
+	template<typename UnitType, int Denominator, int... Numerators>
+	struct rational_dimension
+	{
+		using value_type = UnitType;
+		static constexpr size_t size = sizeof...(Numerators);
+		static constexpr int denominator = Denominator;
+	};
+
+	// Whole exponents, which is what nearly every dimension has.
+	template<typename UnitType, int... Exponents>
+	using dimension = rational_dimension<UnitType, 1, Exponents...>;
+
+	// The numerator of the exponent of one base unit, over the denominator of
+	// the dimension.
+	template<typename UnitType, int Den, int... Es>
+	constexpr int exponent_at(rational_dimension<UnitType, Den, Es...>, size_t index)
+	{
+		int exponents[] = {Es..., 0};
+		return index < sizeof...(Es) ? exponents[index] : 0;
+	}
+
+	constexpr intmax_t gcd(intmax_t a, intmax_t b)
+	{
+		return b == 0 ? (a < 0 ? -a : a) : gcd(b, a % b);
+	}
+
+#pragma mark - Multiply, divide and raise dimensions
+	// Unreduced exponents, numerator(i) / denominator, from which
+	// normalize_ builds the dimension.
+
+	template<typename Dim1, typename Dim2, int Sign>
+	struct exponent_sum
+	{
+		static_assert(std::is_same<typename Dim1::value_type,
+			typename Dim2::value_type>::value,
+			"quantity with incompatible unit systems");
+
+		using value_type = typename Dim1::value_type;
+		static constexpr int denominator = static_cast<int>(
+			Dim1::denominator / gcd(Dim1::denominator, Dim2::denominator) * Dim2::denominator);
+		static constexpr size_t size = Dim1::size > Dim2::size ? Dim1::size : Dim2::size;
+
+		static constexpr int numerator(size_t index)
+		{
+			return exponent_at(Dim1{}, index) * (denominator / Dim1::denominator)
+				+ Sign * exponent_at(Dim2{}, index) * (denominator / Dim2::denominator);
+		}
+	};
+
+	template<typename Dim, int Num, int Den>
+	struct exponent_power
+	{
+		static_assert(Den > 0, "zero denominator in a rational exponent");
+
+		using value_type = typename Dim::value_type;
+		static constexpr int denominator = Dim::denominator * Den;
+		static constexpr size_t size = Dim::size;
+
+		static constexpr int numerator(size_t index)
+		{
+			return exponent_at(Dim{}, index) * Num;
+		}
+	};
+
+	template<typename Exponents>
+	constexpr int common_divisor()
+	{
+		intmax_t divisor = Exponents::denominator;
+		for (size_t i = 0; i < Exponents::size; ++i)
+		{
+			divisor = gcd(divisor, Exponents::numerator(i));
+		}
+		return static_cast<int>(divisor);
+	}
+
+	template<typename Exponents>
+	constexpr size_t trimmed_size()
+	{
+		size_t size = Exponents::size;
+		while (size > 0 && Exponents::numerator(size - 1) == 0)
+		{
+			--size;
+		}
+		return size;
+	}
+
+	template<typename Exponents, typename Indices =
+		std::make_index_sequence<trimmed_size<Exponents>()>>
+	struct normalize_;
+
+	template<typename Exponents, size_t... Is>
+	struct normalize_<Exponents, std::index_sequence<Is...>>
+	{
+		static constexpr int divisor = common_divisor<Exponents>();
+
+		using type = rational_dimension<typename Exponents::value_type,
+			Exponents::denominator / divisor,
+			(Exponents::numerator(Is) / divisor)...>;
+	};
+
+	template<typename Dim1, typename Dim2>
+	using dimension_product = typename normalize_<exponent_sum<Dim1, Dim2, 1>>::type;
+
+	template<typename Dim1, typename Dim2>
+	using dimension_quotient = typename normalize_<exponent_sum<Dim1, Dim2, -1>>::type;
+
+	template<typename Dim>
+	using dimension_inverse = dimension_quotient<
+		dimension<typename Dim::value_type>, Dim>;
+
+	// Every exponent multiplied by Num/Den.
+	template<typename Dim, int Num, int Den = 1>
+	using dimension_power = typename normalize_<exponent_power<Dim,
+		(Den < 0 ? -Num : Num), (Den < 0 ? -Den : Den)>>::type;
+
+#pragma mark - Dimension from a sequence of base units
+	template<typename UnitType, UnitType... Us>
+	constexpr size_t base_unit_count(sequence<UnitType, Us...>)
+	{
+		size_t units[] = {static_cast<size_t>(Us)..., 0};
+		size_t count = 0;
+		for (size_t i = 0; i < sizeof...(Us); ++i)
+		{
+			count = units[i] + 1 > count ? units[i] + 1 : count;
+		}
+		return count;
+	}
+
+	template<typename UnitType, UnitType... Us>
+	constexpr int base_unit_exponent(sequence<UnitType, Us...>, size_t index)
+	{
+		size_t units[] = {static_cast<size_t>(Us)..., 0};
+		int exponent = 0;
+		for (size_t i = 0; i < sizeof...(Us); ++i)
+		{
+			exponent += units[i] == index;
+		}
+		return exponent;
+	}
+
+	template<typename Seq, typename Indices =
+		std::make_index_sequence<base_unit_count(Seq{})>>
+	struct sequence_dimension_;
+
+	template<typename Seq, size_t... Is>
+	struct sequence_dimension_<Seq, std::index_sequence<Is...>>
+	{
+		using type = dimension<typename Seq::value_type,
+			base_unit_exponent(Seq{}, Is)...>;
+	};
+
+	template<typename Seq>
+	using sequence_dimension = typename sequence_dimension_<Seq>::type;
+
+	template<typename T>
+	struct is_sequence : std::false_type
+	{
+	};
+
+	template<typename UnitType, UnitType... Us>
+	struct is_sequence<sequence<UnitType, Us...>> : std::true_type
+	{
+	};
+
+#pragma mark - Sequence of base units from a dimension
+	// Expands the positive (Sign = 1) or negative (Sign = -1) exponents of a
+	// dimension back into a sorted sequence with repeated base units.
+	// Fractional exponents have no such form: their sequences are void.
+
+	template<typename UnitType, int Den, int... Es>
+	constexpr size_t factor_count(rational_dimension<UnitType, Den, Es...>, int sign)
+	{
+		int exponents[] = {Es..., 0};
+		size_t count = 0;
+		for (size_t i = 0; i < sizeof...(Es) && Den == 1; ++i)
+		{
+			count += sign * exponents[i] > 0 ? sign * exponents[i] : 0;
+		}
+		return count;
+	}
+
+	template<typename UnitType, int Den, int... Es>
+	constexpr size_t factor_at(rational_dimension<UnitType, Den, Es...>, int sign, size_t n)
+	{
+		int exponents[] = {Es..., 0};
+		for (size_t i = 0; i < sizeof...(Es); ++i)
+		{
+			size_t count = sign * exponents[i] > 0 ? sign * exponents[i] : 0;
+			if (n < count)
+			{
+				return i;
+			}
+			n -= count;
+		}
+		return sizeof...(Es);
+	}
+
+	template<typename Dim, int Sign, typename Indices =
+		std::make_index_sequence<factor_count(Dim{}, Sign)>>
+	struct factors_;
+
+	template<typename Dim, int Sign, size_t... Is>
+	struct factors_<Dim, Sign, std::index_sequence<Is...>>
+	{
+		using unit_type = typename Dim::value_type;
+		using type = std::conditional_t<Dim::denominator == 1,
+			sequence<unit_type, static_cast<unit_type>(factor_at(Dim{}, Sign, Is))...>,
+			void>;
+	};
+
+	template<typename Dim>
+	using numerator_factors = typename factors_<Dim, 1>::type;
+
+	template<typename Dim>
+	using denominator_factors = typename factors_<Dim, -1>::type;
+
+#pragma mark - Scales
+	// Scales are std::ratio multipliers that stay in the type, so that
+	// prefixed units (kilograms, millimeters) keep their raw value exact and
+	// only pay for a conversion when they meet a different scale.
+
+	// The largest scale that both scales are integer multiples of (like
+	// std::common_type on durations).
+	template<typename Scale1, typename Scale2>
+	using common_scale = std::ratio<
+		gcd(Scale1::num, Scale2::num),
+		Scale1::den / gcd(Scale1::den, Scale2::den) * Scale2::den>;
+
+	// Whether a * b fits in an intmax_t, for the positive terms of scales.
+	constexpr bool product_fits(intmax_t a, intmax_t b)
+	{
+		return a == 0 || b <= INTMAX_MAX / a;
+	}
+
+	template<typename Scale1, typename Scale2>
+	constexpr bool scale_product_fits()
+	{
+		return product_fits(Scale1::num / gcd(Scale1::num, Scale2::den), Scale2::num / gcd(Scale2::num, Scale1::den))
+			&& product_fits(Scale1::den / gcd(Scale2::num, Scale1::den), Scale2::den / gcd(Scale1::num, Scale2::den));
+	}
+
+	// Scale1 * Scale2, when std::ratio can represent it. Otherwise (seven
+	// kilograms multiplied together are 10^21 grams) the result has scale 1
+	// and fold() multiplies both scales into the value, in floating point.
+	template<typename Scale1, typename Scale2, bool Fits = scale_product_fits<Scale1, Scale2>()>
+	struct scale_product
+	{
+		static constexpr bool fits = true;
+		using type = std::ratio_multiply<Scale1, Scale2>;
+
+		template<typename T>
+		using value_type = T;
+
+		template<typename T>
+		static constexpr T fold(T value)
+		{
+			return value;
+		}
+	};
+
+	template<typename Scale1, typename Scale2>
+	struct scale_product<Scale1, Scale2, false>
+	{
+		static constexpr bool fits = false;
+		using type = std::ratio<1>;
+
+		template<typename T>
+		using value_type = std::conditional_t<std::is_floating_point<T>::value, T, double>;
+
+		template<typename T>
+		static constexpr value_type<T> fold(T value)
+		{
+			using FT = value_type<T>;
+			return FT(value) * (FT(Scale1::num) / FT(Scale1::den)) * (FT(Scale2::num) / FT(Scale2::den));
+		}
+	};
+
+	template<typename Scale1, typename Scale2>
+	using scale_quotient = scale_product<Scale1, std::ratio<Scale2::den, Scale2::num>>;
+
+	// Converts a raw value from one scale to another. The factor is folded at
+	// compile time: floating-point values take a single multiplication,
+	// integers a multiplication and/or a division by integer constants.
+	template<typename To, typename FromScale, typename ToScale, typename NT>
+	constexpr To rescale(NT value)
+	{
+		using quotient = scale_quotient<FromScale, ToScale>;
+		using factor = typename quotient::type;
+		using CT = std::common_type_t<To, NT, intmax_t>;
+		if (!quotient::fits)
+		{
+			return static_cast<To>(quotient::fold(value));
+		}
+		if (factor::num == 1 && factor::den == 1)
+		{
+			return static_cast<To>(value);
+		}
+		if (std::is_floating_point<CT>::value)
+		{
+			constexpr CT multiplier = static_cast<CT>(factor::num) / static_cast<CT>(factor::den);
+			return static_cast<To>(static_cast<CT>(value) * multiplier);
+		}
+		if (factor::den == 1)
+		{
+			return static_cast<To>(static_cast<CT>(value) * static_cast<CT>(factor::num));
+		}
+		if (factor::num == 1)
+		{
+			return static_cast<To>(static_cast<CT>(value) / static_cast<CT>(factor::den));
+		}
+		return static_cast<To>(static_cast<CT>(value) * static_cast<CT>(factor::num)
+			/ static_cast<CT>(factor::den));
+	}
+
+	// Conversions that can't lose information are implicit: to a
+	// floating-point type, or between integer types when the source scale is
+	// a whole multiple of the target scale.
+	template<typename ToNT, typename ToScale, typename FromNT, typename FromScale>
+	using is_lossless_conversion = std::integral_constant<bool,
+		std::is_floating_point<ToNT>::value
+		|| (!std::is_floating_point<FromNT>::value
+			&& scale_quotient<FromScale, ToScale>::fits
+			&& scale_quotient<FromScale, ToScale>::type::den == 1)>;
 }
 
 namespace unitscxx
 {
-	template<typename NumericType, typename Numerator, typename Denominator>
+	// Selects constructors that leave the numeric value uninitialized, for
+	// storage that is about to be overwritten anyway (see quantity_buffer.hpp).
+	struct for_overwrite_t
+	{
+		explicit for_overwrite_t() = default;
+	};
+
+	constexpr for_overwrite_t for_overwrite{};
+
+	template<typename NumericType, typename Dimension, typename Scale = std::ratio<1>>
 	class quantity
 	{
+		static_assert(!detail::is_sequence<Dimension>::value,
+			"quantity<NT, Numerator, Denominator> is now sequence_quantity<NT, Numerator, Denominator>");
+
 		NumericType rawValue;
 
+		template<typename NT, typename S>
+		using common_quantity = quantity<
+			std::common_type_t<NumericType, NT>,
+			Dimension,
+			detail::common_scale<Scale, S>>;
+
 	public:
 		using var = quantity;
-		using numerator = Numerator;
-		using denominator = Denominator;
-		using unit_system = typename numerator::value_type;
-
-		static_assert(std::is_same<unit_system,
-			typename denominator::value_type>::value,
-			"quantity with incompatible unit systems");
-
-		template<typename NT, typename N, typename D>
+		using numeric_type = NumericType;
+		using dimension = Dimension;
+		using scale = Scale;
+		using numerator = detail::numerator_factors<Dimension>;
+		using denominator = detail::denominator_factors<Dimension>;
+		using unit_system = typename Dimension::value_type;
+
+		template<typename NT, typename D, typename S>
 		friend class quantity;
 
 		constexpr quantity() : rawValue{} {};
@@ -255,35 +605,66 @@ namespace unitscxx
 		quantity& operator=(const quantity&) = default;
 		quantity& operator=(quantity&&) = default;
 
+		// The value is indeterminate until something is assigned to it.
+		explicit quantity(for_overwrite_t)
+		{
+		}
+
 		explicit constexpr quantity(NumericType val)
 			: rawValue(val)
 		{
 		}
 
-		template<typename NT, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
-		auto& operator+=(quantity<NT, Numerator, Denominator> that)
+		// Same units at another scale or numeric type. Implicit when nothing
+		// can be lost, explicit otherwise (like std::chrono::duration).
+		template<typename NT, typename S, typename = std::enable_if_t<
+			detail::is_lossless_conversion<NumericType, Scale, NT, S>::value>>
+		constexpr quantity(quantity<NT, Dimension, S> that)
+			: rawValue(detail::rescale<NumericType, S, Scale>(that.rawValue))
+		{
+		}
+
+		template<typename NT, typename S, typename = std::enable_if_t<
+			!detail::is_lossless_conversion<NumericType, Scale, NT, S>::value>,
+			typename = void>
+		explicit constexpr quantity(quantity<NT, Dimension, S> that)
+			: rawValue(detail::rescale<NumericType, S, Scale>(that.rawValue))
+		{
+		}
+
+		// The numeric part of the quantity, without its units, counted in
+		// multiples of Scale. Prefer dividing by a unit to get a number back;
+		// this is for code that needs to hand the storage to routines that
+		// don't know about units.
+		UNITS_ATTR_NODISCARD constexpr NumericType raw_value() const
+		{
+			return rawValue;
+		}
+
+		template<typename NT, typename S, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
+		auto& operator+=(quantity<NT, Dimension, S> that)
 		{
 			return *this = *this + that;
 		}
 
-		template<typename NT, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
-		auto& operator-=(quantity<NT, Numerator, Denominator> that)
+		template<typename NT, typename S, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
+		auto& operator-=(quantity<NT, Dimension, S> that)
 		{
 			return *this = *this - that;
 		}
 
-		template<typename NT, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
-		UNITS_ATTR_NODISCARD constexpr auto operator+(quantity<NT, Numerator, Denominator> that) const
+		template<typename NT, typename S, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
+		UNITS_ATTR_NODISCARD constexpr auto operator+(quantity<NT, Dimension, S> that) const
 		{
-			using ResNT = decltype(rawValue + that.rawValue);
-			return quantity<ResNT, Numerator, Denominator>(rawValue + that.rawValue);
+			using result_quantity = common_quantity<NT, S>;
+			return result_quantity(result_quantity(*this).rawValue + result_quantity(that).rawValue);
 		}
 
-		template<typename NT, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
-		UNITS_ATTR_NODISCARD constexpr auto operator-(quantity<NT, Numerator, Denominator> that) const
+		template<typename NT, typename S, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
+		UNITS_ATTR_NODISCARD constexpr auto operator-(quantity<NT, Dimension, S> that) const
 		{
-			using ResNT = decltype(rawValue - that.rawValue);
-			return quantity<ResNT, Numerator, Denominator>(rawValue - that.rawValue);
+			using result_quantity = common_quantity<NT, S>;
+			return result_quantity(result_quantity(*this).rawValue - result_quantity(that).rawValue);
 		}
 
 		UNITS_ATTR_NODISCARD constexpr quantity operator+() const
@@ -296,20 +677,20 @@ namespace unitscxx
 			return quantity(-rawValue);
 		}
 
-		template<typename NT, typename N = Numerator, typename D = Denominator, typename =
-			std::enable_if_t<N::size == 0 && D::size == 0 && std::is_arithmetic<NT>::value>>
+		template<typename NT, typename D = Dimension, typename =
+			std::enable_if_t<D::size == 0 && std::is_arithmetic<NT>::value>>
 		UNITS_ATTR_NODISCARD constexpr auto operator+(NT that) const
 		{
 			using ResNT = decltype(rawValue + that);
-			return quantity<ResNT, N, D>(rawValue + that);
+			return quantity<ResNT, D>(static_cast<NumericType>(*this) + that);
 		}
 
-		template<typename NT, typename N = Numerator, typename D = Denominator, typename =
-			std::enable_if_t<N::size == 0 && D::size == 0 && std::is_arithmetic<NT>::value>>
+		template<typename NT, typename D = Dimension, typename =
+			std::enable_if_t<D::size == 0 && std::is_arithmetic<NT>::value>>
 		UNITS_ATTR_NODISCARD constexpr auto operator-(NT that) const
 		{
 			using ResNT = decltype(rawValue - that);
-			return quantity<ResNT, N, D>(rawValue - that);
+			return quantity<ResNT, D>(static_cast<NumericType>(*this) - that);
 		}
 
 		template<typename NT, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
@@ -330,207 +711,207 @@ namespace unitscxx
 		UNITS_ATTR_NODISCARD constexpr auto operator*(NT that) const
 		{
 			using ResNT = decltype(rawValue * that);
-			return quantity<ResNT, Numerator, Denominator>(rawValue * that);
+			return quantity<ResNT, Dimension, Scale>(rawValue * that);
 		}
 
-		template<typename NT, typename N, typename D>
-		UNITS_ATTR_NODISCARD constexpr auto operator*(quantity<NT, N, D> that) const
+		// Scales multiply along with dimensions: no conversion is needed,
+		// unless the product of the scales overflows std::ratio.
+		template<typename NT, typename D, typename S>
+		UNITS_ATTR_NODISCARD constexpr auto operator*(quantity<NT, D, S> that) const
 		{
-			using combined_numerator   = detail::combine<numerator, N>;
-			using combined_denominator = detail::combine<denominator, D>;
-
-			using unsorted_numerator   = detail::remove_intersection<
-				combined_numerator,
-				combined_denominator>;
-
-			using unsorted_denominator = detail::remove_intersection<
-				combined_denominator,
-				combined_numerator>;
-
-			using result_numerator   = detail::sorted<unsorted_numerator>;
-			using result_denominator = detail::sorted<unsorted_denominator>;
-
+			using scale = detail::scale_product<Scale, S>;
 			using result_quantity = quantity<
-				decltype(rawValue * that.rawValue),
-				result_numerator,
-				result_denominator>;
+				typename scale::template value_type<decltype(rawValue * that.rawValue)>,
+				detail::dimension_product<Dimension, D>,
+				typename scale::type>;
 
-			return result_quantity(rawValue * that.rawValue);
+			return result_quantity(scale::fold(rawValue * that.rawValue));
 		}
 
 		template<typename NT, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
 		UNITS_ATTR_NODISCARD constexpr auto operator/(NT that) const
 		{
 			using ResNT = decltype(rawValue / that);
-			return quantity<ResNT, Numerator, Denominator>(rawValue / that);
+			return quantity<ResNT, Dimension, Scale>(rawValue / that);
 		}
 
-		template<typename NT, typename N, typename D>
-		UNITS_ATTR_NODISCARD constexpr auto operator/(quantity<NT, N, D> that) const
+		template<typename NT, typename D, typename S>
+		UNITS_ATTR_NODISCARD constexpr auto operator/(quantity<NT, D, S> that) const
 		{
-			// flip fraction rows around for division
-			using combined_numerator   = detail::combine<numerator, D>;
-			using combined_denominator = detail::combine<denominator, N>;
-
-			using unsorted_numerator   = detail::remove_intersection<
-				combined_numerator,
-				combined_denominator>;
-
-			using unsorted_denominator = detail::remove_intersection<
-				combined_denominator,
-				combined_numerator>;
-
-			using result_numerator   = detail::sorted<unsorted_numerator>;
-			using result_denominator = detail::sorted<unsorted_denominator>;
-
+			using scale = detail::scale_quotient<Scale, S>;
 			using result_quantity = quantity<
-				decltype(rawValue / that.rawValue),
-				result_numerator,
-				result_denominator>;
+				typename scale::template value_type<decltype(rawValue / that.rawValue)>,
+				detail::dimension_quotient<Dimension, D>,
+				typename scale::type>;
 
-			return result_quantity(rawValue / that.rawValue);
+			return result_quantity(scale::fold(rawValue / that.rawValue));
 		}
 
+		// std::ratio factors only change the scale: the raw value is kept.
 		template<intmax_t N, intmax_t D>
 		UNITS_ATTR_NODISCARD constexpr auto operator*(std::ratio<N, D>) const
 		{
-			return (*this) * N / D;
+			using scale = detail::scale_product<Scale, std::ratio<N, D>>;
+			return quantity<typename scale::template value_type<NumericType>, Dimension,
+				typename scale::type>(scale::fold(rawValue));
 		}
 
 		template<intmax_t N, intmax_t D>
 		UNITS_ATTR_NODISCARD constexpr auto operator/(std::ratio<N, D>) const
 		{
-			return (*this) / N * D;
+			using scale = detail::scale_quotient<Scale, std::ratio<N, D>>;
+			return quantity<typename scale::template value_type<NumericType>, Dimension,
+				typename scale::type>(scale::fold(rawValue));
 		}
 
-		template<typename NT, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
-		UNITS_ATTR_NODISCARD constexpr bool operator==(quantity<NT, Numerator, Denominator> that) const
+		template<typename NT, typename S, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
+		UNITS_ATTR_NODISCARD constexpr bool operator==(quantity<NT, Dimension, S> that) const
 		{
-			return rawValue == that.rawValue;
+			using common = common_quantity<NT, S>;
+			return common(*this).rawValue == common(that).rawValue;
 		}
 
-		template<typename NT, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
-		UNITS_ATTR_NODISCARD constexpr bool operator!=(quantity<NT, Numerator, Denominator> that) const
+		template<typename NT, typename S, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
+		UNITS_ATTR_NODISCARD constexpr bool operator!=(quantity<NT, Dimension, S> that) const
 		{
-			return rawValue != that.rawValue;
+			using common = common_quantity<NT, S>;
+			return common(*this).rawValue != common(that).rawValue;
 		}
 
-		template<typename NT, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
-		UNITS_ATTR_NODISCARD constexpr bool operator<(quantity<NT, Numerator, Denominator> that) const
+		template<typename NT, typename S, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
+		UNITS_ATTR_NODISCARD constexpr bool operator<(quantity<NT, Dimension, S> that) const
 		{
-			return rawValue < that.rawValue;
+			using common = common_quantity<NT, S>;
+			return common(*this).rawValue < common(that).rawValue;
 		}
 
-		template<typename NT, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
-		UNITS_ATTR_NODISCARD constexpr bool operator>(quantity<NT, Numerator, Denominator> that) const
+		template<typename NT, typename S, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
+		UNITS_ATTR_NODISCARD constexpr bool operator>(quantity<NT, Dimension, S> that) const
 		{
-			return rawValue > that.rawValue;
+			using common = common_quantity<NT, S>;
+			return common(*this).rawValue > common(that).rawValue;
 		}
 
-		template<typename NT, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
-		UNITS_ATTR_NODISCARD constexpr bool operator<=(quantity<NT, Numerator, Denominator> that) const
+		template<typename NT, typename S, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
+		UNITS_ATTR_NODISCARD constexpr bool operator<=(quantity<NT, Dimension, S> that) const
 		{
-			return rawValue <= that.rawValue;
+			using common = common_quantity<NT, S>;
+			return common(*this).rawValue <= common(that).rawValue;
 		}
 
-		template<typename NT, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
-		UNITS_ATTR_NODISCARD constexpr bool operator>=(quantity<NT, Numerator, Denominator> that) const
+		template<typename NT, typename S, typename = std::enable_if_t<std::is_arithmetic<NT>::value>>
+		UNITS_ATTR_NODISCARD constexpr bool operator>=(quantity<NT, Dimension, S> that) const
 		{
-			return rawValue >= that.rawValue;
+			using common = common_quantity<NT, S>;
+			return common(*this).rawValue >= common(that).rawValue;
 		}
 
-		template<typename N = Numerator, typename D = Denominator, typename =
-			std::enable_if_t<N::size == 0 && D::size == 0>>
+		template<typename D = Dimension, typename =
+			std::enable_if_t<D::size == 0>>
 		UNITS_ATTR_NODISCARD constexpr operator NumericType() const
 		{
-			return rawValue;
+			return detail::rescale<NumericType, Scale, std::ratio<1>>(rawValue);
 		}
 	};
 
-	template<typename MulType, typename NT, typename N, typename D, typename =
+	template<typename MulType, typename NT, typename D, typename S, typename =
 		std::enable_if_t<std::is_arithmetic<MulType>::value>>
-	UNITS_ATTR_NODISCARD constexpr quantity<NT, N, D> operator*(MulType left, quantity<NT, N, D> right)
+	UNITS_ATTR_NODISCARD constexpr quantity<NT, D, S> operator*(MulType left, quantity<NT, D, S> right)
 	{
-		using unit_system = typename N::value_type;
-		using unitless_quantity = quantity<NT,
-			detail::sequence<unit_system>,
-			detail::sequence<unit_system>>;
+		using unit_system = typename D::value_type;
+		using unitless_quantity = quantity<NT, detail::dimension<unit_system>>;
 		return unitless_quantity(left) * right;
 	}
 
-	template<typename MulType, typename NT, typename N, typename D, typename =
+	template<typename MulType, typename NT, typename D, typename S, typename =
 		std::enable_if_t<std::is_arithmetic<MulType>::value>>
-	UNITS_ATTR_NODISCARD constexpr quantity<NT, D, N> operator/(MulType left, quantity<NT, N, D> right)
+	UNITS_ATTR_NODISCARD constexpr auto operator/(MulType left, quantity<NT, D, S> right)
 	{
-		using unit_system = typename N::value_type;
-		using unitless_quantity = quantity<NT,
-			detail::sequence<unit_system>,
-			detail::sequence<unit_system>>;
+		using unit_system = typename D::value_type;
+		using unitless_quantity = quantity<NT, detail::dimension<unit_system>>;
 		return unitless_quantity(left) / right;
 	}
 
-	template<intmax_t RN, intmax_t RD, typename QNT, typename QN, typename QD>
-	UNITS_ATTR_NODISCARD constexpr quantity<QNT, QN, QD> operator*(
-		std::ratio<RN, RD> left, quantity<QNT, QN, QD> right)
+	template<intmax_t RN, intmax_t RD, typename QNT, typename QD, typename QS>
+	UNITS_ATTR_NODISCARD constexpr auto operator*(
+		std::ratio<RN, RD> left, quantity<QNT, QD, QS> right)
 	{
 		return right * left;
 	}
 
-	template<intmax_t RN, intmax_t RD, typename QNT, typename QN, typename QD>
-	UNITS_ATTR_NODISCARD constexpr quantity<QNT, QD, QN> operator/(
-		std::ratio<RN, RD> left, quantity<QNT, QN, QD> right)
+	template<intmax_t RN, intmax_t RD, typename QNT, typename QD, typename QS>
+	UNITS_ATTR_NODISCARD constexpr auto operator/(
+		std::ratio<RN, RD> left, quantity<QNT, QD, QS> right)
 	{
 		return (1 / right) * left;
 	}
 
-	template<typename RNT, typename NT, typename N, typename D, typename =
-		std::enable_if_t<std::is_arithmetic<RNT>::value && N::size == 0 && D::size == 0>>
-	UNITS_ATTR_NODISCARD constexpr auto operator+(RNT lhs, quantity<NT, N, D> rhs)
+	template<typename RNT, typename NT, typename D, typename S, typename =
+		std::enable_if_t<std::is_arithmetic<RNT>::value && D::size == 0>>
+	UNITS_ATTR_NODISCARD constexpr auto operator+(RNT lhs, quantity<NT, D, S> rhs)
 	{
 		using ResNT = decltype(lhs + static_cast<NT>(rhs));
-		return quantity<ResNT, N, D>(lhs + static_cast<NT>(rhs));
+		return quantity<ResNT, D>(lhs + static_cast<NT>(rhs));
 	}
 
-	template<typename RNT, typename NT, typename N, typename D, typename =
-		std::enable_if_t<std::is_arithmetic<RNT>::value && N::size == 0 && D::size == 0>>
-	UNITS_ATTR_NODISCARD constexpr auto operator-(RNT lhs, quantity<NT, N, D> rhs)
+	template<typename RNT, typename NT, typename D, typename S, typename =
+		std::enable_if_t<std::is_arithmetic<RNT>::value && D::size == 0>>
+	UNITS_ATTR_NODISCARD constexpr auto operator-(RNT lhs, quantity<NT, D, S> rhs)
 	{
 		using ResNT = decltype(lhs - static_cast<NT>(rhs));
-		return quantity<ResNT, N, D>(lhs - static_cast<NT>(rhs));
+		return quantity<ResNT, D>(lhs - static_cast<NT>(rhs));
 	}
 
-	template<typename RNT, typename NT, typename N, typename D, typename =
-		std::enable_if_t<std::is_arithmetic<RNT>::value && N::size == 0 && D::size == 0>>
-	constexpr auto operator+=(RNT lhs, quantity<NT, N, D> rhs)
+	template<typename RNT, typename NT, typename D, typename S, typename =
+		std::enable_if_t<std::is_arithmetic<RNT>::value && D::size == 0>>
+	constexpr auto operator+=(RNT lhs, quantity<NT, D, S> rhs)
 	{
 		lhs += static_cast<NT>(rhs);
 	}
 
-	template<typename RNT, typename NT, typename N, typename D, typename =
-		std::enable_if_t<std::is_arithmetic<RNT>::value && N::size == 0 && D::size == 0>>
-	constexpr auto operator-=(RNT lhs, quantity<NT, N, D> rhs)
+	template<typename RNT, typename NT, typename D, typename S, typename =
+		std::enable_if_t<std::is_arithmetic<RNT>::value && D::size == 0>>
+	constexpr auto operator-=(RNT lhs, quantity<NT, D, S> rhs)
 	{
 		lhs -= static_cast<NT>(rhs);
 	}
 
-	template<typename RNT, typename NT, typename N, typename D, typename =
-		std::enable_if_t<std::is_arithmetic<RNT>::value && N::size == 0 && D::size == 0>>
-	constexpr auto operator*=(RNT lhs, quantity<NT, N, D> rhs)
+	template<typename RNT, typename NT, typename D, typename S, typename =
+		std::enable_if_t<std::is_arithmetic<RNT>::value && D::size == 0>>
+	constexpr auto operator*=(RNT lhs, quantity<NT, D, S> rhs)
 	{
 		lhs *= static_cast<NT>(rhs);
 	}
 
-	template<typename RNT, typename NT, typename N, typename D, typename =
-		std::enable_if_t<std::is_arithmetic<RNT>::value && N::size == 0 && D::size == 0>>
-	constexpr auto operator/=(RNT lhs, quantity<NT, N, D> rhs)
+	template<typename RNT, typename NT, typename D, typename S, typename =
+		std::enable_if_t<std::is_arithmetic<RNT>::value && D::size == 0>>
+	constexpr auto operator/=(RNT lhs, quantity<NT, D, S> rhs)
 	{
 		lhs /= static_cast<NT>(rhs);
 	}
 
+	// A quantity is nothing but its numeric value: a buffer of numbers can be
+	// viewed as a buffer of quantities and back without copying.
+	template<typename Quantity>
+	struct has_numeric_layout : std::integral_constant<bool,
+		std::is_standard_layout<Quantity>::value
+		&& std::is_trivially_copyable<Quantity>::value
+		&& sizeof(Quantity) == sizeof(typename Quantity::numeric_type)
+		&& alignof(Quantity) == alignof(typename Quantity::numeric_type)>
+	{
+	};
+
+	constexpr size_t dynamic_extent = static_cast<size_t>(-1);
+
 	template<typename NumericType, typename UnitType, UnitType... U>
 	using unit_base = quantity<NumericType,
-		detail::sequence<UnitType, U...>,
-		detail::sequence<UnitType>>;
+		detail::sequence_dimension<detail::sequence<UnitType, U...>>>;
+
+	// The quantity that quantity<NT, Numerator, Denominator> used to name,
+	// from sequences of base units, for code written against that form.
+	template<typename NumericType, typename Numerator, typename Denominator>
+	using sequence_quantity = quantity<NumericType, detail::dimension_quotient<
+		detail::sequence_dimension<Numerator>, detail::sequence_dimension<Denominator>>>;
 }
 
 #endif
@@ -131,6 +131,11 @@ namespace us
 	{
 		return ((value - si::Czero) / si::K) * 1.8 + 32;
 	}
+	
+	// Fahrenheit degrees are 5/9 K, counted from 0 °F = 45967/180 K.
+	using fahrenheit_degrees = quantity<UNITSCXX_SI_ARITHMETIC_TYPE,
+		decltype(si::K)::dimension, std::ratio<5, 9>>;
+	using fahrenheit_point = quantity_point<fahrenheit_degrees, std::ratio<45967, 180>>;
 }
 }
 